@@ -0,0 +1,564 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup stamping
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsstamper/stamper/XmBathymetryStore.h>
+
+// 3. Standard library headers
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/XmConst.h>
+#include <xmscore/misc/XmError.h>
+#include <xmsgrid/geometry/geoms.h>
+#include <xmsgrid/triangulate/TrTin.h>
+#include <xmsstamper/stamper/detail/XmUtil.h>
+
+// 6. Non-shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+namespace xms
+{
+namespace
+{
+//----- Constants / Enumerations -----------------------------------------------
+const char STORE_MAGIC[8] = {'X', 'M', 'S', 'B', 'A', 'T', 'H', 'Y'}; ///< file signature
+const int32_t STORE_VERSION = 1;                                      ///< file format version
+
+//----- Classes / Structs ------------------------------------------------------
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Index entry for one tile of the store. Each tile is a run of
+/// consecutive triangles in Hilbert order.
+struct iTile
+{
+  double m_xMin;     ///< min x of the triangles in the tile
+  double m_yMin;     ///< min y of the triangles in the tile
+  double m_xMax;     ///< max x of the triangles in the tile
+  double m_yMax;     ///< max y of the triangles in the tile
+  int64_t m_triBeg;  ///< first triangle of the tile
+  int64_t m_triCnt;  ///< number of triangles in the tile
+  int64_t m_ptBeg;   ///< start of the tile in the tile point lists
+  int64_t m_ptCnt;   ///< number of points used by the tile
+};
+
+//------------------------------------------------------------------------------
+/// \brief Writes a value to a binary stream
+/// \param[in] a_os The stream
+/// \param[in] a_val The value
+//------------------------------------------------------------------------------
+template <typename T>
+void iWriteBin(std::ostream& a_os, const T& a_val)
+{
+  a_os.write(reinterpret_cast<const char*>(&a_val), sizeof(T));
+} // iWriteBin
+//------------------------------------------------------------------------------
+/// \brief Reads a value from a binary stream
+/// \param[in] a_is The stream
+/// \param[out] a_val The value
+/// \return true if the value was read.
+//------------------------------------------------------------------------------
+template <typename T>
+bool iReadBin(std::istream& a_is, T& a_val)
+{
+  a_is.read(reinterpret_cast<char*>(&a_val), sizeof(T));
+  return a_is.good();
+} // iReadBin
+//------------------------------------------------------------------------------
+/// \brief Size of the file header in bytes
+/// \return The size.
+//------------------------------------------------------------------------------
+std::streamoff iHeaderSize()
+{
+  return sizeof(STORE_MAGIC) + 2 * sizeof(int32_t) + 4 * sizeof(int64_t) + 6 * sizeof(double);
+} // iHeaderSize
+//------------------------------------------------------------------------------
+/// \brief Size of a tile index entry in bytes
+/// \return The size.
+//------------------------------------------------------------------------------
+std::streamoff iTileSize()
+{
+  return 4 * sizeof(double) + 4 * sizeof(int64_t);
+} // iTileSize
+
+} // unnamed namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Implementation of XmBathymetryStore
+class XmBathymetryStoreImpl : public XmBathymetryStore
+{
+public:
+  XmBathymetryStoreImpl();
+  ~XmBathymetryStoreImpl();
+
+  virtual bool Open(const std::string& a_fileName) override;
+  //------------------------------------------------------------------------------
+  /// \brief Returns true if a store file has been opened
+  /// \return true if open.
+  //------------------------------------------------------------------------------
+  virtual bool IsOpen() const override { return m_file.is_open(); }
+  virtual void GetExtents(Pt3d& a_min, Pt3d& a_max) const override;
+  //------------------------------------------------------------------------------
+  /// \brief Returns the number of tiles in the store
+  /// \return The number of tiles.
+  //------------------------------------------------------------------------------
+  virtual int NumTiles() const override { return (int)m_tiles.size(); }
+  virtual BSHP<TrTin> LoadRegion(const Pt3d& a_min, const Pt3d& a_max) override;
+
+  bool ReadTilePoints(int64_t a_beg, int64_t a_cnt, std::vector<int32_t>& a_ptIdxs);
+  bool ReadPoints(int64_t a_beg, int64_t a_end, VecPt3d& a_pts);
+  bool ReadTriangles(int64_t a_beg, int64_t a_cnt, VecInt& a_tris);
+
+  std::ifstream m_file;       ///< the store file
+  int64_t m_numPts;           ///< number of points in the store
+  int64_t m_numTris;          ///< number of triangles in the store
+  Pt3d m_min;                 ///< min extents of the TIN
+  Pt3d m_max;                 ///< max extents of the TIN
+  std::vector<iTile> m_tiles; ///< the tile index
+  std::streamoff m_listsPos;  ///< file position of the tile point lists
+  int64_t m_numListPts;       ///< number of entries in the tile point lists
+  std::streamoff m_ptsPos;    ///< file position of the point array
+  std::streamoff m_trisPos;   ///< file position of the triangle array
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmBathymetryStoreImpl
+/// \brief Reads regions of a bathymetry TIN from a tiled binary file.
+///
+/// File layout (native byte order):
+///  - header: "XMSBATHY", version, triangles per tile, number of points,
+///    number of triangles, number of tiles, number of tile point list
+///    entries, min xyz, max xyz
+///  - tile index: xy bounding box, first triangle, triangle count and the
+///    start and size of the tile's point list
+///  - tile point lists: the sorted point indices (int32) used by each tile
+///  - points (x, y, z doubles) in Hilbert order
+///  - triangles (3 int32 point indices each) in Hilbert order of their
+///    centroids
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief
+//------------------------------------------------------------------------------
+XmBathymetryStoreImpl::XmBathymetryStoreImpl()
+: m_file()
+, m_numPts(0)
+, m_numTris(0)
+, m_min()
+, m_max()
+, m_tiles()
+, m_listsPos(0)
+, m_numListPts(0)
+, m_ptsPos(0)
+, m_trisPos(0)
+{
+} // XmBathymetryStoreImpl::XmBathymetryStoreImpl
+//------------------------------------------------------------------------------
+/// \brief
+//------------------------------------------------------------------------------
+XmBathymetryStoreImpl::~XmBathymetryStoreImpl()
+{
+} // XmBathymetryStoreImpl::~XmBathymetryStoreImpl
+//------------------------------------------------------------------------------
+/// \brief Opens a store file and reads the tile index
+/// \param[in] a_fileName The file written by XmBathymetryStore::WriteStore
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool XmBathymetryStoreImpl::Open(const std::string& a_fileName)
+{
+  if (m_file.is_open())
+    m_file.close();
+  m_tiles.clear();
+  m_file.open(a_fileName.c_str(), std::ios::in | std::ios::binary);
+  XM_ENSURE_TRUE(m_file.is_open(), false);
+
+  char magic[sizeof(STORE_MAGIC)];
+  m_file.read(magic, sizeof(magic));
+  XM_ENSURE_TRUE(m_file.good() && memcmp(magic, STORE_MAGIC, sizeof(magic)) == 0, false);
+  int32_t version(0), trisPerTile(0);
+  int64_t numTiles(0);
+  XM_ENSURE_TRUE(iReadBin(m_file, version) && version == STORE_VERSION, false);
+  XM_ENSURE_TRUE(iReadBin(m_file, trisPerTile), false);
+  XM_ENSURE_TRUE(iReadBin(m_file, m_numPts) && iReadBin(m_file, m_numTris), false);
+  XM_ENSURE_TRUE(iReadBin(m_file, numTiles) && numTiles >= 0, false);
+  XM_ENSURE_TRUE(iReadBin(m_file, m_numListPts) && m_numListPts >= 0, false);
+  XM_ENSURE_TRUE(iReadBin(m_file, m_min.x) && iReadBin(m_file, m_min.y) &&
+                   iReadBin(m_file, m_min.z),
+                 false);
+  XM_ENSURE_TRUE(iReadBin(m_file, m_max.x) && iReadBin(m_file, m_max.y) &&
+                   iReadBin(m_file, m_max.z),
+                 false);
+
+  m_tiles.resize((size_t)numTiles);
+  for (auto& t : m_tiles)
+  {
+    XM_ENSURE_TRUE(iReadBin(m_file, t.m_xMin) && iReadBin(m_file, t.m_yMin) &&
+                     iReadBin(m_file, t.m_xMax) && iReadBin(m_file, t.m_yMax),
+                   false);
+    XM_ENSURE_TRUE(iReadBin(m_file, t.m_triBeg) && iReadBin(m_file, t.m_triCnt) &&
+                     iReadBin(m_file, t.m_ptBeg) && iReadBin(m_file, t.m_ptCnt),
+                   false);
+  }
+  m_listsPos = iHeaderSize() + numTiles * iTileSize();
+  m_ptsPos = m_listsPos + m_numListPts * (std::streamoff)sizeof(int32_t);
+  m_trisPos = m_ptsPos + m_numPts * 3 * (std::streamoff)sizeof(double);
+  return true;
+} // XmBathymetryStoreImpl::Open
+//------------------------------------------------------------------------------
+/// \brief Gets the extents of the whole TIN in the store
+/// \param[out] a_min Min xyz
+/// \param[out] a_max Max xyz
+//------------------------------------------------------------------------------
+void XmBathymetryStoreImpl::GetExtents(Pt3d& a_min, Pt3d& a_max) const
+{
+  a_min = m_min;
+  a_max = m_max;
+} // XmBathymetryStoreImpl::GetExtents
+//------------------------------------------------------------------------------
+/// \brief Loads the triangles of the tiles that overlap a region. Whole tiles
+/// are loaded so triangles of those tiles outside the region are included
+/// too. Every triangle whose xy bounding box overlaps the region is in one of
+/// the loaded tiles.
+/// \param[in] a_min Min xy of the region
+/// \param[in] a_max Max xy of the region
+/// \return TIN with the triangles of the overlapping tiles. Empty TIN if no
+/// tiles overlap and null on a read error.
+//------------------------------------------------------------------------------
+BSHP<TrTin> XmBathymetryStoreImpl::LoadRegion(const Pt3d& a_min, const Pt3d& a_max)
+{
+  BSHP<TrTin> tin;
+  XM_ENSURE_TRUE(m_file.is_open(), tin);
+
+  // find the tiles, the points that they use and merge their triangle ranges
+  std::vector<int32_t> ptIdxs;
+  std::vector<std::pair<int64_t, int64_t>> triRanges;
+  for (const auto& t : m_tiles)
+  {
+    if (t.m_xMax < a_min.x || t.m_xMin > a_max.x || t.m_yMax < a_min.y || t.m_yMin > a_max.y)
+      continue;
+    if (!ReadTilePoints(t.m_ptBeg, t.m_ptCnt, ptIdxs))
+      return tin;
+    if (!triRanges.empty() && triRanges.back().second == t.m_triBeg)
+      triRanges.back().second += t.m_triCnt;
+    else
+      triRanges.push_back(std::make_pair(t.m_triBeg, t.m_triBeg + t.m_triCnt));
+  }
+  std::sort(ptIdxs.begin(), ptIdxs.end());
+  ptIdxs.erase(std::unique(ptIdxs.begin(), ptIdxs.end()), ptIdxs.end());
+
+  tin = TrTin::New();
+  VecPt3d& pts(tin->Points());
+  VecInt& tris(tin->Triangles());
+  // read runs of consecutive points. Hilbert order keeps the runs long.
+  pts.reserve(ptIdxs.size());
+  for (size_t beg = 0, end = 0; beg < ptIdxs.size(); beg = end)
+  {
+    for (end = beg + 1; end < ptIdxs.size() && ptIdxs[end] == ptIdxs[end - 1] + 1; ++end)
+      ;
+    if (!ReadPoints(ptIdxs[beg], (int64_t)ptIdxs[end - 1] + 1, pts))
+      return BSHP<TrTin>();
+  }
+  // read the triangles and renumber the points
+  for (const auto& r : triRanges)
+  {
+    size_t start = tris.size();
+    if (!ReadTriangles(r.first, r.second - r.first, tris))
+      return BSHP<TrTin>();
+    for (size_t i = start; i < tris.size(); ++i)
+    {
+      auto it = std::lower_bound(ptIdxs.begin(), ptIdxs.end(), (int32_t)tris[i]);
+      XM_ENSURE_TRUE(it != ptIdxs.end() && *it == tris[i], BSHP<TrTin>());
+      tris[i] = (int)(it - ptIdxs.begin());
+    }
+  }
+  tin->BuildTrisAdjToPts();
+  return tin;
+} // XmBathymetryStoreImpl::LoadRegion
+//------------------------------------------------------------------------------
+/// \brief Reads the point list of a tile from the file
+/// \param[in] a_beg Start of the tile in the tile point lists
+/// \param[in] a_cnt The number of points in the tile
+/// \param[in,out] a_ptIdxs The point indices are appended to this vector
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool XmBathymetryStoreImpl::ReadTilePoints(int64_t a_beg,
+                                           int64_t a_cnt,
+                                           std::vector<int32_t>& a_ptIdxs)
+{
+  XM_ENSURE_TRUE(a_beg >= 0 && a_cnt >= 0 && a_beg + a_cnt <= m_numListPts, false);
+  size_t start = a_ptIdxs.size();
+  a_ptIdxs.resize(start + (size_t)a_cnt);
+  m_file.clear();
+  m_file.seekg(m_listsPos + a_beg * (std::streamoff)sizeof(int32_t));
+  m_file.read(reinterpret_cast<char*>(a_ptIdxs.data() + start), a_cnt * sizeof(int32_t));
+  XM_ENSURE_TRUE(m_file.good(), false);
+  return true;
+} // XmBathymetryStoreImpl::ReadTilePoints
+//------------------------------------------------------------------------------
+/// \brief Reads a range of points from the file
+/// \param[in] a_beg First point to read
+/// \param[in] a_end One past the last point to read
+/// \param[in,out] a_pts The points are appended to this vector
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool XmBathymetryStoreImpl::ReadPoints(int64_t a_beg, int64_t a_end, VecPt3d& a_pts)
+{
+  XM_ENSURE_TRUE(a_beg >= 0 && a_end <= m_numPts && a_beg <= a_end, false);
+  VecDbl buf((size_t)(a_end - a_beg) * 3);
+  m_file.clear();
+  m_file.seekg(m_ptsPos + a_beg * 3 * (std::streamoff)sizeof(double));
+  m_file.read(reinterpret_cast<char*>(buf.data()), buf.size() * sizeof(double));
+  XM_ENSURE_TRUE(m_file.good(), false);
+  a_pts.reserve(a_pts.size() + buf.size() / 3);
+  for (size_t i = 0; i < buf.size(); i += 3)
+    a_pts.push_back(Pt3d(buf[i], buf[i + 1], buf[i + 2]));
+  return true;
+} // XmBathymetryStoreImpl::ReadPoints
+//------------------------------------------------------------------------------
+/// \brief Reads a range of triangles from the file
+/// \param[in] a_beg First triangle to read
+/// \param[in] a_cnt The number of triangles to read
+/// \param[in,out] a_tris The triangle point indices are appended to this
+/// vector
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool XmBathymetryStoreImpl::ReadTriangles(int64_t a_beg, int64_t a_cnt, VecInt& a_tris)
+{
+  XM_ENSURE_TRUE(a_beg >= 0 && a_cnt >= 0 && a_beg + a_cnt <= m_numTris, false);
+  std::vector<int32_t> buf((size_t)a_cnt * 3);
+  m_file.clear();
+  m_file.seekg(m_trisPos + a_beg * 3 * (std::streamoff)sizeof(int32_t));
+  m_file.read(reinterpret_cast<char*>(buf.data()), buf.size() * sizeof(int32_t));
+  XM_ENSURE_TRUE(m_file.good(), false);
+  a_tris.insert(a_tris.end(), buf.begin(), buf.end());
+  return true;
+} // XmBathymetryStoreImpl::ReadTriangles
+
+//------------------------------------------------------------------------------
+/// \brief Creates a XmBathymetryStore class
+/// \return Shared ptr to a XmBathymetryStore
+//------------------------------------------------------------------------------
+BSHP<XmBathymetryStore> XmBathymetryStore::New()
+{
+  BSHP<XmBathymetryStore> p(new XmBathymetryStoreImpl());
+  return p;
+} // XmBathymetryStore::New
+//------------------------------------------------------------------------------
+/// \brief Writes a TIN to a store file. Points and triangles are sorted along
+/// a Hilbert curve and the triangles are grouped into tiles.
+/// \param[in] a_fileName The file name
+/// \param[in] a_tin The bathymetry TIN
+/// \param[in] a_trisPerTile The number of triangles in each tile
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool XmBathymetryStore::WriteStore(const std::string& a_fileName,
+                                   BSHP<TrTin> a_tin,
+                                   int a_trisPerTile)
+{
+  XM_ENSURE_TRUE(a_tin && a_trisPerTile > 0, false);
+  const VecPt3d& pts(a_tin->Points());
+  const VecInt& tris(a_tin->Triangles());
+  Pt3d pMin, pMax;
+  a_tin->GetExtents(pMin, pMax);
+
+  // sort the points and renumber the triangles
+  VecInt ptOrder, newPtIdx(pts.size());
+  XmUtil::HilbertOrder(pts, ptOrder);
+  for (size_t i = 0; i < ptOrder.size(); ++i)
+    newPtIdx[ptOrder[i]] = (int)i;
+
+  // sort the triangles by their centroids
+  size_t numTris = tris.size() / 3;
+  std::vector<std::pair<uint64_t, int>> triKeys(numTris);
+  for (size_t t = 0; t < numTris; ++t)
+  {
+    const Pt3d &p0(pts[tris[3 * t]]), &p1(pts[tris[3 * t + 1]]), &p2(pts[tris[3 * t + 2]]);
+    double x = (p0.x + p1.x + p2.x) / 3.0, y = (p0.y + p1.y + p2.y) / 3.0;
+    triKeys[t] = std::make_pair(XmUtil::HilbertIndex(x, y, pMin, pMax), (int)t);
+  }
+  std::sort(triKeys.begin(), triKeys.end());
+  std::vector<int32_t> sortedTris(numTris * 3);
+  for (size_t t = 0; t < numTris; ++t)
+  {
+    size_t oldTri = (size_t)triKeys[t].second;
+    for (size_t j = 0; j < 3; ++j)
+      sortedTris[3 * t + j] = newPtIdx[tris[3 * oldTri + j]];
+  }
+
+  // build the tile index and the point list of each tile
+  std::vector<iTile> tiles;
+  std::vector<int32_t> tilePts, ptList;
+  for (size_t beg = 0; beg < numTris; beg += a_trisPerTile)
+  {
+    size_t end = std::min(numTris, beg + a_trisPerTile);
+    iTile tile;
+    tile.m_xMin = tile.m_yMin = XM_DBL_HIGHEST;
+    tile.m_xMax = tile.m_yMax = XM_DBL_LOWEST;
+    tile.m_triBeg = (int64_t)beg;
+    tile.m_triCnt = (int64_t)(end - beg);
+    ptList.assign(sortedTris.begin() + 3 * beg, sortedTris.begin() + 3 * end);
+    for (auto idx : ptList)
+    {
+      const Pt3d& p(pts[ptOrder[idx]]);
+      tile.m_xMin = std::min(tile.m_xMin, p.x);
+      tile.m_yMin = std::min(tile.m_yMin, p.y);
+      tile.m_xMax = std::max(tile.m_xMax, p.x);
+      tile.m_yMax = std::max(tile.m_yMax, p.y);
+    }
+    std::sort(ptList.begin(), ptList.end());
+    ptList.erase(std::unique(ptList.begin(), ptList.end()), ptList.end());
+    tile.m_ptBeg = (int64_t)tilePts.size();
+    tile.m_ptCnt = (int64_t)ptList.size();
+    tilePts.insert(tilePts.end(), ptList.begin(), ptList.end());
+    tiles.push_back(tile);
+  }
+
+  std::ofstream os(a_fileName.c_str(), std::ios::out | std::ios::binary);
+  XM_ENSURE_TRUE(os.is_open(), false);
+  os.write(STORE_MAGIC, sizeof(STORE_MAGIC));
+  iWriteBin(os, STORE_VERSION);
+  iWriteBin(os, (int32_t)a_trisPerTile);
+  iWriteBin(os, (int64_t)pts.size());
+  iWriteBin(os, (int64_t)numTris);
+  iWriteBin(os, (int64_t)tiles.size());
+  iWriteBin(os, (int64_t)tilePts.size());
+  iWriteBin(os, pMin.x);
+  iWriteBin(os, pMin.y);
+  iWriteBin(os, pMin.z);
+  iWriteBin(os, pMax.x);
+  iWriteBin(os, pMax.y);
+  iWriteBin(os, pMax.z);
+  for (const auto& t : tiles)
+  {
+    iWriteBin(os, t.m_xMin);
+    iWriteBin(os, t.m_yMin);
+    iWriteBin(os, t.m_xMax);
+    iWriteBin(os, t.m_yMax);
+    iWriteBin(os, t.m_triBeg);
+    iWriteBin(os, t.m_triCnt);
+    iWriteBin(os, t.m_ptBeg);
+    iWriteBin(os, t.m_ptCnt);
+  }
+  os.write(reinterpret_cast<const char*>(tilePts.data()), tilePts.size() * sizeof(int32_t));
+  VecDbl ptBuf;
+  ptBuf.reserve(pts.size() * 3);
+  for (auto idx : ptOrder)
+  {
+    ptBuf.push_back(pts[idx].x);
+    ptBuf.push_back(pts[idx].y);
+    ptBuf.push_back(pts[idx].z);
+  }
+  os.write(reinterpret_cast<const char*>(ptBuf.data()), ptBuf.size() * sizeof(double));
+  os.write(reinterpret_cast<const char*>(sortedTris.data()), sortedTris.size() * sizeof(int32_t));
+  return os.good();
+} // XmBathymetryStore::WriteStore
+//------------------------------------------------------------------------------
+/// \brief
+//------------------------------------------------------------------------------
+XmBathymetryStore::XmBathymetryStore()
+{
+} // XmBathymetryStore::XmBathymetryStore
+//------------------------------------------------------------------------------
+/// \brief
+//------------------------------------------------------------------------------
+XmBathymetryStore::~XmBathymetryStore()
+{
+} // XmBathymetryStore::~XmBathymetryStore
+
+} // namespace xms
+
+#ifdef CXX_TEST
+//------------------------------------------------------------------------------
+// Unit Tests
+//------------------------------------------------------------------------------
+using namespace xms;
+#include <xmsstamper/stamper/XmBathymetryStore.t.h>
+
+#include <xmscore/misc/environment.h>
+#include <xmscore/testing/TestTools.h>
+
+boost::shared_ptr<xms::TrTin> trBuildTin(); // XmBathymetryIntersector.cpp
+
+//------------------------------------------------------------------------------
+/// \brief Tests writing a store and loading regions from it
+//------------------------------------------------------------------------------
+void XmBathymetryStoreUnitTests::testWriteAndLoadRegion()
+{
+  BSHP<TrTin> tin = trBuildTin();
+  std::string fname(XMS_TEST_PATH + std::string("stamping/bathymetryStore_out.bin"));
+  TS_ASSERT(XmBathymetryStore::WriteStore(fname, tin, 2));
+
+  BSHP<XmBathymetryStore> store = XmBathymetryStore::New();
+  TS_ASSERT(store->Open(fname));
+  TS_ASSERT_EQUALS(5, store->NumTiles());
+  Pt3d pMin, pMax;
+  store->GetExtents(pMin, pMax);
+  TS_ASSERT_EQUALS(Pt3d(0, 0, 0), pMin);
+  TS_ASSERT_EQUALS(Pt3d(15, 15, 0), pMax);
+
+  // the whole TIN
+  BSHP<TrTin> all = store->LoadRegion(pMin, pMax);
+  TS_ASSERT(all);
+  if (!all)
+    return;
+  TS_ASSERT_EQUALS(tin->NumPoints(), all->NumPoints());
+  TS_ASSERT_EQUALS(tin->NumTriangles(), all->NumTriangles());
+
+  // every triangle of a region must be in the original TIN
+  BSHP<TrTin> part = store->LoadRegion(Pt3d(11, 4), Pt3d(14, 6));
+  TS_ASSERT(part);
+  if (!part)
+    return;
+  TS_ASSERT(part->NumTriangles() > 0);
+  TS_ASSERT(part->NumTriangles() < tin->NumTriangles());
+  // only the points used by the triangles are loaded
+  TS_ASSERT(part->NumPoints() < tin->NumPoints());
+  VecInt used(part->Points().size(), 0);
+  for (auto idx : part->Triangles())
+    used[idx] = 1;
+  TS_ASSERT_EQUALS(VecInt(used.size(), 1), used);
+  auto triKey = [](const VecPt3d& a_pts, const VecInt& a_tris, size_t a_t) {
+    VecPt3d key = {a_pts[a_tris[a_t]], a_pts[a_tris[a_t + 1]], a_pts[a_tris[a_t + 2]]};
+    std::sort(key.begin(), key.end(), [](const Pt3d& a, const Pt3d& b) {
+      return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    return key;
+  };
+  std::vector<VecPt3d> baseKeys;
+  for (size_t t = 0; t < tin->Triangles().size(); t += 3)
+    baseKeys.push_back(triKey(tin->Points(), tin->Triangles(), t));
+  bool found3(false), found7(false);
+  for (size_t t = 0; t < part->Triangles().size(); t += 3)
+  {
+    VecPt3d key = triKey(part->Points(), part->Triangles(), t);
+    TS_ASSERT(std::find(baseKeys.begin(), baseKeys.end(), key) != baseKeys.end());
+    found3 = found3 || key == baseKeys[3];
+    found7 = found7 || key == baseKeys[7];
+  }
+  // triangles 3 and 7 overlap the region
+  TS_ASSERT(found3 && found7);
+
+  // no tiles outside the TIN
+  BSHP<TrTin> none = store->LoadRegion(Pt3d(100, 100), Pt3d(200, 200));
+  TS_ASSERT(none);
+  if (none)
+    TS_ASSERT_EQUALS(0, none->NumTriangles());
+} // XmBathymetryStoreUnitTests::testWriteAndLoadRegion
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup stamping
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+#include <string>
+
+// 4. External library headers
+#include <xmscore/misc/boost_defines.h>
+#include <xmscore/misc/base_macros.h> // for XM_DISALLOW_COPY_AND_ASSIGN
+#include <xmscore/stl/vector.h>
+
+// 5. Shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Structs / Classes ------------------------------------------------------
+class TrTin;
+
+//----- Function prototypes ----------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmBathymetryStore
+/// \brief Binary file holding a bathymetry TIN with points and triangles
+/// sorted along a Hilbert curve and grouped into tiles. Only the tiles that
+/// overlap a region are read from disk.
+/// \see XmBathymetryStoreImpl
+class XmBathymetryStore
+{
+public:
+  static BSHP<XmBathymetryStore> New();
+  static bool WriteStore(const std::string& a_fileName,
+                         BSHP<TrTin> a_tin,
+                         int a_trisPerTile = 4096);
+
+  XmBathymetryStore();
+  virtual ~XmBathymetryStore();
+
+  /// \cond
+  virtual bool Open(const std::string& a_fileName) = 0;
+  virtual bool IsOpen() const = 0;
+  virtual void GetExtents(Pt3d& a_min, Pt3d& a_max) const = 0;
+  virtual int NumTiles() const = 0;
+  virtual BSHP<TrTin> LoadRegion(const Pt3d& a_min, const Pt3d& a_max) = 0;
+
+private:
+  XM_DISALLOW_COPY_AND_ASSIGN(XmBathymetryStore);
+  /// \endcond
+}; // XmBathymetryStore
+
+} // namespace xms
@@ -14,6 +14,7 @@
 
 // 3. Standard library headers
 #include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 
@@ -26,11 +27,14 @@
 #include <xmsgrid/geometry/geoms.h>
 #include <xmsinterp/interpolate/InterpLinear.h>
 #include <xmscore/misc/Observer.h>
+#include <xmsstamper/stamper/XmBathymetryStore.h>
 #include <xmsstamper/stamper/detail/XmBathymetryIntersector.h>
 #include <xmsstamper/stamper/detail/XmBreaklines.h>
 #include <xmsstamper/stamper/detail/XmStampEndCap.h>
 #include <xmsstamper/stamper/detail/XmStamper3dPts.h>
 #include <xmsstamper/stamper/detail/XmStampInterpCrossSection.h>
+#include <xmsstamper/stamper/detail/XmTinSplicer.h>
+#include <xmsstamper/stamper/detail/XmTinVolumes.h>
 #include <xmsstamper/stamper/detail/XmUtil.h>
 #include <xmsstamper/stamper/XmStamperIo.h>
 #include <xmsgrid/triangulate/detail/TrOuterTriangleDeleter.h>
@@ -70,12 +74,25 @@ public:
   /// \brief returns breaklines created by the stamp operation.
   /// \return segments.
   //------------------------------------------------------------------------------
-  virtual const VecInt2d& GetSegments() override { return m_breaklines; }
+  virtual const VecInt2d& GetSegments() override;
   //------------------------------------------------------------------------------
-  /// returns the type of breakline.
+  /// \brief returns the type of each breakline in GetSegmentOffsets.
   /// \return breakline types.
   //------------------------------------------------------------------------------
   virtual const VecInt& GetBreaklineTypes() override { return m_blTypes; }
+  //------------------------------------------------------------------------------
+  /// \brief returns where each breakline created by the stamp operation
+  /// starts in GetSegmentPoints. Has one more entry than the number of
+  /// breaklines.
+  /// \return breakline offsets.
+  //------------------------------------------------------------------------------
+  virtual const VecInt& GetSegmentOffsets() override { return m_blOffsets; }
+  //------------------------------------------------------------------------------
+  /// \brief returns the point indexes of all breaklines created by the stamp
+  /// operation, one after another.
+  /// \return breakline point indexes.
+  //------------------------------------------------------------------------------
+  virtual const VecInt& GetSegmentPoints() override { return m_blPts; }
 
   //------------------------------------------------------------------------------
   /// sets the observer class to get feedback on the meshing process
@@ -83,6 +100,25 @@ public:
   //------------------------------------------------------------------------------
   virtual void SetObserver(BSHP<Observer> a_) override { m_observer = a_; }
 
+  virtual BSHP<TrTin> GetTin() override;
+  virtual const VecInt2d& GetTrisAdjToPts() override;
+  virtual const VecInt2d& GetFootprint() override { return m_outerPolys; }
+  virtual bool BurnRaster(XmStampRaster& a_raster, int a_stampingType) override;
+  virtual size_t StampPoints(VecPt3d& a_pts, int a_stampingType) override;
+  /// \brief Gets the volumes of the last raster burn.
+  /// \return The volumes.
+  virtual const XmStampVolumes& GetVolumes() override { return m_volumes; }
+
+  /// \brief Inputs needed to triangulate one piece of the stamp later.
+  struct stStampPiece
+  {
+    size_t m_offset = 0;   ///< index of the first point of the piece in m_outPts
+    size_t m_numPts = 0;   ///< number of points in the piece
+    VecInt m_blOffsets;    ///< start of each breakline in m_blPts (one extra at end)
+    VecInt m_blPts;        ///< breakline point indexes using the piece's point indexes
+    VecInt m_outerPoly;    ///< outer polygon using the piece's point indexes
+  };
+
   BSHP<Observer> m_observer; ///< progress observer
   XmStamperIo m_io;          ///< inputs to the stamp operation
   /// vector of stampers to break up center line where intersections occur
@@ -96,17 +132,30 @@ public:
   BSHP<XmBreaklines> m_breaklineCreator;
   BSHP<VecPt3d> m_outPts; ///< the output points
   XmStamper3dPts m_3dpts; ///< 3d locations of the stamp operation
-  VecInt2d m_breaklines;  ///< breaklines
+  VecInt2d m_breaklines;  ///< breaklines. Built from m_blOffsets when asked for.
+  bool m_breaklinesBuilt; ///< true if m_breaklines matches m_blOffsets and m_blPts
+  VecInt m_blOffsets;     ///< start of each breakline in m_blPts (one extra at end)
+  VecInt m_blPts;         ///< point indexes of all breaklines
+  VecInt m_blTypes;       ///< type of each breakline in m_blOffsets
+  VecInt2d m_outerPolys;  ///< outer polygon of each piece of the stamp
+  bool m_lazy;            ///< true if the TIN is made when it is asked for
+  bool m_lazyTinBuilt;    ///< true if m_tin has its triangles
+  bool m_geometryOnly;    ///< true if the last stamp made no triangles
+  XmStampVolumes m_volumes; ///< changes made by the last raster burn
+  bool m_rasterDepths;    ///< true to keep the change of each raster cell
+  std::vector<stStampPiece> m_pieces; ///< pieces to triangulate when m_lazy
   bool m_error;           ///< flag to indicate that an error has occurred processing the stamp
   BSHP<TrTin> m_tin;      ///< tin created by the stamp operation
+  BSHP<XmTinVolumes> m_tinVolumes;     ///< volume calculator for m_tinVolumesBathymetry
+  BSHP<TrTin> m_tinVolumesBathymetry; ///< bathymetry indexed by m_tinVolumes
   Pt3d m_stampBoundsMin;  ///< min x,y,z of stamp
   Pt3d m_stampBoundsMax;  ///< max x,y,z of stamp
   BSHP<VecPt3d> m_curPts; ///< the output points
   cs3dPtIdx m_ptIdx;      ///< indexes of point created from stamp
-  VecInt m_blTypes;       ///< type of breakline
 
   void WriteInputsForDebug();
   bool InputErrorsFound();
+  int SimplifyCenterLine();
   void CreateBathymetryIntersector();
   void GetStampBounds();
   void IntersectCenterLineWithBathemetry();
@@ -116,10 +165,23 @@ public:
   void ConvertEndCapsTo3d();
   void IntersectWithTin();
   bool CreateOutputs();
-  void AddCrossSectionPointsToArray(stXs3dPts& a_csPts, VecPt3d& a_pts, csPtIdx& a_ptIdx);
+  bool CreateGeometry();
+  void AddBreaklinesAndClip(BSHP<TrTin> a_tin,
+                            const VecInt& a_blOffsets,
+                            const VecInt& a_blPts,
+                            const VecInt& a_outerPoly);
+  bool TriangulateStrips(VecInt& a_tris);
+  void AddCrossSectionPointsToArray(stXs3dPts& a_csPts,
+                                    VecPt3d& a_pts,
+                                    size_t& a_offset,
+                                    csPtIdx& a_ptIdx);
   bool CreateBreakLines(cs3dPtIdx& a_ptIdx);
   void AppendTinAndBreakLines(bool a_errors);
+  int WeldOutputs();
+  void RemapOutputIndexes(const VecInt& a_oldToNew);
+  void HilbertSortOutputs();
   void Convert3dPtsToVec();
+  BSHP<XmTinVolumes> GetTinVolumes(const XmStamperIo& a_io);
 };
 namespace
 {
@@ -133,9 +195,13 @@ namespace
 /// \param[in, out] a_raster: The raster to interpolate to.
 /// \param[in] a_stampingType: The type of stamping to perform. 0=cut, 1=fill,
 ///        2=both
+/// \param[out] a_volumes: Optional. The cut and fill volumes of the changes,
+///        accumulated as the cells are set.
+/// \param[in] a_depths: True to fill the change of each cell in a_volumes.
 //------------------------------------------------------------------------------
 bool iInterpTinToRaster(const boost::shared_ptr<const TrTin> &a_tin, XmStampRaster &a_raster,
-                        int a_stampingType = 2)
+                        int a_stampingType = 2, XmStampVolumes *a_volumes = nullptr,
+                        bool a_depths = false)
 {
   XM_ENSURE_TRUE(a_tin != nullptr, false);
   BSHP<InterpLinear> interp = InterpLinear::New();
@@ -146,13 +212,24 @@ bool iInterpTinToRaster(const boost::shared_ptr<const TrTin> &a_tin, XmStampRast
   interp->SetPtsTris(pts, tris);
   interp->SetExtrapVal(XM_NODATA);
   int rasterSize = static_cast<int>(a_raster.m_vals.size());
+  double cellArea = std::fabs(a_raster.m_pixelSizeX * a_raster.m_pixelSizeY);
+  if (a_volumes)
+  {
+    *a_volumes = XmStampVolumes();
+    if (a_depths)
+      a_volumes->m_depths.assign(rasterSize, 0.0);
+  }
   for (int i = 0; i < rasterSize; ++i)
   {
+    double oldVal = a_raster.m_vals[i];
+    bool hadData = !EQ_TOL(oldVal, a_raster.m_noData, XM_ZERO_TOL);
+    if (a_volumes && a_depths && !hadData)
+      a_volumes->m_depths[i] = a_raster.m_noData;
     float val = interp->InterpToPt(Pt3d(a_raster.GetLocationFromCellIndex(i)));
     if (!EQ_TOL(val, XM_NODATA, XM_ZERO_TOL))
     {
       // Take the stamp value if the raster has none, regardless of stamping type.
-      if (EQ_TOL(a_raster.m_vals[i], a_raster.m_noData, XM_ZERO_TOL))
+      if (!hadData)
       {
         a_raster.m_vals[i] = val;
       }
@@ -168,6 +245,25 @@ bool iInterpTinToRaster(const boost::shared_ptr<const TrTin> &a_tin, XmStampRast
       {
         a_raster.m_vals[i] = val;
       }
+
+      if (a_volumes)
+      {
+        double change = a_raster.m_vals[i] - oldVal;
+        if (!hadData)
+        {
+          ++a_volumes->m_numChangedCells;
+        }
+        else if (change != 0.0)
+        {
+          ++a_volumes->m_numChangedCells;
+          if (change < 0.0)
+            a_volumes->m_cutVolume -= change * cellArea;
+          else
+            a_volumes->m_fillVolume += change * cellArea;
+          if (a_depths)
+            a_volumes->m_depths[i] = change;
+        }
+      }
     }
   }
   return true;
@@ -186,6 +282,13 @@ XmStamperImpl::XmStamperImpl()
 , m_io()
 , m_interp(XmStampInterpCrossSection::New())
 , m_outPts(new VecPt3d())
+, m_breaklinesBuilt(true)
+, m_blOffsets(1, 0)
+, m_lazy(false)
+, m_lazyTinBuilt(true)
+, m_geometryOnly(false)
+, m_volumes()
+, m_rasterDepths(false)
 , m_error(false)
 {
 } // XmStamperImpl::XmStamperImpl
@@ -205,12 +308,43 @@ void XmStamperImpl::DoStamp(XmStamperIo& a_io)
   m_io = a_io;
   m_io.m_outTin.reset();
   m_io.m_outBreakLines.clear();
+  m_io.m_outBreakLineOffsets.clear();
+  m_io.m_outBreakLinePts.clear();
+  m_io.m_outBreakLineTypes.clear();
+  a_io.m_outNumCenterLinePtsRemoved = 0;
+  m_io.PrepareCrossSectionLibrary();
+  m_interp->CrossSectionsFromStations(m_io);
+  a_io.m_outPoints.clear();
+  a_io.m_outOuterPolygons.clear();
+  a_io.m_outSplicedTin.reset();
+  // the raster is interpolated from the TIN so it needs the triangles
+  bool geometryOnly =
+    a_io.m_geometryOnly && a_io.m_raster.m_vals.empty() && a_io.m_targetPoints.empty();
+  m_geometryOnly = geometryOnly;
+  m_lazy = a_io.m_lazyOutputs && !geometryOnly;
+  m_lazyTinBuilt = !m_lazy;
+  m_volumes = XmStampVolumes();
+  m_rasterDepths = a_io.m_rasterDepths;
+  a_io.m_outVolumes = XmStampVolumes();
+  a_io.m_outTinCutVolume = a_io.m_outTinFillVolume = 0.0;
+  m_pieces.clear();
+  // the stamper can be reused. Only the indexed bathymetry is kept.
+  m_error = false;
+  m_tin.reset();
+  m_outPts.reset(new VecPt3d());
+  m_blOffsets.assign(1, 0);
+  m_blPts.clear();
+  m_blTypes.clear();
+  m_breaklines.clear();
+  m_breaklinesBuilt = true;
+  m_outerPolys.clear();
 
   WriteInputsForDebug();
 
   if (InputErrorsFound())
     return;
 
+  a_io.m_outNumCenterLinePtsRemoved = SimplifyCenterLine();
   CreateBathymetryIntersector();
 
   IntersectCenterLineWithBathemetry();
@@ -225,17 +359,67 @@ void XmStamperImpl::DoStamp(XmStamperIo& a_io)
     ConvertCrossSectionsTo3d();
     ConvertEndCapsTo3d();
     IntersectWithTin();
-    bool rval = CreateOutputs();
+    bool rval = geometryOnly || m_lazy ? CreateGeometry() : CreateOutputs();
+    if (m_lazy && rval && m_io.m_outTin && m_breaklineCreator)
+    {
+      stStampPiece piece;
+      piece.m_offset = m_tin ? m_outPts->size() : 0;
+      piece.m_numPts = m_io.m_outTin->Points().size();
+      piece.m_blOffsets = m_io.m_outBreakLineOffsets;
+      piece.m_blPts = m_io.m_outBreakLinePts;
+      piece.m_outerPoly = m_breaklineCreator->GetOuterPolygon();
+      m_pieces.push_back(piece);
+    }
     AppendTinAndBreakLines(!rval);
   }
 
+  a_io.m_outNumWeldedPts = 0;
+  if (!m_error && a_io.m_weldPoints)
+    a_io.m_outNumWeldedPts = WeldOutputs();
+  if (!m_error && a_io.m_hilbertOrder)
+    HilbertSortOutputs();
+
   if (!m_error)
   {
-    a_io.m_outBreakLines = m_breaklines;
+    a_io.m_outBreakLineOffsets = m_blOffsets;
+    a_io.m_outBreakLinePts = m_blPts;
+    a_io.m_outBreakLineTypes = m_blTypes;
+    if (!a_io.m_flatBreaklinesOnly)
+      a_io.m_outBreakLines = GetSegments();
+    a_io.m_outOuterPolygons = m_outerPolys;
+    if (geometryOnly)
+    {
+      a_io.m_outPoints = *m_outPts;
+      return;
+    }
+    // the TIN and raster are made when they are asked for
+    if (m_lazy)
+      return;
     a_io.m_outTin = m_tin;
+    if (a_io.m_spliceIntoBathymetry && a_io.m_bathymetry && m_tin)
+    {
+      BSHP<XmTinSplicer> splicer = XmTinSplicer::New();
+      a_io.m_outSplicedTin =
+        splicer->Splice(a_io.m_bathymetry, m_tin, m_outerPolys, a_io.m_stampingType);
+    }
+    else if (a_io.m_spliceIntoBathymetry && a_io.m_bathymetryStore && m_tin)
+    {
+      XM_LOG(xmlog::warning, "The stamp can't be spliced into a bathymetry store. Set "
+                             "m_bathymetry to splice the stamp.");
+    }
+    BSHP<XmTinVolumes> volumes = a_io.m_tinVolumes && m_tin ? GetTinVolumes(a_io) : nullptr;
+    if (volumes)
+      volumes->Compute(m_tin, a_io.m_outTinCutVolume, a_io.m_outTinFillVolume);
     if (!a_io.m_raster.m_vals.empty())
     {
-      iInterpTinToRaster(a_io.m_outTin, a_io.m_raster, a_io.m_stampingType);
+      iInterpTinToRaster(a_io.m_outTin, a_io.m_raster, a_io.m_stampingType, &m_volumes,
+                         a_io.m_rasterDepths);
+      a_io.m_outVolumes = m_volumes;
+    }
+    if (!a_io.m_targetPoints.empty() && m_tin)
+    {
+      XmUtil::StampTinToPoints(m_tin->Points(), m_tin->Triangles(), a_io.m_stampingType,
+                               a_io.m_targetPoints);
     }
   }
   
@@ -267,16 +451,41 @@ bool XmStamperImpl::InputErrorsFound()
     XM_LOG(xmlog::warning, "No valid cross sections defined. Aborting stamp operation.");
     return true;
   }
+  // lazy outputs are made after DoStamp so options that change them can't be used
+  if (m_lazy)
+  {
+    if (!m_io.m_raster.m_vals.empty() || !m_io.m_targetPoints.empty())
+    {
+      XM_LOG(xmlog::warning, "Lazy outputs can't fill the raster or target points. Use "
+                             "BurnRaster or StampPoints. Aborting stamp operation.");
+      return true;
+    }
+    if (m_io.m_weldPoints || m_io.m_hilbertOrder || m_io.m_spliceIntoBathymetry ||
+        m_io.m_tinVolumes)
+    {
+      XM_LOG(xmlog::warning, "Lazy outputs can't be welded, sorted, spliced or used for "
+                             "volumes. Aborting stamp operation.");
+      return true;
+    }
+  }
 
   return false;
 } // XmStamperImpl::InputErrorsFound
 //------------------------------------------------------------------------------
+/// \brief Removes redundant center line points using the center line tolerance
+/// \return The number of points removed.
+//------------------------------------------------------------------------------
+int XmStamperImpl::SimplifyCenterLine()
+{
+  return XmUtil::SimplifyCenterLine(m_io);
+} // XmStamperImpl::SimplifyCenterLine
+//------------------------------------------------------------------------------
 /// \brief Creates the intersector for the bathymetry
 //------------------------------------------------------------------------------
 void XmStamperImpl::CreateBathymetryIntersector()
 {
   m_intersect.reset();
-  if (m_io.m_bathymetry)
+  if (m_io.m_bathymetry || m_io.m_bathymetryStore)
   {
     XmStamperIo tmp(m_io);
 
@@ -289,13 +498,47 @@ void XmStamperImpl::CreateBathymetryIntersector()
     // get the boundary of the stamp
     GetStampBounds();
 
-    m_intersect = XmBathymetryIntersector::New(m_io.m_bathymetry, m_io.m_outTin);
-    m_intersect->IntersectCenterLine(m_io);
+    if (m_io.m_bathymetry)
+      m_intersect = XmBathymetryIntersector::New(m_io.m_bathymetry, m_io.m_outTin);
+    else
+    {
+      double halo = 0.01 * Mdist(m_stampBoundsMin.x, m_stampBoundsMin.y, m_stampBoundsMax.x,
+                                 m_stampBoundsMax.y);
+      m_intersect = XmBathymetryIntersector::New(m_io.m_bathymetryStore, m_io.m_outTin, halo);
+    }
+    if (m_intersect)
+      m_intersect->IntersectCenterLine(m_io);
 
     m_io = tmp;
   }
 } // XmStamperImpl::IntersectCenterLineWithBathemetry
 //------------------------------------------------------------------------------
+/// \brief Gets the volume calculator for the bathymetry. It is kept while the
+/// same bathymetry TIN is used since indexing the bathymetry is the slow part.
+/// With only a bathymetry store the part under the stamp TIN is loaded.
+/// \param[in] a_io The stamper inputs
+/// \return The volume calculator. Null if there is no bathymetry.
+//------------------------------------------------------------------------------
+BSHP<XmTinVolumes> XmStamperImpl::GetTinVolumes(const XmStamperIo& a_io)
+{
+  if (a_io.m_bathymetry)
+  {
+    if (!m_tinVolumes || m_tinVolumesBathymetry != a_io.m_bathymetry)
+    {
+      m_tinVolumes = XmTinVolumes::New(a_io.m_bathymetry);
+      m_tinVolumesBathymetry = a_io.m_bathymetry;
+    }
+    return m_tinVolumes;
+  }
+  if (!a_io.m_bathymetryStore || !m_tin)
+    return BSHP<XmTinVolumes>();
+  Pt3d mn, mx;
+  m_tin->GetExtents(mn, mx);
+  BSHP<TrTin> region = a_io.m_bathymetryStore->LoadRegion(mn, mx);
+  XM_ENSURE_TRUE(region, BSHP<XmTinVolumes>());
+  return XmTinVolumes::New(region);
+} // XmStamperImpl::GetTinVolumes
+//------------------------------------------------------------------------------
 /// \brief Gets the bounds of the stamp
 //------------------------------------------------------------------------------
 void XmStamperImpl::GetStampBounds()
@@ -345,7 +588,7 @@ void XmStamperImpl::InterpolateMissingCrossSections()
 //------------------------------------------------------------------------------
 void XmStamperImpl::DecomposeCenterLine()
 {
-  m_vIo.push_back(m_io);
+  m_vIo.assign(1, m_io);
   if (!m_intersect)
     return;
   m_intersect->DecomposeCenterLine(m_io, m_vIo);
@@ -355,14 +598,20 @@ void XmStamperImpl::DecomposeCenterLine()
 //------------------------------------------------------------------------------
 void XmStamperImpl::ConvertCrossSectionsTo3d()
 {
-  for (size_t i = 0; i < m_io.m_cs.size(); ++i)
+  m_3dpts.m_xsPts.m_left.reserve(m_3dpts.m_xsPts.m_left.size() + m_io.m_cs.size());
+  m_3dpts.m_xsPts.m_right.reserve(m_3dpts.m_xsPts.m_right.size() + m_io.m_cs.size());
+  VecDbl leftCos, leftSin, rightCos, rightSin;
+  XmUtil::GetCenterLineSinCos(m_io.m_centerLine, 0, leftCos, leftSin, rightCos, rightSin);
+  size_t nCs = std::min(m_io.m_cs.size(), m_io.m_centerLine.size());
+  XmStampCrossSection buf;
+  for (size_t i = 0; i < nCs; ++i)
   {
-    XmStampCrossSection& cs(m_io.m_cs[i]);
-    Pt3d p(m_io.m_centerLine[i]);
-    double leftAngle, rightAngle;
-    XmUtil::GetAnglesFromCenterLine(i, m_io.m_centerLine, leftAngle, rightAngle);
-    XmUtil::ConvertXsPointsTo3d(p, cs.m_left, cs.m_leftMax, leftAngle, m_3dpts.m_xsPts.m_left);
-    XmUtil::ConvertXsPointsTo3d(p, cs.m_right, cs.m_rightMax, rightAngle, m_3dpts.m_xsPts.m_right);
+    const XmStampCrossSection& cs(m_io.CrossSection(i, buf));
+    const Pt3d& p(m_io.m_centerLine[i]);
+    XmUtil::ConvertXsPointsTo3d(p, cs.m_left, cs.m_leftMax, leftCos[i], leftSin[i],
+                                m_3dpts.m_xsPts.m_left);
+    XmUtil::ConvertXsPointsTo3d(p, cs.m_right, cs.m_rightMax, rightCos[i], rightSin[i],
+                                m_3dpts.m_xsPts.m_right);
   }
 } // XmStamperImpl::ConvertCrossSectionsTo3d
 //------------------------------------------------------------------------------
@@ -382,7 +631,7 @@ void XmStamperImpl::ConvertEndCapsTo3d()
 //------------------------------------------------------------------------------
 void XmStamperImpl::IntersectWithTin()
 {
-  if (!m_io.m_bathymetry)
+  if (!m_intersect)
     return;
 
   // intersect the left and right side xsects
@@ -408,96 +657,225 @@ bool XmStamperImpl::CreateOutputs()
   // Triangulate
   m_io.m_outTin = TrTin::New();
   m_io.m_outTin->SetPoints(m_curPts);
-  TrTriangulatorPoints client(m_io.m_outTin->Points(), m_io.m_outTin->Triangles(),
-                              &m_io.m_outTin->TrisAdjToPts());
-  client.SetObserver(m_observer);
-  if (!client.Triangulate())
-    return false;
+  bool strips = m_io.m_stripTriangulation && TriangulateStrips(m_io.m_outTin->Triangles());
+  if (strips)
+  {
+    m_io.m_outTin->BuildTrisAdjToPts();
+  }
+  else
+  {
+    TrTriangulatorPoints client(m_io.m_outTin->Points(), m_io.m_outTin->Triangles(),
+                                &m_io.m_outTin->TrisAdjToPts());
+    client.SetObserver(m_observer);
+    if (!client.Triangulate())
+      return false;
+  }
   if (m_io.m_outTin && m_io.m_outTin->NumTriangles() < 1)
   {
     m_io.m_outTin.reset();
     return false;
   }
 
-  if (!m_error && m_io.m_outBreakLines.size() > 0 && m_io.m_outTin && m_io.m_outTin->PointsPtr())
+  const VecInt& blOffsets(m_io.m_outBreakLineOffsets);
+  const VecInt& blPts(m_io.m_outBreakLinePts);
+  if (!m_error && blOffsets.size() > 1 && m_io.m_outTin && m_io.m_outTin->PointsPtr())
   {
     VecPt3d& pts(*m_io.m_outTin->PointsPtr());
-    m_error = m_breaklineCreator->BreaklinesIntersect(m_io.m_outBreakLines, pts);
+    m_error = m_breaklineCreator->BreaklinesIntersect(blOffsets, blPts, pts);
     if (m_error)
     {
       XM_LOG(xmlog::warning, "Intersection found in stamp outputs. Stamping operation aborted.");
     }
   }
 
-  if (!m_error)
+  if (!m_error && !strips)
+    AddBreaklinesAndClip(m_io.m_outTin, blOffsets, blPts, m_breaklineCreator->GetOuterPolygon());
+
+  return true;
+} // XmStamperImpl::CreateOutputs
+//------------------------------------------------------------------------------
+/// \brief Forces the breaklines into a TIN and deletes the triangles outside
+/// the outer polygon.
+/// \param[in] a_tin The TIN
+/// \param[in] a_blOffsets Start of each breakline in a_blPts (one extra at end)
+/// \param[in] a_blPts Point indexes of all breaklines
+/// \param[in] a_outerPoly The outer polygon (closed)
+//------------------------------------------------------------------------------
+void XmStamperImpl::AddBreaklinesAndClip(BSHP<TrTin> a_tin,
+                                         const VecInt& a_blOffsets,
+                                         const VecInt& a_blPts,
+                                         const VecInt& a_outerPoly)
+{
+  // force in the breaklines. TrBreaklineAdder takes them one vector each.
+  VecInt2d breaklines(a_blOffsets.empty() ? 0 : a_blOffsets.size() - 1);
+  for (size_t i = 0; i < breaklines.size(); ++i)
   {
-    // force in the breaklines
-    BSHP<TrBreaklineAdder> bl = TrBreaklineAdder::New();
-    bl->SetTin(m_io.m_outTin);
-    bl->AddBreaklines(m_io.m_outBreakLines);
+    auto beg = a_blPts.begin() + a_blOffsets[i];
+    breaklines[i].assign(beg, a_blPts.begin() + a_blOffsets[i + 1]);
+  }
+  BSHP<TrBreaklineAdder> bl = TrBreaklineAdder::New();
+  bl->SetTin(a_tin);
+  bl->AddBreaklines(breaklines);
 
-    // delete triangles outside the outer boundary
+  // delete triangles outside the outer boundary. The boundary edges are in
+  // the TIN now so flood fill from them unless one could not be added.
+  SetInt outside;
+  if (XmUtil::FloodFillOuterTriangles(a_tin->Points(), a_tin->Triangles(), a_outerPoly, outside))
+  {
+    if (!outside.empty())
+      a_tin->DeleteTriangles(outside);
+  }
+  else
+  {
     BSHP<TrOuterTriangleDeleter> deleter = TrOuterTriangleDeleter::New();
-    VecInt2d poly(1, m_breaklineCreator->GetOuterPolygon());
-    deleter->Delete(poly, m_io.m_outTin);
+    VecInt2d poly(1, a_outerPoly);
+    deleter->Delete(poly, a_tin);
   }
+} // XmStamperImpl::AddBreaklinesAndClip
+//------------------------------------------------------------------------------
+/// \brief Creates the output points and breaklines without triangulating.
+/// m_io.m_outTin only holds the points.
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool XmStamperImpl::CreateGeometry()
+{
+  Convert3dPtsToVec();
+  if (!CreateBreakLines(m_ptIdx))
+    return false;
 
+  m_io.m_outTin = TrTin::New();
+  m_io.m_outTin->SetPoints(m_curPts);
+  if (!m_error && m_io.m_outBreakLineOffsets.size() > 1)
+  {
+    const VecInt& blOffsets(m_io.m_outBreakLineOffsets);
+    m_error = m_breaklineCreator->BreaklinesIntersect(blOffsets, m_io.m_outBreakLinePts, *m_curPts);
+    if (m_error)
+    {
+      XM_LOG(xmlog::warning, "Intersection found in stamp outputs. Stamping operation aborted.");
+    }
+  }
   return true;
-} // XmStamperImpl::CreateOutputs
+} // XmStamperImpl::CreateGeometry
 //------------------------------------------------------------------------------
-/// \brief puts all of the generated 3d points into one vector
+/// \brief Triangulates the stamp one strip at a time. Each strip is the area
+/// on one side of the center line between two cross sections and is split at
+/// the shoulder, so the triangles honor the breaklines and stay inside the
+/// outer polygon without adding breaklines or deleting triangles afterwards.
+/// Only used when the end caps have no points of their own (wing walls).
+/// \param[out] a_tris The triangles.
+/// \return false if the stamp can't be triangulated this way.
+//------------------------------------------------------------------------------
+bool XmStamperImpl::TriangulateStrips(VecInt& a_tris)
+{
+  if (m_3dpts.m_first_endcap.NumPoints() > 0 || m_3dpts.m_last_endcap.NumPoints() > 0)
+    return false;
+  const stIdxRange& cl(m_ptIdx.m_centerLine);
+  const stIdxRows& left(m_ptIdx.m_xsPts.m_left);
+  const stIdxRows& right(m_ptIdx.m_xsPts.m_right);
+  if (cl.size() < 2 || left.size() != cl.size() || right.size() != cl.size() ||
+      m_io.m_cs.size() != cl.size())
+    return false;
+
+  // center line point followed by one side of the cross section. a_shoulder
+  // is the position of the shoulder in a_poly.
+  auto getPoly = [&cl](size_t a_i, const stIdxRange& a_side, int a_idxShoulder, VecInt& a_poly,
+                       size_t& a_shoulder) {
+    a_poly.assign(1, cl[a_i]);
+    a_poly.insert(a_poly.end(), a_side.begin(), a_side.end());
+    a_shoulder = 0;
+    if (!a_side.empty())
+      a_shoulder = 1 + std::min((size_t)std::max(a_idxShoulder - 1, 0), a_side.size() - 1);
+  };
+
+  const VecPt3d& pts(*m_curPts);
+  VecInt tris, poly0, poly1, a, b;
+  tris.reserve(6 * pts.size());
+  for (size_t i = 0; i + 1 < cl.size(); ++i)
+  {
+    for (int side = 0; side < 2; ++side)
+    {
+      size_t s0, s1;
+      if (side == 0)
+      {
+        getPoly(i, left[i], m_io.m_cs[i].m_idxLeftShoulder, poly0, s0);
+        getPoly(i + 1, left[i + 1], m_io.m_cs[i + 1].m_idxLeftShoulder, poly1, s1);
+      }
+      else
+      {
+        getPoly(i, right[i], m_io.m_cs[i].m_idxRightShoulder, poly0, s0);
+        getPoly(i + 1, right[i + 1], m_io.m_cs[i + 1].m_idxRightShoulder, poly1, s1);
+      }
+      // center line to shoulder, then shoulder to the end of the cross section
+      a.assign(poly0.begin(), poly0.begin() + s0 + 1);
+      b.assign(poly1.begin(), poly1.begin() + s1 + 1);
+      if (!XmUtil::ZipperTriangulate(pts, a, b, tris))
+        return false;
+      a.assign(poly0.begin() + s0, poly0.end());
+      b.assign(poly1.begin() + s1, poly1.end());
+      if (!XmUtil::ZipperTriangulate(pts, a, b, tris))
+        return false;
+    }
+  }
+  a_tris.swap(tris);
+  return true;
+} // XmStamperImpl::TriangulateStrips
+//------------------------------------------------------------------------------
+/// \brief puts all of the generated 3d points into one vector. The vector is
+/// sized once and the points of each cross section are consecutive so their
+/// indexes are kept as offsets into the vector.
 //------------------------------------------------------------------------------
 void XmStamperImpl::Convert3dPtsToVec()
 {
   m_ptIdx = cs3dPtIdx();
   // put all of the points into 1 array for the output TIN
-  m_curPts = BSHP<VecPt3d>(new VecPt3d());
-  for (const auto& p : m_io.m_centerLine)
-  {
-    m_ptIdx.m_centerLine.push_back((int)m_curPts->size());
-    m_curPts->push_back(p);
-  }
-  AddCrossSectionPointsToArray(m_3dpts.m_xsPts, *m_curPts, m_ptIdx.m_xsPts);
-  AddCrossSectionPointsToArray(m_3dpts.m_first_endcap, *m_curPts, m_ptIdx.m_first_end_cap);
-  AddCrossSectionPointsToArray(m_3dpts.m_last_endcap, *m_curPts, m_ptIdx.m_last_end_cap);
+  size_t numPts = m_io.m_centerLine.size() + m_3dpts.m_xsPts.NumPoints() +
+                  m_3dpts.m_first_endcap.NumPoints() + m_3dpts.m_last_endcap.NumPoints();
+  m_curPts = BSHP<VecPt3d>(new VecPt3d(numPts));
+  VecPt3d& pts(*m_curPts);
+  size_t offset(0);
+  m_ptIdx.m_centerLine = stIdxRange((int)offset, (int)m_io.m_centerLine.size());
+  std::copy(m_io.m_centerLine.begin(), m_io.m_centerLine.end(), pts.begin() + offset);
+  offset += m_io.m_centerLine.size();
+  AddCrossSectionPointsToArray(m_3dpts.m_xsPts, pts, offset, m_ptIdx.m_xsPts);
+  AddCrossSectionPointsToArray(m_3dpts.m_first_endcap, pts, offset, m_ptIdx.m_first_end_cap);
+  AddCrossSectionPointsToArray(m_3dpts.m_last_endcap, pts, offset, m_ptIdx.m_last_end_cap);
 } // XmStamperImpl::Convert3dPtsToVec
 
 //------------------------------------------------------------------------------
 /// \brief puts cross section points into a single array to be used by a TIN
 /// \param[in] a_csPts Left and right points for cross sections
-/// \param[out] a_pts The array of points for the TIN
-/// \param[out] a_ptIdx The indexes of the points in the a_pts array
+/// \param[out] a_pts The array of points for the TIN. Already sized to hold
+/// the points.
+/// \param[in,out] a_offset The location in a_pts where the points go. Moved
+/// past the points that are added.
+/// \param[out] a_ptIdx The offsets of the cross sections in the a_pts array
 //------------------------------------------------------------------------------
 void XmStamperImpl::AddCrossSectionPointsToArray(stXs3dPts& a_csPts,
                                                  VecPt3d& a_pts,
+                                                 size_t& a_offset,
                                                  csPtIdx& a_ptIdx)
 {
-  for (const auto& v : a_csPts.m_left)
-  {
-    a_ptIdx.m_left.push_back(VecInt());
-    for (const auto& p : v)
+  XM_ENSURE_TRUE(a_offset + a_csPts.NumPoints() <= a_pts.size());
+  auto addRows = [&](const VecPt3d2d& a_rows, stIdxRows& a_idx) {
+    a_idx.m_offsets.resize(a_rows.size() + 1);
+    a_idx.m_offsets[0] = (int)a_offset;
+    for (size_t i = 0; i < a_rows.size(); ++i)
     {
-      a_ptIdx.m_left.back().push_back((int)a_pts.size());
-      a_pts.push_back(p);
+      std::copy(a_rows[i].begin(), a_rows[i].end(), a_pts.begin() + a_offset);
+      a_offset += a_rows[i].size();
+      a_idx.m_offsets[i + 1] = (int)a_offset;
     }
-  }
-  for (const auto& v : a_csPts.m_right)
-  {
-    a_ptIdx.m_right.push_back(VecInt());
-    for (const auto& p : v)
-    {
-      a_ptIdx.m_right.back().push_back((int)a_pts.size());
-      a_pts.push_back(p);
-    }
-  }
-  for (const auto p : a_csPts.m_centerLine)
-  {
-    a_ptIdx.m_centerLine.push_back((int)a_pts.size());
-    a_pts.push_back(p);
-  }
+  };
+  addRows(a_csPts.m_left, a_ptIdx.m_left);
+  addRows(a_csPts.m_right, a_ptIdx.m_right);
+  a_ptIdx.m_centerLine = stIdxRange((int)a_offset, (int)a_csPts.m_centerLine.size());
+  std::copy(a_csPts.m_centerLine.begin(), a_csPts.m_centerLine.end(), a_pts.begin() + a_offset);
+  a_offset += a_csPts.m_centerLine.size();
 } // XmStamperImpl::AddCrossSectionPointsToArray
 //------------------------------------------------------------------------------
-/// \brief Creates breaklines that will be honored in the TIN
+/// \brief Creates breaklines that will be honored in the TIN. They are put in
+/// the m_outBreakLineOffsets, m_outBreakLinePts and m_outBreakLineTypes
+/// members of m_io.
 /// \param[in] a_ptIdx The indexes of the points in the TIN
 /// \return true if breaklines successfully created.
 //------------------------------------------------------------------------------
@@ -506,7 +884,7 @@ bool XmStamperImpl::CreateBreakLines(cs3dPtIdx& a_ptIdx)
   m_breaklineCreator.reset();
   m_breaklineCreator = XmBreaklines::New();
 
-  bool rval = m_breaklineCreator->CreateBreaklines(m_io, a_ptIdx, m_blTypes);
+  bool rval = m_breaklineCreator->CreateBreaklines(m_io, a_ptIdx);
   return rval;
 } // XmStamperImpl::CreateBreakLines
 //------------------------------------------------------------------------------
@@ -515,16 +893,16 @@ bool XmStamperImpl::CreateBreakLines(cs3dPtIdx& a_ptIdx)
 //------------------------------------------------------------------------------
 void XmStamperImpl::AppendTinAndBreakLines(bool a_errors)
 {
+  int nPts = 0;
   if (!m_tin && m_io.m_outTin)
   {
     m_tin = m_io.m_outTin;
-    m_breaklines = m_io.m_outBreakLines;
     m_outPts = m_tin->PointsPtr();
   }
   else if (m_io.m_outTin)
   {
     // get the number of points in the current TIN
-    int nPts = (int)m_outPts->size();
+    nPts = (int)m_outPts->size();
     // add the points from the current TIN
     m_outPts->reserve(nPts + m_io.m_outTin->Points().size());
     {
@@ -542,23 +920,269 @@ void XmStamperImpl::AppendTinAndBreakLines(bool a_errors)
       auto end = m_io.m_outTin->Triangles().end();
       m_tin->Triangles().insert(e1, beg, end);
     }
+  }
+  if (m_io.m_outTin && m_breaklineCreator)
+  {
+    m_outerPolys.push_back(m_breaklineCreator->GetOuterPolygon());
+    for (auto& idx : m_outerPolys.back())
+      idx += nPts;
+  }
+  if (m_io.m_outTin)
+  {
+    // append the breaklines after updating indices
+    const VecInt& offsets(m_io.m_outBreakLineOffsets);
+    const VecInt& blPts(m_io.m_outBreakLinePts);
+    int blStart = (int)m_blPts.size();
+    m_blPts.reserve(m_blPts.size() + blPts.size());
+    for (auto idx : blPts)
+      m_blPts.push_back(idx + nPts);
+    for (size_t i = 1; i < offsets.size(); ++i)
+      m_blOffsets.push_back(offsets[i] + blStart);
+    auto& types(m_io.m_outBreakLineTypes);
+    m_blTypes.insert(m_blTypes.end(), types.begin(), types.end());
+    m_breaklinesBuilt = false;
+  }
+  if (a_errors)
+    m_error = true;
+} // XmStamperImpl::AppendTinAndBreakLines
+//------------------------------------------------------------------------------
+/// \brief Merges coincident points of the stamp pieces and end caps and
+/// updates the triangles, breaklines and outer polygons to use them.
+/// Triangles that collapse are removed. The tolerance is the bathymetry
+/// intersector's xy tolerance since it made the shared points.
+/// \return The number of points removed.
+//------------------------------------------------------------------------------
+int XmStamperImpl::WeldOutputs()
+{
+  if (!m_tin || !m_outPts || m_outPts->empty())
+    return 0;
+  // same as an intersector without a bathymetry TIN
+  double xyTol = m_intersect ? m_intersect->XyTol() : 1e-9;
+  VecInt oldToNew;
+  int removed = XmUtil::WeldPoints(*m_outPts, xyTol, oldToNew);
+  if (removed != 0)
+    RemapOutputIndexes(oldToNew);
+  return removed;
+} // XmStamperImpl::WeldOutputs
+//------------------------------------------------------------------------------
+/// \brief Changes the point indexes of the triangles, breaklines and outer
+/// polygons. Triangles that collapse are removed, repeated breakline and
+/// polygon points are removed and breaklines with less than 2 points are
+/// removed.
+/// \param[in] a_oldToNew The new index of each point
+//------------------------------------------------------------------------------
+void XmStamperImpl::RemapOutputIndexes(const VecInt& a_oldToNew)
+{
+  // triangles
+  VecInt& tris(m_tin->Triangles());
+  size_t nTris(0);
+  for (size_t i = 0; i + 2 < tris.size(); i += 3)
+  {
+    int t0 = a_oldToNew[tris[i]], t1 = a_oldToNew[tris[i + 1]], t2 = a_oldToNew[tris[i + 2]];
+    if (t0 == t1 || t1 == t2 || t2 == t0)
+      continue;
+    tris[nTris++] = t0;
+    tris[nTris++] = t1;
+    tris[nTris++] = t2;
+  }
+  tris.resize(nTris);
+  if (!m_tin->TrisAdjToPts().empty())
+  {
+    m_tin->TrisAdjToPts().clear();
+    m_tin->BuildTrisAdjToPts();
+  }
+
+  // breaklines lose repeated points and those that become a single point
+  VecInt offsets(1, 0), blPts, types;
+  blPts.reserve(m_blPts.size());
+  for (size_t i = 0; i + 1 < m_blOffsets.size(); ++i)
+  {
+    size_t start = blPts.size();
+    for (int j = m_blOffsets[i]; j < m_blOffsets[i + 1]; ++j)
+    {
+      int idx = a_oldToNew[m_blPts[j]];
+      if (blPts.size() == start || blPts.back() != idx)
+        blPts.push_back(idx);
+    }
+    if (blPts.size() - start < 2)
+    {
+      blPts.resize(start);
+      continue;
+    }
+    offsets.push_back((int)blPts.size());
+    types.push_back(i < m_blTypes.size() ? m_blTypes[i] : -1);
+  }
+  m_blOffsets.swap(offsets);
+  m_blPts.swap(blPts);
+  m_blTypes.swap(types);
+  m_breaklinesBuilt = false;
 
-    // update indices on breaklines
-    for (auto& b : m_io.m_outBreakLines)
+  for (auto& poly : m_outerPolys)
+  {
+    VecInt newPoly;
+    newPoly.reserve(poly.size());
+    for (auto idx : poly)
     {
-      for (auto& i : b)
-        i += nPts;
+      if (newPoly.empty() || newPoly.back() != a_oldToNew[idx])
+        newPoly.push_back(a_oldToNew[idx]);
     }
+    poly.swap(newPoly);
+  }
+} // XmStamperImpl::RemapOutputIndexes
+//------------------------------------------------------------------------------
+/// \brief Sorts the output points along a Hilbert curve and the triangles by
+/// the Hilbert index of their centroids so neighboring triangles and points
+/// are near each other in memory.
+//------------------------------------------------------------------------------
+void XmStamperImpl::HilbertSortOutputs()
+{
+  if (!m_tin || !m_outPts || m_outPts->empty())
+    return;
+  VecPt3d& pts(*m_outPts);
+  VecInt order;
+  XmUtil::HilbertOrder(pts, order);
+  VecInt oldToNew(order.size());
+  VecPt3d sorted(pts.size());
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    oldToNew[order[i]] = (int)i;
+    sorted[i] = pts[order[i]];
+  }
+  pts.swap(sorted);
+  // the adjacency is built once the triangles are sorted
+  bool adjacency = !m_tin->TrisAdjToPts().empty();
+  m_tin->TrisAdjToPts().clear();
+  RemapOutputIndexes(oldToNew);
+
+  VecInt& tris(m_tin->Triangles());
+  size_t nTris(tris.size() / 3);
+  Pt3d pMin(pts.front()), pMax(pMin);
+  for (const auto& p : pts)
+    gmAddToExtents(p, pMin, pMax);
+  std::vector<std::pair<uint64_t, int>> keys(nTris);
+  for (size_t t = 0; t < nTris; ++t)
+  {
+    const Pt3d &p0(pts[tris[3 * t]]), &p1(pts[tris[3 * t + 1]]), &p2(pts[tris[3 * t + 2]]);
+    double x = (p0.x + p1.x + p2.x) / 3, y = (p0.y + p1.y + p2.y) / 3;
+    keys[t] = std::make_pair(XmUtil::HilbertIndex(x, y, pMin, pMax), (int)t);
+  }
+  std::sort(keys.begin(), keys.end());
+  VecInt sortedTris(tris.size());
+  for (size_t t = 0; t < nTris; ++t)
+  {
+    const int* tri = &tris[3 * keys[t].second];
+    // start each triangle at its lowest point index. Keeps the orientation.
+    int first = (int)(std::min_element(tri, tri + 3) - tri);
+    for (int j = 0; j < 3; ++j)
+      sortedTris[3 * t + j] = tri[(first + j) % 3];
+  }
+  tris.swap(sortedTris);
+  if (adjacency)
+    m_tin->BuildTrisAdjToPts();
+} // XmStamperImpl::HilbertSortOutputs
+//------------------------------------------------------------------------------
+/// \brief returns breaklines created by the stamp operation. The nested form
+/// is only built when it is asked for.
+/// \return segments.
+//------------------------------------------------------------------------------
+const VecInt2d& XmStamperImpl::GetSegments()
+{
+  if (!m_breaklinesBuilt)
+  {
+    m_breaklines.resize(m_blOffsets.size() - 1);
+    for (size_t i = 0; i + 1 < m_blOffsets.size(); ++i)
     {
-      auto e1 = m_breaklines.end();
-      auto beg = m_io.m_outBreakLines.begin();
-      auto end = m_io.m_outBreakLines.end();
-      m_breaklines.insert(e1, beg, end);
+      auto beg = m_blPts.begin() + m_blOffsets[i];
+      auto end = m_blPts.begin() + m_blOffsets[i + 1];
+      m_breaklines[i].assign(beg, end);
     }
+    m_breaklinesBuilt = true;
   }
-  if (a_errors)
-    m_error = true;
-} // XmStamperImpl::AppendTinAndBreakLines
+  return m_breaklines;
+} // XmStamperImpl::GetSegments
+//------------------------------------------------------------------------------
+/// \brief Gets the TIN created by the stamp operation. When
+/// XmStamperIo::m_lazyOutputs was set the pieces of the stamp are triangulated
+/// the first time this is called.
+/// \return The TIN. Null if the stamp failed or was geometry only.
+//------------------------------------------------------------------------------
+BSHP<TrTin> XmStamperImpl::GetTin()
+{
+  if (m_error || m_geometryOnly)
+    return BSHP<TrTin>();
+  if (m_lazyTinBuilt)
+    return m_tin;
+  m_lazyTinBuilt = true;
+  if (!m_tin)
+    return BSHP<TrTin>();
+
+  VecInt& tris(m_tin->Triangles());
+  tris.clear();
+  m_tin->TrisAdjToPts().clear();
+  for (const auto& piece : m_pieces)
+  {
+    BSHP<TrTin> tin = TrTin::New();
+    auto beg = m_outPts->begin() + piece.m_offset;
+    tin->SetPoints(VecPt3d(beg, beg + piece.m_numPts));
+    TrTriangulatorPoints client(tin->Points(), tin->Triangles(), &tin->TrisAdjToPts());
+    client.SetObserver(m_observer);
+    if (!client.Triangulate() || tin->NumTriangles() < 1)
+    {
+      XM_LOG(xmlog::warning, "Unable to triangulate a piece of the stamp. Stamping operation "
+                             "aborted.");
+      m_error = true;
+      m_pieces.clear();
+      return BSHP<TrTin>();
+    }
+    AddBreaklinesAndClip(tin, piece.m_blOffsets, piece.m_blPts, piece.m_outerPoly);
+    tris.reserve(tris.size() + tin->Triangles().size());
+    for (auto t : tin->Triangles())
+      tris.push_back(t + (int)piece.m_offset);
+  }
+  m_pieces.clear();
+  return m_tin;
+} // XmStamperImpl::GetTin
+//------------------------------------------------------------------------------
+/// \brief Gets the triangles adjacent to each point of GetTin. Built the first
+/// time it is asked for.
+/// \return The triangles adjacent to each point.
+//------------------------------------------------------------------------------
+const VecInt2d& XmStamperImpl::GetTrisAdjToPts()
+{
+  static const VecInt2d empty;
+  BSHP<TrTin> tin = GetTin();
+  if (!tin)
+    return empty;
+  if (tin->TrisAdjToPts().size() != tin->Points().size())
+    tin->BuildTrisAdjToPts();
+  return tin->TrisAdjToPts();
+} // XmStamperImpl::GetTrisAdjToPts
+//------------------------------------------------------------------------------
+/// \brief Interpolates the elevations of GetTin to a raster. The volumes of
+/// the changes are available from GetVolumes.
+/// \param[in,out] a_raster The raster
+/// \param[in] a_stampingType 0 - cut, 1 - fill, 2 - both
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool XmStamperImpl::BurnRaster(XmStampRaster& a_raster, int a_stampingType)
+{
+  BSHP<TrTin> tin = GetTin();
+  XM_ENSURE_TRUE(tin, false);
+  return iInterpTinToRaster(tin, a_raster, a_stampingType, &m_volumes, m_rasterDepths);
+} // XmStamperImpl::BurnRaster
+//------------------------------------------------------------------------------
+/// \brief Sets the elevations of points from GetTin using the same rule as
+/// BurnRaster.
+/// \param[in,out] a_pts The points
+/// \param[in] a_stampingType 0 - cut, 1 - fill, 2 - both
+/// \return The number of points inside the stamp.
+//------------------------------------------------------------------------------
+size_t XmStamperImpl::StampPoints(VecPt3d& a_pts, int a_stampingType)
+{
+  BSHP<TrTin> tin = GetTin();
+  XM_ENSURE_TRUE(tin, 0);
+  return XmUtil::StampTinToPoints(tin->Points(), tin->Triangles(), a_stampingType, a_pts);
+} // XmStamperImpl::StampPoints
 
 //------------------------------------------------------------------------------
 /// \brief Creates a XmStamper class
@@ -582,4 +1206,379 @@ XmStamper::~XmStamper()
 {
 } // XmStamper::~XmStamper
 
-} // namespace xms
\ No newline at end of file
+} // namespace xms
+#ifdef CXX_TEST
+//------------------------------------------------------------------------------
+// Unit Tests
+//------------------------------------------------------------------------------
+using namespace xms;
+#include <xmsstamper/stamper/XmStamper.t.h>
+
+#include <xmscore/testing/TestTools.h>
+
+namespace
+{
+//------------------------------------------------------------------------------
+/// \brief Sets up the fill embankment from the stamping tutorial. The top is
+/// 10 wide at 15 and the side slopes are 1 down to 0 at x = -20 and 20. The
+/// center line goes from y = 0 to y = 10.
+/// \param[out] a_io The stamper inputs.
+//------------------------------------------------------------------------------
+void iBuildFillEmbankment(XmStamperIo& a_io)
+{
+  a_io.m_stampingType = 1;
+  a_io.m_centerLine = {{0, 0, 15}, {0, 10, 15}};
+  XmStampCrossSection cs;
+  cs.m_left = {{0, 15}, {5, 15}, {6, 14}};
+  cs.m_leftMax = 20;
+  cs.m_idxLeftShoulder = 1;
+  cs.m_right = cs.m_left;
+  cs.m_rightMax = cs.m_leftMax;
+  cs.m_idxRightShoulder = cs.m_idxLeftShoulder;
+  a_io.m_cs = {cs, cs};
+} // iBuildFillEmbankment
+//------------------------------------------------------------------------------
+/// \brief Gets the points of the fill embankment stamp.
+/// \return The points.
+//------------------------------------------------------------------------------
+VecPt3d iFillEmbankmentPts()
+{
+  return {{0, 0, 15},   {0, 10, 15}, {-5, 0, 15}, {-20, 0, 0}, {-5, 10, 15},
+          {-20, 10, 0}, {5, 0, 15},  {20, 0, 0},  {5, 10, 15}, {20, 10, 0}};
+} // iFillEmbankmentPts
+//------------------------------------------------------------------------------
+/// \brief Gets the elevation of the fill embankment stamp.
+/// \param[in] a_x The x location (-20 to 20).
+/// \return The elevation.
+//------------------------------------------------------------------------------
+double iFillEmbankmentZ(double a_x)
+{
+  return std::min(15.0, 20.0 - fabs(a_x));
+} // iFillEmbankmentZ
+//------------------------------------------------------------------------------
+/// \brief Builds a raster under the fill embankment with a cell center at each
+/// whole number location.
+/// \param[in] a_z The elevation of every cell.
+/// \return The raster.
+//------------------------------------------------------------------------------
+XmStampRaster iBuildRaster(double a_z)
+{
+  return XmStampRaster(41, 11, 1.0, 1.0, Pt3d(-20, 0), VecDbl(41 * 11, a_z), XM_NODATA);
+} // iBuildRaster
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmStamperUnitTests
+/// \brief Tests XmStamper
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Tests stamping without triangulating.
+//------------------------------------------------------------------------------
+void XmStamperUnitTests::testGeometryOnly()
+{
+  XmStamperIo io;
+  iBuildFillEmbankment(io);
+  io.m_geometryOnly = true;
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT(!io.m_outTin);
+  TS_ASSERT(!s->GetTin());
+  TS_ASSERT(s->GetTrisAdjToPts().empty());
+  TS_ASSERT_DELTA_VECPT3D(iFillEmbankmentPts(), io.m_outPoints, 1e-9);
+  TS_ASSERT_DELTA_VECPT3D(iFillEmbankmentPts(), s->GetPoints(), 1e-9);
+  VecInt baseOffsets = {0, 2, 7, 12, 14, 16, 18, 20};
+  TS_ASSERT_EQUALS_VEC(baseOffsets, io.m_outBreakLineOffsets);
+  VecInt basePts = {0, 1, 3, 2, 0, 6, 7, 5, 4, 1, 8, 9, 3, 5, 7, 9, 2, 4, 6, 8};
+  TS_ASSERT_EQUALS_VEC(basePts, io.m_outBreakLinePts);
+  VecInt baseTypes = {0, 3, 3, 3, 3, 2, 2};
+  TS_ASSERT_EQUALS_VEC(baseTypes, io.m_outBreakLineTypes);
+  TS_ASSERT_EQUALS_VEC(baseTypes, s->GetBreaklineTypes());
+  // left toe, last cross section, right toe and first cross section
+  VecInt2d basePolys = {{3, 5, 4, 1, 8, 9, 7, 6, 0, 2, 3}};
+  TS_ASSERT(basePolys == io.m_outOuterPolygons);
+
+  // the triangles are needed for the raster
+  io.m_raster = iBuildRaster(4.5);
+  s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT(io.m_outTin);
+  TS_ASSERT(io.m_outPoints.empty());
+  TS_ASSERT_DELTA(15.0, io.m_raster.m_vals[20], 1e-9);
+} // XmStamperUnitTests::testGeometryOnly
+//------------------------------------------------------------------------------
+/// \brief Tests that lazy outputs are triangulated when they are asked for and
+/// that options that need the TIN during DoStamp are rejected.
+//------------------------------------------------------------------------------
+void XmStamperUnitTests::testLazyOutputs()
+{
+  XmStamperIo io;
+  iBuildFillEmbankment(io);
+  io.m_lazyOutputs = true;
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+
+  // the points and breaklines are made but nothing is triangulated
+  TS_ASSERT(!io.m_outTin);
+  TS_ASSERT_DELTA_VECPT3D(iFillEmbankmentPts(), s->GetPoints(), 1e-9);
+  VecInt baseOffsets = {0, 2, 7, 12, 14, 16, 18, 20};
+  TS_ASSERT_EQUALS_VEC(baseOffsets, io.m_outBreakLineOffsets);
+  VecInt basePts = {0, 1, 3, 2, 0, 6, 7, 5, 4, 1, 8, 9, 3, 5, 7, 9, 2, 4, 6, 8};
+  TS_ASSERT_EQUALS_VEC(basePts, io.m_outBreakLinePts);
+  VecInt baseTypes = {0, 3, 3, 3, 3, 2, 2};
+  TS_ASSERT_EQUALS_VEC(baseTypes, io.m_outBreakLineTypes);
+  TS_ASSERT_EQUALS(1, s->GetFootprint().size());
+
+  BSHP<TrTin> tin = s->GetTin();
+  TS_ASSERT(tin);
+  if (!tin)
+    return;
+  TS_ASSERT(tin == s->GetTin());
+  TS_ASSERT_DELTA_VECPT3D(iFillEmbankmentPts(), tin->Points(), 1e-9);
+  TS_ASSERT_EQUALS(8, tin->NumTriangles());
+  TS_ASSERT_EQUALS(10, s->GetTrisAdjToPts().size());
+
+  // the cells at 4.5 within 15.5 of the center line are filled. Each row has
+  // 11 cells on the top and 10 on each side.
+  XmStampRaster raster(iBuildRaster(4.5));
+  TS_ASSERT(s->BurnRaster(raster, 1));
+  for (size_t i = 0; i < raster.m_vals.size(); ++i)
+    TS_ASSERT_DELTA(std::max(4.5, iFillEmbankmentZ(-20.0 + i % 41)), raster.m_vals[i], 1e-9);
+  TS_ASSERT_EQUALS(11 * 31, s->GetVolumes().m_numChangedCells);
+  TS_ASSERT_DELTA(11 * (11 * 10.5 + 2 * 50.0), s->GetVolumes().m_fillVolume, 1e-6);
+  TS_ASSERT_DELTA(0.0, s->GetVolumes().m_cutVolume, 1e-9);
+
+  VecPt3d pts = {{0, 5, XM_NODATA}, {12, 5, 4.5}, {50, 5, 3}};
+  TS_ASSERT_EQUALS(2, s->StampPoints(pts, 1));
+  VecPt3d basePts3d = {{0, 5, 15}, {12, 5, 8}, {50, 5, 3}};
+  TS_ASSERT_DELTA_VECPT3D(basePts3d, pts, 1e-9);
+
+  // the raster and target points can't be filled by DoStamp
+  XmStamperIo ioRaster;
+  iBuildFillEmbankment(ioRaster);
+  ioRaster.m_lazyOutputs = true;
+  ioRaster.m_raster = iBuildRaster(4.5);
+  s = XmStamper::New();
+  s->DoStamp(ioRaster);
+  TS_ASSERT(ioRaster.m_outBreakLineOffsets.empty());
+  TS_ASSERT(!s->GetTin());
+  TS_ASSERT_STACKED_ERRORS("---Lazy outputs can't fill the raster or target points. Use "
+                           "BurnRaster or StampPoints. Aborting stamp operation.\n\n");
+
+  // welding changes the points
+  XmStamperIo ioWeld;
+  iBuildFillEmbankment(ioWeld);
+  ioWeld.m_lazyOutputs = true;
+  ioWeld.m_weldPoints = true;
+  s = XmStamper::New();
+  s->DoStamp(ioWeld);
+  TS_ASSERT(ioWeld.m_outBreakLineOffsets.empty());
+  TS_ASSERT(!s->GetTin());
+  TS_ASSERT_STACKED_ERRORS("---Lazy outputs can't be welded, sorted, spliced or used for "
+                           "volumes. Aborting stamp operation.\n\n");
+} // XmStamperUnitTests::testLazyOutputs
+//------------------------------------------------------------------------------
+/// \brief Tests merging the coincident points of the stamp pieces.
+//------------------------------------------------------------------------------
+void XmStamperUnitTests::testWeldPoints()
+{
+  // the center line goes from 0 to 10 and crosses the flat bathymetry at 5 in
+  // the middle. Cut and fill keeps both pieces and they share the flat cross
+  // section at y = 5.
+  XmStamperIo io;
+  io.m_stampingType = 2;
+  io.m_centerLine = {{0, 0, 0}, {0, 10, 10}};
+  XmStampCrossSection cs;
+  cs.m_left = {{0, 0}, {5, 0}};
+  cs.m_leftMax = 5;
+  cs.m_right = cs.m_left;
+  cs.m_rightMax = cs.m_leftMax;
+  io.m_cs = {cs, cs};
+  io.m_cs[1].m_left = io.m_cs[1].m_right = {{0, 10}, {5, 10}};
+  io.m_bathymetry = TrTin::New();
+  io.m_bathymetry->Points() = {{-20, -5, 5}, {20, -5, 5}, {20, 20, 5}, {-20, 20, 5}};
+  io.m_bathymetry->Triangles() = {0, 1, 2, 0, 2, 3};
+  XmStamperIo ioWeld(io);
+  ioWeld.m_weldPoints = true;
+
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  s = XmStamper::New();
+  s->DoStamp(ioWeld);
+  TS_ASSERT(io.m_outTin && ioWeld.m_outTin);
+  if (!io.m_outTin || !ioWeld.m_outTin)
+    return;
+  TS_ASSERT_EQUALS(0, io.m_outNumWeldedPts);
+  TS_ASSERT_EQUALS(12, io.m_outTin->NumPoints());
+  TS_ASSERT_EQUALS(2, io.m_outOuterPolygons.size());
+
+  // the 3 points of the second piece at y = 5 are removed
+  TS_ASSERT_EQUALS(3, ioWeld.m_outNumWeldedPts);
+  VecPt3d basePts = {{0, 0, 0}, {0, 5, 5},   {-5, 0, 0},   {-5, 5, 5},  {5, 0, 0},
+                     {5, 5, 5}, {0, 10, 10}, {-5, 10, 10}, {5, 10, 10}};
+  TS_ASSERT_DELTA_VECPT3D(basePts, ioWeld.m_outTin->Points(), 1e-9);
+  TS_ASSERT_EQUALS(8, ioWeld.m_outTin->NumTriangles());
+  TS_ASSERT_EQUALS(2, ioWeld.m_outOuterPolygons.size());
+
+  // every triangle is valid and the area is the 10 by 10 stamp
+  const VecPt3d& pts(ioWeld.m_outTin->Points());
+  const VecInt& tris(ioWeld.m_outTin->Triangles());
+  double area(0.0);
+  for (size_t i = 0; i + 2 < tris.size(); i += 3)
+  {
+    TS_ASSERT(tris[i] != tris[i + 1] && tris[i + 1] != tris[i + 2] && tris[i + 2] != tris[i]);
+    const Pt3d &p0(pts[tris[i]]), &p1(pts[tris[i + 1]]), &p2(pts[tris[i + 2]]);
+    area += ((p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x)) / 2;
+  }
+  TS_ASSERT_DELTA(100.0, area, 1e-9);
+  for (auto idx : ioWeld.m_outBreakLinePts)
+    TS_ASSERT(idx >= 0 && idx < 9);
+} // XmStamperUnitTests::testWeldPoints
+//------------------------------------------------------------------------------
+/// \brief Tests sorting the outputs along a Hilbert curve.
+//------------------------------------------------------------------------------
+void XmStamperUnitTests::testHilbertOrder()
+{
+  XmStamperIo io;
+  iBuildFillEmbankment(io);
+  io.m_hilbertOrder = true;
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT(io.m_outTin);
+  if (!io.m_outTin)
+    return;
+
+  // the left side, the end at y = 10 and then the right side
+  VecPt3d basePts = {{-20, 0, 0}, {-5, 0, 15}, {-20, 10, 0}, {-5, 10, 15}, {0, 10, 15},
+                     {5, 10, 15}, {20, 10, 0}, {0, 0, 15},   {5, 0, 15},   {20, 0, 0}};
+  TS_ASSERT_DELTA_VECPT3D(basePts, io.m_outTin->Points(), 1e-9);
+  VecInt baseOffsets = {0, 2, 7, 12, 14, 16, 18, 20};
+  TS_ASSERT_EQUALS_VEC(baseOffsets, io.m_outBreakLineOffsets);
+  VecInt baseBlPts = {7, 4, 0, 1, 7, 8, 9, 2, 3, 4, 5, 6, 0, 2, 9, 6, 1, 3, 8, 5};
+  TS_ASSERT_EQUALS_VEC(baseBlPts, io.m_outBreakLinePts);
+  VecInt2d basePolys = {{0, 2, 3, 4, 5, 6, 9, 8, 7, 1, 0}};
+  TS_ASSERT(basePolys == io.m_outOuterPolygons);
+
+  // the triangles keep their orientation
+  const VecPt3d& pts(io.m_outTin->Points());
+  const VecInt& tris(io.m_outTin->Triangles());
+  TS_ASSERT_EQUALS(8, io.m_outTin->NumTriangles());
+  for (size_t i = 0; i + 2 < tris.size(); i += 3)
+  {
+    const Pt3d &p0(pts[tris[i]]), &p1(pts[tris[i + 1]]), &p2(pts[tris[i + 2]]);
+    TS_ASSERT((p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x) > 0.0);
+  }
+} // XmStamperUnitTests::testHilbertOrder
+//------------------------------------------------------------------------------
+/// \brief Tests stamping elevations onto points.
+//------------------------------------------------------------------------------
+void XmStamperUnitTests::testTargetPoints()
+{
+  // points without data take the stamp elevation, a fill keeps the higher
+  // elevation and points off the stamp don't change
+  XmStamperIo io;
+  iBuildFillEmbankment(io);
+  io.m_targetPoints = {{0, 5, XM_NODATA}, {12, 5, 4.5}, {-12, 5, 10}, {50, 5, 3}};
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT(io.m_outTin);
+  VecPt3d basePts = {{0, 5, 15}, {12, 5, 8}, {-12, 5, 10}, {50, 5, 3}};
+  TS_ASSERT_DELTA_VECPT3D(basePts, io.m_targetPoints, 1e-9);
+
+  // a cut keeps the lower elevation
+  VecPt3d pts = {{0, 5, XM_NODATA}, {12, 5, 4.5}, {-12, 5, 10}, {50, 5, 3}};
+  TS_ASSERT_EQUALS(3, s->StampPoints(pts, 0));
+  basePts = {{0, 5, 15}, {12, 5, 4.5}, {-12, 5, 8}, {50, 5, 3}};
+  TS_ASSERT_DELTA_VECPT3D(basePts, pts, 1e-9);
+} // XmStamperUnitTests::testTargetPoints
+//------------------------------------------------------------------------------
+/// \brief Tests the volumes computed when the raster is burned.
+//------------------------------------------------------------------------------
+void XmStamperUnitTests::testRasterVolumes()
+{
+  // raster at 4.5 inside the stamp from x = -19 to 19 and y = 1 to 9. The
+  // first row has no data. In each row with data the stamp is above the
+  // raster for 31 cells with 215.5 of fill and below it for 8 cells with 16
+  // of cut.
+  XmStampRaster raster(39, 9, 1.0, 1.0, Pt3d(-19, 1), VecDbl(39 * 9, 4.5), XM_NODATA);
+  for (int i = 0; i < 39; ++i)
+    raster.m_vals[i] = raster.m_noData;
+  const int baseChanged[] = {8 * 8 + 39, 8 * 31 + 39, 8 * 39 + 39};
+  const double baseCut[] = {8 * 16.0, 0.0, 8 * 16.0};
+  const double baseFill[] = {0.0, 8 * 215.5, 8 * 215.5};
+  // the depths of the cells at x = 0 and x = 19 of the second row
+  const double baseDepth0[] = {0.0, 10.5, 10.5};
+  const double baseDepth19[] = {-3.5, 0.0, -3.5};
+
+  for (int type = 0; type < 3; ++type)
+  {
+    XmStamperIo io;
+    iBuildFillEmbankment(io);
+    io.m_stampingType = type;
+    io.m_raster = raster;
+    io.m_rasterDepths = true;
+    BSHP<XmStamper> s = XmStamper::New();
+    s->DoStamp(io);
+    const XmStampVolumes& volumes(io.m_outVolumes);
+    TS_ASSERT_EQUALS(baseChanged[type], volumes.m_numChangedCells);
+    TS_ASSERT_DELTA(baseCut[type], volumes.m_cutVolume, 1e-6);
+    TS_ASSERT_DELTA(baseFill[type], volumes.m_fillVolume, 1e-6);
+    TS_ASSERT_DELTA(baseCut[type], s->GetVolumes().m_cutVolume, 1e-6);
+    TS_ASSERT_EQUALS(raster.m_vals.size(), volumes.m_depths.size());
+    if (raster.m_vals.size() != volumes.m_depths.size())
+      continue;
+    TS_ASSERT_EQUALS(raster.m_noData, volumes.m_depths[0]);
+    TS_ASSERT_DELTA(baseDepth0[type], volumes.m_depths[39 + 19], 1e-6);
+    TS_ASSERT_DELTA(baseDepth19[type], volumes.m_depths[39 + 38], 1e-6);
+  }
+} // XmStamperUnitTests::testRasterVolumes
+//------------------------------------------------------------------------------
+/// \brief Tests the exact volumes between the stamp TIN and the bathymetry.
+//------------------------------------------------------------------------------
+void XmStamperUnitTests::testTinVolumes()
+{
+  // flat bathymetry at 5 so the sides end at x = -15 and 15. Each 1 of center
+  // line has 10 * 10 of fill on the top and 10 * 10 / 2 on each side.
+  BSHP<TrTin> bathymetry = TrTin::New();
+  bathymetry->Points() = {{-30, -10, 5}, {30, -10, 5}, {30, 30, 5}, {-30, 30, 5}};
+  bathymetry->Triangles() = {0, 1, 2, 0, 2, 3};
+  XmStamperIo io;
+  iBuildFillEmbankment(io);
+  io.m_bathymetry = bathymetry;
+  io.m_tinVolumes = true;
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT(io.m_outTin);
+  TS_ASSERT_DELTA(2000.0, io.m_outTinFillVolume, 1e-6);
+  TS_ASSERT_DELTA(0.0, io.m_outTinCutVolume, 1e-6);
+
+  // the stamper keeps the indexed bathymetry for the next stamp
+  io.m_centerLine.back().y = 20;
+  s->DoStamp(io);
+  TS_ASSERT(io.m_outTin);
+  if (io.m_outTin)
+    TS_ASSERT_EQUALS(10, io.m_outTin->NumPoints());
+  TS_ASSERT_DELTA(4000.0, io.m_outTinFillVolume, 1e-6);
+  TS_ASSERT_DELTA(0.0, io.m_outTinCutVolume, 1e-6);
+
+  // the part of a bathymetry store under the stamp is used. The stamp can't be
+  // spliced into the store.
+  std::string fname(XMS_TEST_PATH + std::string("stamping/tinVolumesStore_out.bin"));
+  TS_ASSERT(XmBathymetryStore::WriteStore(fname, bathymetry));
+  XmStamperIo ioStore;
+  iBuildFillEmbankment(ioStore);
+  ioStore.m_bathymetryStore = XmBathymetryStore::New();
+  TS_ASSERT(ioStore.m_bathymetryStore->Open(fname));
+  ioStore.m_tinVolumes = true;
+  ioStore.m_spliceIntoBathymetry = true;
+  s = XmStamper::New();
+  s->DoStamp(ioStore);
+  TS_ASSERT(ioStore.m_outTin);
+  TS_ASSERT(!ioStore.m_outSplicedTin);
+  TS_ASSERT_DELTA(2000.0, ioStore.m_outTinFillVolume, 1e-6);
+  TS_ASSERT_DELTA(0.0, ioStore.m_outTinCutVolume, 1e-6);
+  TS_ASSERT_STACKED_ERRORS("---The stamp can't be spliced into a bathymetry store. Set "
+                           "m_bathymetry to splice the stamp.\n\n");
+} // XmStamperUnitTests::testTinVolumes
+
+#endif
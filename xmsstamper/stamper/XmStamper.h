@@ -27,7 +27,10 @@ namespace xms
 
 //----- Structs / Classes ------------------------------------------------------
 class XmStamperIo;
+class XmStampRaster;
+class XmStampVolumes;
 class Observer;
+class TrTin;
 
 //----- Function prototypes ----------------------------------------------------
 
@@ -48,9 +51,18 @@ public:
   virtual const VecPt3d& GetPoints() = 0;
   virtual const VecInt2d& GetSegments() = 0;
   virtual const VecInt& GetBreaklineTypes() = 0;
+  virtual const VecInt& GetSegmentOffsets() = 0;
+  virtual const VecInt& GetSegmentPoints() = 0;
 
   virtual void SetObserver(BSHP<Observer> a) = 0;
 
+  virtual BSHP<TrTin> GetTin() = 0;
+  virtual const VecInt2d& GetTrisAdjToPts() = 0;
+  virtual const VecInt2d& GetFootprint() = 0;
+  virtual bool BurnRaster(XmStampRaster& a_raster, int a_stampingType) = 0;
+  virtual size_t StampPoints(VecPt3d& a_pts, int a_stampingType) = 0;
+  virtual const XmStampVolumes& GetVolumes() = 0;
+
 private:
   XM_DISALLOW_COPY_AND_ASSIGN(XmStamper);
   /// \endcond
@@ -15,7 +15,20 @@
 #include <xmsstamper/stamper/XmStamperIo.h>
 
 // 3. Standard library headers
+#include <algorithm>
 #include <array>
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv> // std::to_chars, std::from_chars
+#endif
+#endif
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream> // std::ofstream
 #include <sstream> // std::stringstream
 
@@ -39,6 +52,24 @@
 namespace xms
 {
 //----- Constants / Enumerations -----------------------------------------------
+namespace
+{
+const char BINARY_TIN_MAGIC[8] = {'X', 'M', 'S', 'T', 'I', 'N', 'B', '\0'}; ///< binary TIN signature
+const uint32_t BINARY_TIN_VERSION = 1;         ///< binary TIN format version
+const uint32_t BINARY_TIN_CANONICAL = 1 << 0;  ///< flag: triangles are in canonical order
+const uint32_t BINARY_TIN_ADJACENCY = 1 << 1;  ///< flag: triangles adjacent to points follow
+const char BINARY_IO_MAGIC[8] = {'X', 'M', 'S', 'S', 'T', 'I', 'O', '\0'}; ///< binary XmStamperIo signature
+const uint32_t BINARY_IO_VERSION = 1; ///< binary XmStamperIo format version
+const uint32_t BINARY_IO_STRIPS = 1 << 0;     ///< flag: m_stripTriangulation
+const uint32_t BINARY_IO_GEOMETRY = 1 << 1;   ///< flag: m_geometryOnly
+const uint32_t BINARY_IO_LAZY = 1 << 2;       ///< flag: m_lazyOutputs
+const uint32_t BINARY_IO_WELD = 1 << 3;       ///< flag: m_weldPoints
+const uint32_t BINARY_IO_HILBERT = 1 << 4;    ///< flag: m_hilbertOrder
+const uint32_t BINARY_IO_SPLICE = 1 << 5;     ///< flag: m_spliceIntoBathymetry
+const uint32_t BINARY_IO_DEPTHS = 1 << 6;     ///< flag: m_rasterDepths
+const uint32_t BINARY_IO_VOLUMES = 1 << 7;    ///< flag: m_tinVolumes
+const uint32_t BINARY_IO_FLAT_BL = 1 << 8;    ///< flag: m_flatBreaklinesOnly
+} // unnamed namespace
 
 //----- Classes / Structs ------------------------------------------------------
 
@@ -62,27 +93,209 @@ int& iPrecision()
   return m_precision;
 } // iPrecision
 //------------------------------------------------------------------------------
+/// \brief Appends a double in fixed notation with the given number of
+/// decimals. Same characters as printf("%.*f").
+/// \param[in,out] a_str: the string that is appended to
+/// \param[in] a_val: the value
+/// \param[in] a_decimals: the number of digits after the decimal point
+//------------------------------------------------------------------------------
+void iAppendFixed(std::string &a_str, double a_val, int a_decimals)
+{
+  char buf[512];
+#if defined(__cpp_lib_to_chars)
+  std::to_chars_result r =
+    std::to_chars(buf, buf + sizeof(buf), a_val, std::chars_format::fixed, a_decimals);
+  if (r.ec == std::errc())
+  {
+    a_str.append(buf, r.ptr);
+    return;
+  }
+#endif
+  int len = snprintf(buf, sizeof(buf), "%.*f", a_decimals, a_val);
+  if (len > 0 && len < (int)sizeof(buf))
+    a_str.append(buf, (size_t)len);
+  else
+    a_str += std::to_string(a_val);
+} // iAppendFixed
+//------------------------------------------------------------------------------
+/// \brief Appends an integer right justified in a field of the given width
+/// \param[in,out] a_str: the string that is appended to
+/// \param[in] a_val: the value
+/// \param[in] a_width: the minimum field width (0 for none)
+//------------------------------------------------------------------------------
+void iAppendInt(std::string &a_str, long long a_val, size_t a_width = 0)
+{
+  char buf[32];
+  char *end = buf;
+#if defined(__cpp_lib_to_chars)
+  end = std::to_chars(buf, buf + sizeof(buf), a_val).ptr;
+#else
+  end += snprintf(buf, sizeof(buf), "%lld", a_val);
+#endif
+  size_t len = (size_t)(end - buf);
+  if (len < a_width)
+    a_str.append(a_width - len, ' ');
+  a_str.append(buf, len);
+} // iAppendInt
+//------------------------------------------------------------------------------
+/// \brief Appends a double using the defined precision. Produces the same
+/// characters as STRstd(a_, -1, iPrecision(), STR_FULLWIDTH): as many decimals
+/// as fit in the field width, trailing zeros removed (keeping one), and right
+/// justified. Values that do not fit the field go through STRstd.
+/// \param[in,out] a_str: the string that is appended to
+/// \param[in] a_: the double that is converted to a string
+//------------------------------------------------------------------------------
+void iAppendDbl(std::string &a_str, double a_)
+{
+  const int width = iPrecision();
+  const double absVal = std::fabs(a_);
+  // STRstd switches notation for values that do not fit the field
+  if (!std::isfinite(a_) || absVal >= 1e15 || width < 3 || width > 64 ||
+      (a_ == 0.0 && std::signbit(a_)))
+  {
+    a_str += STRstd(a_, -1, width, STR_FULLWIDTH);
+    return;
+  }
+  int intDigits = 1;
+  for (double p = 10.0; absVal >= p; p *= 10.0)
+    ++intDigits;
+  const int decimals = width - 1 - intDigits - (a_ < 0.0 ? 1 : 0);
+  if (decimals < 1)
+  {
+    a_str += STRstd(a_, -1, width, STR_FULLWIDTH);
+    return;
+  }
+
+  std::string num;
+  iAppendFixed(num, a_, decimals);
+  size_t last = num.find_last_not_of('0');
+  if (last != std::string::npos && num[last] == '.')
+    ++last;
+  num.resize(last + 1);
+  // rounding added a digit, or a small value rounded to zero: let STRstd decide
+  const int roundedIntDigits = (int)num.find('.') - (a_ < 0.0 ? 1 : 0);
+  if (roundedIntDigits != intDigits || (int)num.size() > width ||
+      (a_ != 0.0 && (num == "0.0" || num == "-0.0")))
+  {
+    a_str += STRstd(a_, -1, width, STR_FULLWIDTH);
+    return;
+  }
+  if ((int)num.size() < width)
+    a_str.append(width - num.size(), ' ');
+  a_str += num;
+} // iAppendDbl
+//------------------------------------------------------------------------------
 /// \brief Uses the defined precision to convert a double to a string using the
-/// STRstd function.
+/// STRstd function format.
 /// \param[in] a_: the double that is converted to a string
 /// \return the string representation of the double
 //------------------------------------------------------------------------------
 std::string iDblToStr(double a_)
 {
-  return STRstd(a_, -1, iPrecision(), STR_FULLWIDTH);
+  std::string str;
+  iAppendDbl(str, a_);
+  return str;
 } // iDblToStr
 //------------------------------------------------------------------------------
+/// \brief Reads the next whitespace delimited token from a stream without
+/// going through the stream's formatted input.
+/// \param[in] a_is: the stream
+/// \param[out] a_buf: buffer for the token. Null terminated.
+/// \param[in] a_bufSize: size of a_buf
+/// \return the token length. 0 if no token (failbit is set on the stream).
+//------------------------------------------------------------------------------
+size_t iReadToken(std::istream &a_is, char *a_buf, size_t a_bufSize)
+{
+  std::istream::sentry sentry(a_is); // skips leading whitespace
+  if (!sentry)
+    return 0;
+  std::streambuf *sb = a_is.rdbuf();
+  size_t len = 0;
+  int c = sb->sgetc();
+  while (c != EOF && !std::isspace(c) && len + 1 < a_bufSize)
+  {
+    a_buf[len++] = (char)c;
+    c = sb->snextc();
+  }
+  a_buf[len] = '\0';
+  if (c == EOF)
+    a_is.setstate(std::ios::eofbit);
+  if (len == 0)
+    a_is.setstate(std::ios::failbit);
+  return len;
+} // iReadToken
+//------------------------------------------------------------------------------
+/// \brief Reads a double from a stream. Faster replacement for operator>>.
+/// \param[in] a_is: the stream
+/// \param[out] a_val: the value
+/// \return true on success. false sets failbit on the stream.
+//------------------------------------------------------------------------------
+bool iReadDbl(std::istream &a_is, double &a_val)
+{
+  char buf[128];
+  size_t len = iReadToken(a_is, buf, sizeof(buf));
+  if (len == 0)
+    return false;
+  const char *first = buf[0] == '+' ? buf + 1 : buf;
+#if defined(__cpp_lib_to_chars)
+  std::from_chars_result r = std::from_chars(first, buf + len, a_val);
+  bool ok = r.ec == std::errc() && r.ptr == buf + len;
+#else
+  char *end = nullptr;
+  a_val = strtod(first, &end);
+  bool ok = end == buf + len;
+#endif
+  if (!ok)
+    a_is.setstate(std::ios::failbit);
+  return ok;
+} // iReadDbl
+//------------------------------------------------------------------------------
+/// \brief Reads an int from a stream. Faster replacement for operator>>.
+/// \param[in] a_is: the stream
+/// \param[out] a_val: the value
+/// \return true on success. false sets failbit on the stream.
+//------------------------------------------------------------------------------
+bool iReadInt(std::istream &a_is, int &a_val)
+{
+  char buf[32];
+  size_t len = iReadToken(a_is, buf, sizeof(buf));
+  if (len == 0)
+    return false;
+  const char *first = buf[0] == '+' ? buf + 1 : buf;
+#if defined(__cpp_lib_to_chars)
+  std::from_chars_result r = std::from_chars(first, buf + len, a_val);
+  bool ok = r.ec == std::errc() && r.ptr == buf + len;
+#else
+  char *end = nullptr;
+  long val = strtol(first, &end, 10);
+  bool ok = end == buf + len && val >= INT_MIN && val <= INT_MAX;
+  a_val = (int)val;
+#endif
+  if (!ok)
+    a_is.setstate(std::ios::failbit);
+  return ok;
+} // iReadInt
+//------------------------------------------------------------------------------
 /// \brief Writes a VecDbl to an ASCII file
 //------------------------------------------------------------------------------
 void iWriteVecDblToFile(std::ofstream &a_file, const std::string &a_cardName, const VecDbl &a_vals)
 {
   XM_ENSURE_TRUE(a_file.is_open());
-  a_file << a_cardName + " " << a_vals.size() << " ";
+  std::string buf(a_cardName + " ");
+  iAppendInt(buf, (long long)a_vals.size());
+  buf += " ";
   for (const auto &val : a_vals)
   {
-    a_file << iDblToStr(val) << " ";
+    iAppendDbl(buf, val);
+    buf += " ";
+    if (buf.size() > 60000)
+    {
+      a_file.write(buf.data(), buf.size());
+      buf.clear();
+    }
   }
-  a_file << "\n";
+  buf += "\n";
+  a_file.write(buf.data(), buf.size());
 } // iWriteVecDblToFile
 //------------------------------------------------------------------------------
 /// \brief Reads a VecDbl from an ASCII file
@@ -91,11 +304,11 @@ bool iReadVecDblFromFile(std::ifstream &a_file, VecDbl &a_vals)
 {
   XM_ENSURE_TRUE(a_file.is_open(), false);
   int num(0);
-  XM_ENSURE_TRUE(a_file >> num, false);
+  XM_ENSURE_TRUE(iReadInt(a_file, num), false);
   a_vals.assign(num, 0);
   for (auto &val : a_vals)
   {
-    XM_ENSURE_TRUE(a_file >> val, false);
+    XM_ENSURE_TRUE(iReadDbl(a_file, val), false);
   }
   return true;
 } // iReadVecDblFromFile
@@ -105,11 +318,24 @@ bool iReadVecDblFromFile(std::ifstream &a_file, VecDbl &a_vals)
 void iWriteVecPt3dToFile(std::ofstream &a_file, const std::string &a_cardName, const VecPt3d &a_pts)
 {
   XM_ENSURE_TRUE(a_file.is_open());
-  a_file << a_cardName + " " << a_pts.size() << "\n";
+  std::string buf(a_cardName + " ");
+  iAppendInt(buf, (long long)a_pts.size());
+  buf += "\n";
   for (const auto &pt : a_pts)
   {
-    a_file << iDblToStr(pt.x) << " " << iDblToStr(pt.y) << " " << iDblToStr(pt.z) << "\n";
+    iAppendDbl(buf, pt.x);
+    buf += " ";
+    iAppendDbl(buf, pt.y);
+    buf += " ";
+    iAppendDbl(buf, pt.z);
+    buf += "\n";
+    if (buf.size() > 60000)
+    {
+      a_file.write(buf.data(), buf.size());
+      buf.clear();
+    }
   }
+  a_file.write(buf.data(), buf.size());
 } // iWriteVecPt3dToFile
 //------------------------------------------------------------------------------
 /// \brief Reads a VecPt3d from an ASCII file
@@ -118,14 +344,14 @@ bool iReadVecPt3dFromFile(std::ifstream &a_file, VecPt3d &a_pts)
 {
   XM_ENSURE_TRUE(a_file.is_open(), false);
   int numPts(0);
-  XM_ENSURE_TRUE(a_file >> numPts, false);
+  XM_ENSURE_TRUE(iReadInt(a_file, numPts), false);
   a_pts.assign(numPts, xms::Pt3d());
   for (auto &pt : a_pts)
   {
-    XM_ENSURE_TRUE(a_file >> pt.x >> pt.y, false);
+    XM_ENSURE_TRUE(iReadDbl(a_file, pt.x) && iReadDbl(a_file, pt.y), false);
     if (a_file.peek() != '\n')
     {
-      XM_ENSURE_TRUE(a_file >> pt.z, false);
+      XM_ENSURE_TRUE(iReadDbl(a_file, pt.z), false);
     }
   }
   return true;
@@ -149,7 +375,7 @@ bool iReadVecInt2dFromFile(std::ifstream &a_file, VecInt2d &a_vals)
 {
   XM_ENSURE_TRUE(a_file.is_open(), false);
   int num(0);
-  XM_ENSURE_TRUE(a_file >> num, false);
+  XM_ENSURE_TRUE(iReadInt(a_file, num), false);
   a_vals.assign(num, VecInt());
   for (auto &valArray : a_vals)
   {
@@ -163,13 +389,21 @@ bool iReadVecInt2dFromFile(std::ifstream &a_file, VecInt2d &a_vals)
 void iWriteVecIntToFile(std::ofstream &a_file, const std::string &a_cardName, const VecInt &a_vals)
 {
   XM_ENSURE_TRUE(a_file.is_open());
-  const std::string card(a_cardName.empty() ? "" : a_cardName + " ");
-  a_file << card << a_vals.size() << " ";
+  std::string buf(a_cardName.empty() ? "" : a_cardName + " ");
+  iAppendInt(buf, (long long)a_vals.size());
+  buf += " ";
   for (const auto &val : a_vals)
   {
-    a_file << val << " ";
+    iAppendInt(buf, val);
+    buf += " ";
+    if (buf.size() > 60000)
+    {
+      a_file.write(buf.data(), buf.size());
+      buf.clear();
+    }
   }
-  a_file << "\n";
+  buf += "\n";
+  a_file.write(buf.data(), buf.size());
 } // iWriteVecIntToFile
 //------------------------------------------------------------------------------
 /// \brief Reads a VecInt from an ASCII file
@@ -178,34 +412,28 @@ bool iReadVecIntFromFile(std::ifstream &a_file, VecInt &a_vals)
 {
   XM_ENSURE_TRUE(a_file.is_open(), false);
   int num(0);
-  XM_ENSURE_TRUE(a_file >> num, false);
+  XM_ENSURE_TRUE(iReadInt(a_file, num), false);
   a_vals.assign(num, 0);
   for (auto &val : a_vals)
   {
-    XM_ENSURE_TRUE(a_file >> val, false);
+    XM_ENSURE_TRUE(iReadInt(a_file, val), false);
   }
   return true;
 } // iReadVecIntFromFile
 //------------------------------------------------------------------------------
-/// \brief Writes a Tin to an ASCII file
+/// \brief Puts triangles in a canonical order so output does not depend on
+/// the triangulation order. Each triangle starts with its lowest point index
+/// (keeping its orientation) and the triangles are sorted.
+/// \param[in] a_tris The triangles (3 point indices each)
+/// \param[out] a_sorted The triangles in canonical order
 //------------------------------------------------------------------------------
-void iWriteTinToFile(std::ofstream &a_file, const std::string &a_cardName, const BSHP<const TrTin> &a_tin)
+void iCanonicalTriangles(const VecInt& a_tris, VecInt& a_sorted)
 {
-  XM_ENSURE_TRUE(a_file.is_open());
-  a_file << a_cardName + "\n";
-  const VecPt3d& points = a_tin->Points();
-  iWriteVecPt3dToFile(a_file, "POINTS", points);
-
-  VecInt vTri = a_tin->Triangles();
   std::vector<std::array<int, 3>> sortableTris;
-  // sort the triangles so that the point with the lowest index is first and then sort all
-  // triangles
-  for (size_t i = 0; i < vTri.size(); i += 3)
+  sortableTris.reserve(a_tris.size() / 3);
+  for (size_t i = 0; i + 2 < a_tris.size(); i += 3)
   {
-    std::array<int, 3> tri = { -1, -1, -1 };
-    tri[0] = vTri[i + 0];
-    tri[1] = vTri[i + 1];
-    tri[2] = vTri[i + 2];
+    std::array<int, 3> tri = {a_tris[i + 0], a_tris[i + 1], a_tris[i + 2]};
     auto minIter = tri.begin();
     if (tri[1] < tri[0] && tri[1] < tri[2])
       minIter += 1;
@@ -215,20 +443,44 @@ void iWriteTinToFile(std::ofstream &a_file, const std::string &a_cardName, const
     sortableTris.push_back(tri);
   }
   std::sort(sortableTris.begin(), sortableTris.end());
-  auto it = sortableTris.begin();
-  for (size_t i = 0; i < vTri.size(); i += 3, ++it)
+  a_sorted.resize(sortableTris.size() * 3);
+  for (size_t i = 0; i < sortableTris.size(); ++i)
   {
-    vTri[i + 0] = (*it)[0];
-    vTri[i + 1] = (*it)[1];
-    vTri[i + 2] = (*it)[2];
+    a_sorted[3 * i + 0] = sortableTris[i][0];
+    a_sorted[3 * i + 1] = sortableTris[i][1];
+    a_sorted[3 * i + 2] = sortableTris[i][2];
   }
-  a_file << "TRIANGLES " << vTri.size() << "\n";
+} // iCanonicalTriangles
+//------------------------------------------------------------------------------
+/// \brief Writes a Tin to an ASCII file
+//------------------------------------------------------------------------------
+void iWriteTinToFile(std::ofstream &a_file, const std::string &a_cardName, const BSHP<const TrTin> &a_tin)
+{
+  XM_ENSURE_TRUE(a_file.is_open());
+  a_file << a_cardName + "\n";
+  const VecPt3d& points = a_tin->Points();
+  iWriteVecPt3dToFile(a_file, "POINTS", points);
+
+  VecInt vTri;
+  iCanonicalTriangles(a_tin->Triangles(), vTri);
+  std::string buf("TRIANGLES ");
+  iAppendInt(buf, (long long)vTri.size());
+  buf += "\n";
   for (size_t i = 0; i < vTri.size(); i += 3)
   {
-    a_file << std::setw(10) << vTri[i + 0] << " "
-           << std::setw(10) << vTri[i + 1] << " "
-           << std::setw(10) << vTri[i + 2] << "\n";
+    iAppendInt(buf, vTri[i + 0], 10);
+    buf += " ";
+    iAppendInt(buf, vTri[i + 1], 10);
+    buf += " ";
+    iAppendInt(buf, vTri[i + 2], 10);
+    buf += "\n";
+    if (buf.size() > 60000)
+    {
+      a_file.write(buf.data(), buf.size());
+      buf.clear();
+    }
   }
+  a_file.write(buf.data(), buf.size());
   //const VecInt2d& trisAdjToPts = a_tin->TrisAdjToPts();
   a_file << "TRIS_ADJ_TO_PTS 0\n";
   //iWriteVecInt2dToFile(a_file, "TRIS_ADJ_TO_PTS", trisAdjToPts);
@@ -253,6 +505,449 @@ bool iReadTinFromFile(std::ifstream &a_file, const BSHP<TrTin> &a_tin)
   a_tin->BuildTrisAdjToPts();
   return true;
 } // iReadTinFromFile
+//------------------------------------------------------------------------------
+/// \brief Writes a value to a binary stream
+/// \param[in] a_os The stream
+/// \param[in] a_val The value
+//------------------------------------------------------------------------------
+template <typename T>
+void iWriteBin(std::ostream &a_os, const T &a_val)
+{
+  a_os.write(reinterpret_cast<const char *>(&a_val), sizeof(T));
+} // iWriteBin
+//------------------------------------------------------------------------------
+/// \brief Reads a value from a binary stream
+/// \param[in] a_is The stream
+/// \param[out] a_val The value
+/// \return true if the value was read.
+//------------------------------------------------------------------------------
+template <typename T>
+bool iReadBin(std::istream &a_is, T &a_val)
+{
+  a_is.read(reinterpret_cast<char *>(&a_val), sizeof(T));
+  return a_is.good();
+} // iReadBin
+//------------------------------------------------------------------------------
+/// \brief Checks that a stream has enough bytes left for a number of items so
+/// a corrupt count is not used to size a buffer. Streams that can't tell
+/// their position are only checked for a negative count.
+/// \param[in] a_is The stream
+/// \param[in] a_count The number of items
+/// \param[in] a_itemSize The size of each item in bytes
+/// \return true if the items fit in the rest of the stream.
+//------------------------------------------------------------------------------
+bool iBytesLeft(std::istream &a_is, int64_t a_count, size_t a_itemSize)
+{
+  if (a_count < 0)
+    return false;
+  std::streampos pos = a_is.tellg();
+  if (pos < 0)
+    return true;
+  a_is.seekg(0, std::ios::end);
+  std::streamoff left = a_is.tellg() - pos;
+  a_is.seekg(pos);
+  return a_is.good() && a_count <= (int64_t)(left / (std::streamoff)a_itemSize);
+} // iBytesLeft
+//------------------------------------------------------------------------------
+/// \brief Writes a Tin to a binary stream. The layout (native byte order) is
+/// a header (signature, version, flags, number of points, number of
+/// triangles, number of adjacency entries) followed by the point array
+/// (x, y, z doubles), the triangle array (3 int32 per triangle) and optionally
+/// the triangles adjacent to each point as offsets followed by the entries.
+/// \param[in] a_os The output stream
+/// \param[in] a_tin The TIN
+/// \param[in] a_canonical Put the triangles in canonical order (sorted) so
+/// the output is deterministic
+/// \param[in] a_adjacency Write the triangles adjacent to points so they do
+/// not need to be rebuilt when read
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iWriteTinToBinary(std::ostream &a_os,
+                       const TrTin &a_tin,
+                       bool a_canonical,
+                       bool a_adjacency)
+{
+  static_assert(sizeof(Pt3d) == 3 * sizeof(double), "Pt3d must be 3 packed doubles");
+  static_assert(sizeof(int) == sizeof(int32_t), "int must be 32 bits");
+  const VecPt3d &pts(a_tin.Points());
+  const VecInt *tris(&a_tin.Triangles());
+  VecInt sorted;
+  if (a_canonical)
+  {
+    iCanonicalTriangles(*tris, sorted);
+    tris = &sorted;
+  }
+  // adjacency refers to triangle indices so it is only valid for the
+  // triangles in their original order
+  const VecInt2d &adj(a_tin.TrisAdjToPts());
+  bool writeAdj = a_adjacency && !a_canonical && adj.size() == pts.size();
+  int64_t adjSize(0);
+  if (writeAdj)
+  {
+    for (const auto &v : adj)
+      adjSize += (int64_t)v.size();
+  }
+
+  uint32_t flags = (a_canonical ? BINARY_TIN_CANONICAL : 0) | (writeAdj ? BINARY_TIN_ADJACENCY : 0);
+  a_os.write(BINARY_TIN_MAGIC, sizeof(BINARY_TIN_MAGIC));
+  iWriteBin(a_os, BINARY_TIN_VERSION);
+  iWriteBin(a_os, flags);
+  iWriteBin(a_os, (int64_t)pts.size());
+  iWriteBin(a_os, (int64_t)(tris->size() / 3));
+  iWriteBin(a_os, adjSize);
+  if (!pts.empty())
+    a_os.write(reinterpret_cast<const char *>(pts.data()), pts.size() * sizeof(Pt3d));
+  if (!tris->empty())
+    a_os.write(reinterpret_cast<const char *>(tris->data()), (tris->size() / 3) * 3 * sizeof(int));
+  if (writeAdj)
+  {
+    int64_t offset(0);
+    iWriteBin(a_os, offset);
+    for (const auto &v : adj)
+    {
+      offset += (int64_t)v.size();
+      iWriteBin(a_os, offset);
+    }
+    for (const auto &v : adj)
+    {
+      if (!v.empty())
+        a_os.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(int));
+    }
+  }
+  return a_os.good();
+} // iWriteTinToBinary
+//------------------------------------------------------------------------------
+/// \brief Reads a Tin written by iWriteTinToBinary. The point and triangle
+/// arrays are read in single blocks straight into the TIN's vectors.
+/// \param[in] a_is The input stream
+/// \param[in,out] a_tin The TIN
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iReadTinFromBinary(std::istream &a_is, const BSHP<TrTin> &a_tin)
+{
+  XM_ENSURE_TRUE(a_tin, false);
+  char magic[sizeof(BINARY_TIN_MAGIC)];
+  a_is.read(magic, sizeof(magic));
+  XM_ENSURE_TRUE(a_is.good() && memcmp(magic, BINARY_TIN_MAGIC, sizeof(magic)) == 0, false);
+  uint32_t version(0), flags(0);
+  int64_t numPts(0), numTris(0), adjSize(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, version) && version == BINARY_TIN_VERSION, false);
+  XM_ENSURE_TRUE(iReadBin(a_is, flags), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, numPts) && iReadBin(a_is, numTris) && iReadBin(a_is, adjSize),
+                 false);
+  // indexes are 32 bit and the counts must fit in the rest of the stream
+  XM_ENSURE_TRUE(numPts >= 0 && numPts <= INT_MAX && numTris >= 0 && numTris <= INT_MAX / 3 &&
+                   adjSize >= 0 && adjSize <= INT_MAX,
+                 false);
+  XM_ENSURE_TRUE(iBytesLeft(a_is, numPts, sizeof(Pt3d)), false);
+
+  VecPt3d &pts(a_tin->Points());
+  VecInt &tris(a_tin->Triangles());
+  pts.resize((size_t)numPts);
+  if (numPts > 0)
+    a_is.read(reinterpret_cast<char *>(pts.data()), pts.size() * sizeof(Pt3d));
+  XM_ENSURE_TRUE(a_is.good() && iBytesLeft(a_is, numTris * 3, sizeof(int)), false);
+  tris.resize((size_t)numTris * 3);
+  if (numTris > 0)
+    a_is.read(reinterpret_cast<char *>(tris.data()), tris.size() * sizeof(int));
+  XM_ENSURE_TRUE(a_is.good(), false);
+  for (auto idx : tris)
+  {
+    XM_ENSURE_TRUE(idx >= 0 && idx < numPts, false);
+  }
+
+  if (flags & BINARY_TIN_ADJACENCY)
+  {
+    XM_ENSURE_TRUE(iBytesLeft(a_is, numPts + 1, sizeof(int64_t)), false);
+    std::vector<int64_t> offsets((size_t)numPts + 1);
+    a_is.read(reinterpret_cast<char *>(offsets.data()), offsets.size() * sizeof(int64_t));
+    XM_ENSURE_TRUE(a_is.good() && offsets.front() == 0 && offsets.back() == adjSize, false);
+    for (size_t i = 0; i + 1 < offsets.size(); ++i)
+    {
+      XM_ENSURE_TRUE(offsets[i] <= offsets[i + 1], false);
+    }
+    XM_ENSURE_TRUE(iBytesLeft(a_is, adjSize, sizeof(int)), false);
+    VecInt entries((size_t)adjSize);
+    if (adjSize > 0)
+      a_is.read(reinterpret_cast<char *>(entries.data()), entries.size() * sizeof(int));
+    XM_ENSURE_TRUE(a_is.good(), false);
+    for (auto tri : entries)
+    {
+      XM_ENSURE_TRUE(tri >= 0 && tri < numTris, false);
+    }
+    VecInt2d &adj(a_tin->TrisAdjToPts());
+    adj.resize((size_t)numPts);
+    for (size_t i = 0; i < adj.size(); ++i)
+      adj[i].assign(entries.begin() + offsets[i], entries.begin() + offsets[i + 1]);
+  }
+  else
+  {
+    a_tin->BuildTrisAdjToPts();
+  }
+  return true;
+} // iReadTinFromBinary
+//------------------------------------------------------------------------------
+/// \brief Writes a VecPt3d to a binary stream as a count and a point block
+/// \param[in] a_os The stream
+/// \param[in] a_pts The points
+//------------------------------------------------------------------------------
+void iWriteVecPt3dBin(std::ostream &a_os, const VecPt3d &a_pts)
+{
+  iWriteBin(a_os, (int64_t)a_pts.size());
+  if (!a_pts.empty())
+    a_os.write(reinterpret_cast<const char *>(a_pts.data()), a_pts.size() * sizeof(Pt3d));
+} // iWriteVecPt3dBin
+//------------------------------------------------------------------------------
+/// \brief Reads a VecPt3d written by iWriteVecPt3dBin
+/// \param[in] a_is The stream
+/// \param[out] a_pts The points
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iReadVecPt3dBin(std::istream &a_is, VecPt3d &a_pts)
+{
+  int64_t num(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, num) && iBytesLeft(a_is, num, sizeof(Pt3d)), false);
+  a_pts.resize((size_t)num);
+  if (num > 0)
+    a_is.read(reinterpret_cast<char *>(a_pts.data()), a_pts.size() * sizeof(Pt3d));
+  return a_is.good();
+} // iReadVecPt3dBin
+//------------------------------------------------------------------------------
+/// \brief Writes a vector of plain values to a binary stream as a count and
+/// a block of values
+/// \param[in] a_os The stream
+/// \param[in] a_vals The values
+//------------------------------------------------------------------------------
+template <typename T>
+void iWriteVecBin(std::ostream &a_os, const std::vector<T> &a_vals)
+{
+  iWriteBin(a_os, (int64_t)a_vals.size());
+  if (!a_vals.empty())
+    a_os.write(reinterpret_cast<const char *>(a_vals.data()), a_vals.size() * sizeof(T));
+} // iWriteVecBin
+//------------------------------------------------------------------------------
+/// \brief Reads a vector written by iWriteVecBin
+/// \param[in] a_is The stream
+/// \param[out] a_vals The values
+/// \return true on success.
+//------------------------------------------------------------------------------
+template <typename T>
+bool iReadVecBin(std::istream &a_is, std::vector<T> &a_vals)
+{
+  int64_t num(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, num) && iBytesLeft(a_is, num, sizeof(T)), false);
+  a_vals.resize((size_t)num);
+  if (num > 0)
+    a_is.read(reinterpret_cast<char *>(a_vals.data()), a_vals.size() * sizeof(T));
+  return a_is.good();
+} // iReadVecBin
+//------------------------------------------------------------------------------
+/// \brief Writes a VecInt2d to a binary stream as a count and each vector
+/// \param[in] a_os The stream
+/// \param[in] a_vals The vectors
+//------------------------------------------------------------------------------
+void iWriteVecInt2dBin(std::ostream &a_os, const VecInt2d &a_vals)
+{
+  iWriteBin(a_os, (int64_t)a_vals.size());
+  for (const auto &v : a_vals)
+    iWriteVecBin(a_os, v);
+} // iWriteVecInt2dBin
+//------------------------------------------------------------------------------
+/// \brief Reads a VecInt2d written by iWriteVecInt2dBin
+/// \param[in] a_is The stream
+/// \param[out] a_vals The vectors
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iReadVecInt2dBin(std::istream &a_is, VecInt2d &a_vals)
+{
+  int64_t num(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, num) && iBytesLeft(a_is, num, sizeof(int64_t)), false);
+  a_vals.assign((size_t)num, VecInt());
+  for (auto &v : a_vals)
+  {
+    XM_ENSURE_TRUE(iReadVecBin(a_is, v), false);
+  }
+  return true;
+} // iReadVecInt2dBin
+//------------------------------------------------------------------------------
+/// \brief Writes an optional TIN to a binary stream
+/// \param[in] a_os The stream
+/// \param[in] a_tin The TIN. May be null.
+//------------------------------------------------------------------------------
+void iWriteOptionalTinBin(std::ostream &a_os, const BSHP<TrTin> &a_tin)
+{
+  uint8_t exists = a_tin ? 1 : 0;
+  iWriteBin(a_os, exists);
+  if (a_tin)
+    iWriteTinToBinary(a_os, *a_tin, false, false);
+} // iWriteOptionalTinBin
+//------------------------------------------------------------------------------
+/// \brief Reads a TIN written by iWriteOptionalTinBin
+/// \param[in] a_is The stream
+/// \param[out] a_tin The TIN. Null if none was written.
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iReadOptionalTinBin(std::istream &a_is, BSHP<TrTin> &a_tin)
+{
+  uint8_t exists(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, exists), false);
+  a_tin.reset();
+  if (!exists)
+    return true;
+  a_tin = TrTin::New();
+  return iReadTinFromBinary(a_is, a_tin);
+} // iReadOptionalTinBin
+//------------------------------------------------------------------------------
+/// \brief Writes a cross section to a binary stream
+/// \param[in] a_os The stream
+/// \param[in] a_cs The cross section
+//------------------------------------------------------------------------------
+void iWriteCrossSectionBin(std::ostream &a_os, const XmStampCrossSection &a_cs)
+{
+  iWriteVecPt3dBin(a_os, a_cs.m_left);
+  iWriteBin(a_os, a_cs.m_leftMax);
+  iWriteBin(a_os, (int32_t)a_cs.m_idxLeftShoulder);
+  iWriteVecPt3dBin(a_os, a_cs.m_right);
+  iWriteBin(a_os, a_cs.m_rightMax);
+  iWriteBin(a_os, (int32_t)a_cs.m_idxRightShoulder);
+} // iWriteCrossSectionBin
+//------------------------------------------------------------------------------
+/// \brief Reads a cross section written by iWriteCrossSectionBin
+/// \param[in] a_is The stream
+/// \param[out] a_cs The cross section
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iReadCrossSectionBin(std::istream &a_is, XmStampCrossSection &a_cs)
+{
+  int32_t idxLeft(0), idxRight(0);
+  XM_ENSURE_TRUE(iReadVecPt3dBin(a_is, a_cs.m_left), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, a_cs.m_leftMax) && iReadBin(a_is, idxLeft), false);
+  XM_ENSURE_TRUE(iReadVecPt3dBin(a_is, a_cs.m_right), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, a_cs.m_rightMax) && iReadBin(a_is, idxRight), false);
+  a_cs.m_idxLeftShoulder = idxLeft;
+  a_cs.m_idxRightShoulder = idxRight;
+  return true;
+} // iReadCrossSectionBin
+//------------------------------------------------------------------------------
+/// \brief Writes an end cap to a binary stream
+/// \param[in] a_os The stream
+/// \param[in] a_cap The end cap
+//------------------------------------------------------------------------------
+void iWriteEndCapBin(std::ostream &a_os, const XmStamperEndCap &a_cap)
+{
+  iWriteBin(a_os, (int32_t)a_cap.m_type);
+  iWriteBin(a_os, a_cap.m_angle);
+  const XmGuidebank &gb(a_cap.m_guidebank);
+  iWriteBin(a_os, (int32_t)gb.m_side);
+  iWriteBin(a_os, gb.m_radius1);
+  iWriteBin(a_os, gb.m_radius2);
+  iWriteBin(a_os, gb.m_width);
+  iWriteBin(a_os, (int32_t)gb.m_nPts);
+  iWriteBin(a_os, a_cap.m_slopedAbutment.m_maxX);
+  iWriteVecPt3dBin(a_os, a_cap.m_slopedAbutment.m_slope);
+  iWriteBin(a_os, a_cap.m_wingWall.m_wingWallAngle);
+} // iWriteEndCapBin
+//------------------------------------------------------------------------------
+/// \brief Reads an end cap written by iWriteEndCapBin
+/// \param[in] a_is The stream
+/// \param[out] a_cap The end cap
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iReadEndCapBin(std::istream &a_is, XmStamperEndCap &a_cap)
+{
+  int32_t type(0), side(0), nPts(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, type) && iReadBin(a_is, a_cap.m_angle), false);
+  XmGuidebank &gb(a_cap.m_guidebank);
+  XM_ENSURE_TRUE(iReadBin(a_is, side) && iReadBin(a_is, gb.m_radius1) &&
+                   iReadBin(a_is, gb.m_radius2) && iReadBin(a_is, gb.m_width) &&
+                   iReadBin(a_is, nPts),
+                 false);
+  XM_ENSURE_TRUE(iReadBin(a_is, a_cap.m_slopedAbutment.m_maxX), false);
+  XM_ENSURE_TRUE(iReadVecPt3dBin(a_is, a_cap.m_slopedAbutment.m_slope), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, a_cap.m_wingWall.m_wingWallAngle), false);
+  a_cap.m_type = type;
+  gb.m_side = side;
+  gb.m_nPts = nPts;
+  return true;
+} // iReadEndCapBin
+//------------------------------------------------------------------------------
+/// \brief Writes a raster to a binary stream
+/// \param[in] a_os The stream
+/// \param[in] a_raster The raster
+//------------------------------------------------------------------------------
+void iWriteRasterBin(std::ostream &a_os, const XmStampRaster &a_raster)
+{
+  iWriteBin(a_os, (int32_t)a_raster.m_numPixelsX);
+  iWriteBin(a_os, (int32_t)a_raster.m_numPixelsY);
+  iWriteBin(a_os, a_raster.m_pixelSizeX);
+  iWriteBin(a_os, a_raster.m_pixelSizeY);
+  iWriteBin(a_os, a_raster.m_min);
+  iWriteVecBin(a_os, a_raster.m_vals);
+  iWriteBin(a_os, a_raster.m_noData);
+} // iWriteRasterBin
+//------------------------------------------------------------------------------
+/// \brief Reads a raster written by iWriteRasterBin
+/// \param[in] a_is The stream
+/// \param[out] a_raster The raster
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iReadRasterBin(std::istream &a_is, XmStampRaster &a_raster)
+{
+  int32_t numX(0), numY(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, numX) && iReadBin(a_is, numY), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, a_raster.m_pixelSizeX) && iReadBin(a_is, a_raster.m_pixelSizeY),
+                 false);
+  XM_ENSURE_TRUE(iReadBin(a_is, a_raster.m_min), false);
+  XM_ENSURE_TRUE(iReadVecBin(a_is, a_raster.m_vals), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, a_raster.m_noData), false);
+  a_raster.m_numPixelsX = numX;
+  a_raster.m_numPixelsY = numY;
+  return true;
+} // iReadRasterBin
+//------------------------------------------------------------------------------
+/// \brief Writes raster volumes to a binary stream
+/// \param[in] a_os The stream
+/// \param[in] a_volumes The volumes
+//------------------------------------------------------------------------------
+void iWriteVolumesBin(std::ostream &a_os, const XmStampVolumes &a_volumes)
+{
+  iWriteBin(a_os, a_volumes.m_cutVolume);
+  iWriteBin(a_os, a_volumes.m_fillVolume);
+  iWriteBin(a_os, (int32_t)a_volumes.m_numChangedCells);
+  iWriteVecBin(a_os, a_volumes.m_depths);
+} // iWriteVolumesBin
+//------------------------------------------------------------------------------
+/// \brief Reads raster volumes written by iWriteVolumesBin
+/// \param[in] a_is The stream
+/// \param[out] a_volumes The volumes
+/// \return true on success.
+//------------------------------------------------------------------------------
+bool iReadVolumesBin(std::istream &a_is, XmStampVolumes &a_volumes)
+{
+  int32_t numChanged(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, a_volumes.m_cutVolume) &&
+                   iReadBin(a_is, a_volumes.m_fillVolume) && iReadBin(a_is, numChanged),
+                 false);
+  XM_ENSURE_TRUE(iReadVecBin(a_is, a_volumes.m_depths), false);
+  a_volumes.m_numChangedCells = numChanged;
+  return true;
+} // iReadVolumesBin
+//------------------------------------------------------------------------------
+/// \brief Blends 2 lists of matched points in xy. a_pts keeps its memory.
+/// \param[in] a_pts1 The first points
+/// \param[in] a_pts2 The second points. Same size as a_pts1.
+/// \param[in] a_percent The weight of the second points
+/// \param[out] a_pts The blended points
+//------------------------------------------------------------------------------
+void iBlendPts(const VecPt3d &a_pts1, const VecPt3d &a_pts2, double a_percent, VecPt3d &a_pts)
+{
+  a_pts.resize(std::min(a_pts1.size(), a_pts2.size()));
+  for (size_t i = 0; i < a_pts.size(); ++i)
+  {
+    const Pt3d &p1(a_pts1[i]), &p2(a_pts2[i]);
+    a_pts[i] = Pt3d(p1.x - (a_percent * (p1.x - p2.x)), p1.y - (a_percent * (p1.y - p2.y)), 0.0);
+  }
+} // iBlendPts
 }
 //------------------------------------------------------------------------------
 /// \brief Constructor that sets all the raster values
@@ -355,14 +1050,24 @@ void XmStampRaster::WriteGridFile(const std::string &a_fileName,
       outGrid << "yllcorner " << m_min.y - m_pixelSizeY / 2.0 << std::endl;
       outGrid << "cellsize " << m_pixelSizeX << std::endl;
       outGrid << "NODATA_value " << m_noData << std::endl;
-      outGrid << std::setprecision(2);
-      int count = 0;
-      for (const double v : m_vals)
       {
-        outGrid << v << " ";
-        ++count;
-        if (count % m_numPixelsX == 0)
-          outGrid << std::endl;
+        // values are formatted into a buffer rather than through the stream
+        std::string buf;
+        int count = 0;
+        for (const double v : m_vals)
+        {
+          iAppendFixed(buf, v, 2);
+          buf += " ";
+          ++count;
+          if (count % m_numPixelsX == 0)
+            buf += "\n";
+          if (buf.size() > 60000)
+          {
+            outGrid.write(buf.data(), buf.size());
+            buf.clear();
+          }
+        }
+        outGrid.write(buf.data(), buf.size());
       }
       break;
   }
@@ -604,6 +1309,170 @@ bool XmStampCrossSection::ReadFromFile(std::ifstream &a_file)
   return true;
 } // XmStampCrossSection::ReadFromFile
 //------------------------------------------------------------------------------
+/// \brief Constructor
+//------------------------------------------------------------------------------
+/// \brief Constructor
+//------------------------------------------------------------------------------
+XmStampCrossSectionLibrary::XmStampCrossSectionLibrary()
+: m_templates()
+, m_pts()
+{
+} // XmStampCrossSectionLibrary::XmStampCrossSectionLibrary
+//------------------------------------------------------------------------------
+/// \brief Adds a cross section template.
+/// \param[in] a_cs: The cross section. Only the x and y of the profile
+/// points are kept.
+/// \return The index of the template.
+//------------------------------------------------------------------------------
+int XmStampCrossSectionLibrary::Add(const XmStampCrossSection &a_cs)
+{
+  stTemplate t;
+  t.m_leftBeg = (int)m_pts.size();
+  t.m_leftCount = (int)a_cs.m_left.size();
+  t.m_leftMax = a_cs.m_leftMax;
+  t.m_idxLeftShoulder = a_cs.m_idxLeftShoulder;
+  t.m_rightBeg = t.m_leftBeg + t.m_leftCount;
+  t.m_rightCount = (int)a_cs.m_right.size();
+  t.m_rightMax = a_cs.m_rightMax;
+  t.m_idxRightShoulder = a_cs.m_idxRightShoulder;
+  m_pts.reserve(m_pts.size() + a_cs.m_left.size() + a_cs.m_right.size());
+  for (const auto &p : a_cs.m_left)
+    m_pts.push_back(Pt2d(p.x, p.y));
+  for (const auto &p : a_cs.m_right)
+    m_pts.push_back(Pt2d(p.x, p.y));
+  m_templates.push_back(t);
+  return (int)m_templates.size() - 1;
+} // XmStampCrossSectionLibrary::Add
+//------------------------------------------------------------------------------
+/// \brief Gets the number of templates.
+/// \return The number of templates.
+//------------------------------------------------------------------------------
+int XmStampCrossSectionLibrary::NumTemplates() const
+{
+  return (int)m_templates.size();
+} // XmStampCrossSectionLibrary::NumTemplates
+//------------------------------------------------------------------------------
+/// \brief Copies a cross section template out of the library. a_cs keeps its
+/// memory so one cross section can be reused for many templates.
+/// \param[in] a_idx: The index of the template.
+/// \param[out] a_cs: The cross section.
+/// \return false if a_idx is not a template.
+//------------------------------------------------------------------------------
+bool XmStampCrossSectionLibrary::Get(int a_idx, XmStampCrossSection &a_cs) const
+{
+  if (!GetValues(a_idx, a_cs))
+    return false;
+  const stTemplate &t(m_templates[a_idx]);
+  a_cs.m_left.resize(t.m_leftCount);
+  for (int i = 0; i < t.m_leftCount; ++i)
+    a_cs.m_left[i] = Pt3d(m_pts[t.m_leftBeg + i].x, m_pts[t.m_leftBeg + i].y, 0.0);
+  a_cs.m_right.resize(t.m_rightCount);
+  for (int i = 0; i < t.m_rightCount; ++i)
+    a_cs.m_right[i] = Pt3d(m_pts[t.m_rightBeg + i].x, m_pts[t.m_rightBeg + i].y, 0.0);
+  return true;
+} // XmStampCrossSectionLibrary::Get
+//------------------------------------------------------------------------------
+/// \brief Gets the max values and shoulder indexes of a cross section
+/// template without its points.
+/// \param[in] a_idx: The index of the template.
+/// \param[out] a_cs: The cross section. Its points are cleared.
+/// \return false if a_idx is not a template.
+//------------------------------------------------------------------------------
+bool XmStampCrossSectionLibrary::GetValues(int a_idx, XmStampCrossSection &a_cs) const
+{
+  if (a_idx < 0 || a_idx >= (int)m_templates.size())
+    return false;
+  const stTemplate &t(m_templates[a_idx]);
+  a_cs.m_left.clear();
+  a_cs.m_leftMax = t.m_leftMax;
+  a_cs.m_idxLeftShoulder = t.m_idxLeftShoulder;
+  a_cs.m_right.clear();
+  a_cs.m_rightMax = t.m_rightMax;
+  a_cs.m_idxRightShoulder = t.m_idxRightShoulder;
+  return true;
+} // XmStampCrossSectionLibrary::GetValues
+//------------------------------------------------------------------------------
+/// \brief Checks if a template has points on either side.
+/// \param[in] a_idx: The index of the template.
+/// \return false if a_idx is not a template or neither side has 2 points.
+//------------------------------------------------------------------------------
+bool XmStampCrossSectionLibrary::HasProfile(int a_idx) const
+{
+  if (a_idx < 0 || a_idx >= (int)m_templates.size())
+    return false;
+  const stTemplate &t(m_templates[a_idx]);
+  return t.m_leftCount > 1 || t.m_rightCount > 1;
+} // XmStampCrossSectionLibrary::HasProfile
+//------------------------------------------------------------------------------
+/// \brief Removes all templates.
+//------------------------------------------------------------------------------
+void XmStampCrossSectionLibrary::Clear()
+{
+  m_templates.clear();
+  m_pts.clear();
+} // XmStampCrossSectionLibrary::Clear
+//------------------------------------------------------------------------------
+/// \brief Writes the templates to a binary stream. The profiles of all
+/// templates are written as 2D (offset, elevation) points in one array.
+/// \param[in] a_os: The output stream.
+//------------------------------------------------------------------------------
+void XmStampCrossSectionLibrary::WriteToBinary(std::ostream &a_os) const
+{
+  iWriteBin(a_os, (int64_t)m_templates.size());
+  for (const auto &t : m_templates)
+  {
+    iWriteBin(a_os, (int32_t)t.m_leftBeg);
+    iWriteBin(a_os, (int32_t)t.m_leftCount);
+    iWriteBin(a_os, t.m_leftMax);
+    iWriteBin(a_os, (int32_t)t.m_idxLeftShoulder);
+    iWriteBin(a_os, (int32_t)t.m_rightBeg);
+    iWriteBin(a_os, (int32_t)t.m_rightCount);
+    iWriteBin(a_os, t.m_rightMax);
+    iWriteBin(a_os, (int32_t)t.m_idxRightShoulder);
+  }
+  iWriteVecBin(a_os, m_pts);
+} // XmStampCrossSectionLibrary::WriteToBinary
+//------------------------------------------------------------------------------
+/// \brief Reads the templates from a binary stream written by WriteToBinary.
+/// \param[in] a_is: The input stream.
+/// \return true if the read is successful. false if errors encountered.
+//------------------------------------------------------------------------------
+bool XmStampCrossSectionLibrary::ReadFromBinary(std::istream &a_is)
+{
+  Clear();
+  int64_t num(0);
+  const size_t templateSize = 6 * sizeof(int32_t) + 2 * sizeof(double);
+  XM_ENSURE_TRUE(iReadBin(a_is, num) && iBytesLeft(a_is, num, templateSize), false);
+  m_templates.resize((size_t)num);
+  for (auto &t : m_templates)
+  {
+    int32_t leftBeg(0), leftCnt(0), idxLeft(0), rightBeg(0), rightCnt(0), idxRight(0);
+    XM_ENSURE_TRUE(iReadBin(a_is, leftBeg) && iReadBin(a_is, leftCnt) &&
+                     iReadBin(a_is, t.m_leftMax) && iReadBin(a_is, idxLeft),
+                   false);
+    XM_ENSURE_TRUE(iReadBin(a_is, rightBeg) && iReadBin(a_is, rightCnt) &&
+                     iReadBin(a_is, t.m_rightMax) && iReadBin(a_is, idxRight),
+                   false);
+    t.m_leftBeg = leftBeg;
+    t.m_leftCount = leftCnt;
+    t.m_idxLeftShoulder = idxLeft;
+    t.m_rightBeg = rightBeg;
+    t.m_rightCount = rightCnt;
+    t.m_idxRightShoulder = idxRight;
+  }
+  XM_ENSURE_TRUE(iReadVecBin(a_is, m_pts), false);
+  for (const auto &t : m_templates)
+  {
+    XM_ENSURE_TRUE(t.m_leftBeg >= 0 && t.m_leftCount >= 0 &&
+                     (size_t)t.m_leftBeg + t.m_leftCount <= m_pts.size(),
+                   false);
+    XM_ENSURE_TRUE(t.m_rightBeg >= 0 && t.m_rightCount >= 0 &&
+                     (size_t)t.m_rightBeg + t.m_rightCount <= m_pts.size(),
+                   false);
+  }
+  return true;
+} // XmStampCrossSectionLibrary::ReadFromBinary
+//------------------------------------------------------------------------------
 /// \brief Writes the XmStamperIo class information to a file.
 /// \param[in] a_file: The output file.
 /// \param[in] a_cardName: The card name to be written to the output file.
@@ -695,6 +1564,303 @@ bool XmStamperIo::ReadFromFile(std::ifstream &a_file)
   return true;
 } // XmStamperIo::ReadFromFile
 //------------------------------------------------------------------------------
+/// \brief Writes a TIN to a binary file (see iWriteTinToBinary for the
+/// layout).
+/// \param[in] a_fileName: The output file.
+/// \param[in] a_tin: The TIN.
+/// \param[in] a_canonicalOrder: Sort the triangles so the file does not depend
+/// on the triangulation order. Off by default since it costs a sort.
+/// \param[in] a_adjacency: Also write the triangles adjacent to each point.
+/// Ignored when a_canonicalOrder is true.
+/// \return true if the file was written.
+//------------------------------------------------------------------------------
+bool XmStamperIo::WriteTinToBinaryFile(const std::string &a_fileName,
+                                       const BSHP<TrTin> &a_tin,
+                                       bool a_canonicalOrder,
+                                       bool a_adjacency)
+{
+  XM_ENSURE_TRUE(a_tin, false);
+  std::ofstream os(a_fileName.c_str(), std::ios::out | std::ios::binary);
+  XM_ENSURE_TRUE(os.is_open(), false);
+  return iWriteTinToBinary(os, *a_tin, a_canonicalOrder, a_adjacency);
+} // XmStamperIo::WriteTinToBinaryFile
+//------------------------------------------------------------------------------
+/// \brief Reads a TIN from a binary file written by WriteTinToBinaryFile.
+/// \param[in] a_fileName: The input file.
+/// \param[in,out] a_tin: The TIN.
+/// \return true if file read is successful. false if errors encountered.
+//------------------------------------------------------------------------------
+bool XmStamperIo::ReadTinFromBinaryFile(const std::string &a_fileName, const BSHP<TrTin> &a_tin)
+{
+  XM_ENSURE_TRUE(a_tin, false);
+  std::ifstream is(a_fileName.c_str(), std::ios::in | std::ios::binary);
+  XM_ENSURE_TRUE(is.is_open(), false);
+  return iReadTinFromBinary(is, a_tin);
+} // XmStamperIo::ReadTinFromBinaryFile
+//------------------------------------------------------------------------------
+/// \brief Writes the XmStamperIo class to a versioned binary stream. Holds the
+/// inputs and outputs without formatting numbers as text. Use a
+/// std::stringstream to send the data to another process.
+/// m_bathymetryStore is not written. It is a handle to an open file on this
+/// machine so the reader must open the store itself.
+/// \param[in] a_os: The output stream. Should be opened in binary mode.
+/// \return true if the stream was written.
+//------------------------------------------------------------------------------
+bool XmStamperIo::WriteToBinary(std::ostream &a_os) const
+{
+  a_os.write(BINARY_IO_MAGIC, sizeof(BINARY_IO_MAGIC));
+  iWriteBin(a_os, BINARY_IO_VERSION);
+  iWriteVecPt3dBin(a_os, m_centerLine);
+  iWriteBin(a_os, (int32_t)m_stampingType);
+  iWriteBin(a_os, (int64_t)m_cs.size());
+  for (const auto &cs : m_cs)
+    iWriteCrossSectionBin(a_os, cs);
+  iWriteEndCapBin(a_os, m_firstEndCap);
+  iWriteEndCapBin(a_os, m_lastEndCap);
+  iWriteBin(a_os, m_firstEndCap.m_maxChordDeviation);
+  iWriteBin(a_os, m_lastEndCap.m_maxChordDeviation);
+  iWriteBin(a_os, m_centerLineTolerance);
+  uint8_t hasLibrary = m_csLibrary ? 1 : 0;
+  iWriteBin(a_os, hasLibrary);
+  if (m_csLibrary)
+    m_csLibrary->WriteToBinary(a_os);
+  iWriteVecBin(a_os, m_csTemplates);
+  iWriteVecBin(a_os, m_csStations);
+  iWriteBin(a_os, (int64_t)m_stationCs.size());
+  for (const auto &cs : m_stationCs)
+    iWriteCrossSectionBin(a_os, cs);
+  iWriteOptionalTinBin(a_os, m_bathymetry);
+  iWriteRasterBin(a_os, m_raster);
+  iWriteVecPt3dBin(a_os, m_targetPoints);
+  uint32_t flags(0);
+  flags |= m_stripTriangulation ? BINARY_IO_STRIPS : 0;
+  flags |= m_geometryOnly ? BINARY_IO_GEOMETRY : 0;
+  flags |= m_lazyOutputs ? BINARY_IO_LAZY : 0;
+  flags |= m_weldPoints ? BINARY_IO_WELD : 0;
+  flags |= m_hilbertOrder ? BINARY_IO_HILBERT : 0;
+  flags |= m_spliceIntoBathymetry ? BINARY_IO_SPLICE : 0;
+  flags |= m_rasterDepths ? BINARY_IO_DEPTHS : 0;
+  flags |= m_tinVolumes ? BINARY_IO_VOLUMES : 0;
+  flags |= m_flatBreaklinesOnly ? BINARY_IO_FLAT_BL : 0;
+  iWriteBin(a_os, flags);
+
+  iWriteOptionalTinBin(a_os, m_outTin);
+  iWriteVecInt2dBin(a_os, m_outBreakLines);
+  iWriteVecBin(a_os, m_outBreakLineOffsets);
+  iWriteVecBin(a_os, m_outBreakLinePts);
+  iWriteVecBin(a_os, m_outBreakLineTypes);
+  iWriteBin(a_os, (int32_t)m_outNumCenterLinePtsRemoved);
+  iWriteBin(a_os, (int32_t)m_outNumWeldedPts);
+  iWriteVecPt3dBin(a_os, m_outPoints);
+  iWriteVecInt2dBin(a_os, m_outOuterPolygons);
+  iWriteOptionalTinBin(a_os, m_outSplicedTin);
+  iWriteVolumesBin(a_os, m_outVolumes);
+  iWriteBin(a_os, m_outTinCutVolume);
+  iWriteBin(a_os, m_outTinFillVolume);
+  return a_os.good();
+} // XmStamperIo::WriteToBinary
+//------------------------------------------------------------------------------
+/// \brief Reads the XmStamperIo class from a binary stream written by
+/// WriteToBinary.
+/// \param[in] a_is: The input stream. Should be opened in binary mode.
+/// \return true if the read is successful. false if errors encountered.
+//------------------------------------------------------------------------------
+bool XmStamperIo::ReadFromBinary(std::istream &a_is)
+{
+  char magic[sizeof(BINARY_IO_MAGIC)];
+  a_is.read(magic, sizeof(magic));
+  XM_ENSURE_TRUE(a_is.good() && memcmp(magic, BINARY_IO_MAGIC, sizeof(magic)) == 0, false);
+  uint32_t version(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, version) && version == BINARY_IO_VERSION, false);
+
+  int32_t stampingType(0);
+  int64_t num(0);
+  XM_ENSURE_TRUE(iReadVecPt3dBin(a_is, m_centerLine), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, stampingType), false);
+  m_stampingType = stampingType;
+  XM_ENSURE_TRUE(iReadBin(a_is, num) && num >= 0, false);
+  m_cs.assign((size_t)num, XmStampCrossSection());
+  for (auto &cs : m_cs)
+  {
+    XM_ENSURE_TRUE(iReadCrossSectionBin(a_is, cs), false);
+  }
+  XM_ENSURE_TRUE(iReadEndCapBin(a_is, m_firstEndCap), false);
+  XM_ENSURE_TRUE(iReadEndCapBin(a_is, m_lastEndCap), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, m_firstEndCap.m_maxChordDeviation), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, m_lastEndCap.m_maxChordDeviation), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, m_centerLineTolerance), false);
+  uint8_t hasLibrary(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, hasLibrary), false);
+  m_csLibrary.reset();
+  if (hasLibrary)
+  {
+    m_csLibrary.reset(new XmStampCrossSectionLibrary);
+    XM_ENSURE_TRUE(m_csLibrary->ReadFromBinary(a_is), false);
+  }
+  XM_ENSURE_TRUE(iReadVecBin(a_is, m_csTemplates), false);
+  XM_ENSURE_TRUE(iReadVecBin(a_is, m_csStations), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, num) && num >= 0, false);
+  m_stationCs.assign((size_t)num, XmStampCrossSection());
+  for (auto &cs : m_stationCs)
+  {
+    XM_ENSURE_TRUE(iReadCrossSectionBin(a_is, cs), false);
+  }
+  XM_ENSURE_TRUE(iReadOptionalTinBin(a_is, m_bathymetry), false);
+  XM_ENSURE_TRUE(iReadRasterBin(a_is, m_raster), false);
+  XM_ENSURE_TRUE(iReadVecPt3dBin(a_is, m_targetPoints), false);
+  uint32_t flags(0);
+  XM_ENSURE_TRUE(iReadBin(a_is, flags), false);
+  m_stripTriangulation = (flags & BINARY_IO_STRIPS) != 0;
+  m_geometryOnly = (flags & BINARY_IO_GEOMETRY) != 0;
+  m_lazyOutputs = (flags & BINARY_IO_LAZY) != 0;
+  m_weldPoints = (flags & BINARY_IO_WELD) != 0;
+  m_hilbertOrder = (flags & BINARY_IO_HILBERT) != 0;
+  m_spliceIntoBathymetry = (flags & BINARY_IO_SPLICE) != 0;
+  m_rasterDepths = (flags & BINARY_IO_DEPTHS) != 0;
+  m_tinVolumes = (flags & BINARY_IO_VOLUMES) != 0;
+  m_flatBreaklinesOnly = (flags & BINARY_IO_FLAT_BL) != 0;
+
+  int32_t numRemoved(0), numWelded(0);
+  XM_ENSURE_TRUE(iReadOptionalTinBin(a_is, m_outTin), false);
+  XM_ENSURE_TRUE(iReadVecInt2dBin(a_is, m_outBreakLines), false);
+  XM_ENSURE_TRUE(iReadVecBin(a_is, m_outBreakLineOffsets), false);
+  XM_ENSURE_TRUE(iReadVecBin(a_is, m_outBreakLinePts), false);
+  XM_ENSURE_TRUE(iReadVecBin(a_is, m_outBreakLineTypes), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, numRemoved) && iReadBin(a_is, numWelded), false);
+  m_outNumCenterLinePtsRemoved = numRemoved;
+  m_outNumWeldedPts = numWelded;
+  XM_ENSURE_TRUE(iReadVecPt3dBin(a_is, m_outPoints), false);
+  XM_ENSURE_TRUE(iReadVecInt2dBin(a_is, m_outOuterPolygons), false);
+  XM_ENSURE_TRUE(iReadOptionalTinBin(a_is, m_outSplicedTin), false);
+  XM_ENSURE_TRUE(iReadVolumesBin(a_is, m_outVolumes), false);
+  XM_ENSURE_TRUE(iReadBin(a_is, m_outTinCutVolume) && iReadBin(a_is, m_outTinFillVolume),
+                 false);
+  return true;
+} // XmStamperIo::ReadFromBinary
+//------------------------------------------------------------------------------
+/// \brief Gets m_cs and m_csTemplates ready for the stamp. Both are sized to
+/// the center line. Templates are not copied: m_cs keeps only the max values
+/// and shoulder indexes of each template that is used and the points are
+/// read from the library with CrossSection(). Cross sections in m_cs that
+/// have points are kept and override their templates.
+//------------------------------------------------------------------------------
+void XmStamperIo::PrepareCrossSectionLibrary()
+{
+  if (!m_csLibrary || m_csTemplates.empty())
+  {
+    m_csTemplates.clear();
+    return;
+  }
+  if (m_cs.size() < m_centerLine.size())
+    m_cs.resize(m_centerLine.size());
+  m_csTemplates.resize(m_cs.size(), -1);
+  for (size_t i = 0; i < m_cs.size(); ++i)
+  {
+    XmStampCrossSection &cs(m_cs[i]);
+    int t = m_csTemplates[i];
+    if (cs.m_left.size() > 1 || cs.m_right.size() > 1 || !m_csLibrary->HasProfile(t))
+    {
+      m_csTemplates[i] = -1;
+      continue;
+    }
+    m_csLibrary->GetValues(t, cs);
+    if (cs.m_idxLeftShoulder < 1 || cs.m_idxRightShoulder < 1)
+    {
+      // the shoulder index gets fixed in the copy when the missing cross
+      // sections are interpolated
+      m_csLibrary->Get(t, cs);
+      m_csTemplates[i] = -1;
+    }
+  }
+} // XmStamperIo::PrepareCrossSectionLibrary
+//------------------------------------------------------------------------------
+/// \brief Checks if a center line point has a cross section with points,
+/// either in m_cs, from a template or from the stations.
+/// \param[in] a_idx: The index of the center line point.
+/// \return true if the cross section has points on either side.
+//------------------------------------------------------------------------------
+bool XmStamperIo::HasCrossSection(size_t a_idx) const
+{
+  if (a_idx >= m_cs.size())
+    return false;
+  int t = m_csLibrary && a_idx < m_csTemplates.size() ? m_csTemplates[a_idx] : -1;
+  if (t >= 0 && t < m_csLibrary->NumTemplates())
+    return m_csLibrary->HasProfile(t);
+  if (a_idx < m_csStationLengths.size() && m_csStationLengths[a_idx] >= 0.0 &&
+      !m_csStationSpans.empty())
+    return true;
+  const XmStampCrossSection &cs(m_cs[a_idx]);
+  return cs.m_left.size() > 1 || cs.m_right.size() > 1;
+} // XmStamperIo::HasCrossSection
+//------------------------------------------------------------------------------
+/// \brief Gets the cross section at a center line point. This is the
+/// template in m_csLibrary when one is set for the point (see
+/// PrepareCrossSectionLibrary), the cross section interpolated from the
+/// stations when the point has a station length, and m_cs otherwise.
+/// Templates and station cross sections are copied into a_buf; reuse the
+/// same buffer to avoid allocating for each point.
+/// \param[in] a_idx: The index of the center line point. Must be less than
+/// the size of m_cs.
+/// \param[in,out] a_buf: Holds the cross section if it is not in m_cs.
+/// \return The cross section. Either a_buf or an item of m_cs.
+//------------------------------------------------------------------------------
+const XmStampCrossSection &XmStamperIo::CrossSection(size_t a_idx,
+                                                     XmStampCrossSection &a_buf) const
+{
+  if (m_csLibrary && a_idx < m_csTemplates.size() && m_csLibrary->Get(m_csTemplates[a_idx], a_buf))
+    return a_buf;
+  if (a_idx < m_csStationLengths.size() && m_csStationLengths[a_idx] >= 0.0 &&
+      !m_csStationSpans.empty())
+  {
+    // the max values and shoulder indexes are kept in m_cs
+    StationCrossSection(m_csStationLengths[a_idx], a_buf);
+    const XmStampCrossSection &cs(m_cs[a_idx]);
+    a_buf.m_leftMax = cs.m_leftMax;
+    a_buf.m_idxLeftShoulder = cs.m_idxLeftShoulder;
+    a_buf.m_rightMax = cs.m_rightMax;
+    a_buf.m_idxRightShoulder = cs.m_idxRightShoulder;
+    return a_buf;
+  }
+  return m_cs[a_idx];
+} // XmStamperIo::CrossSection
+//------------------------------------------------------------------------------
+/// \brief Gets the cross section at a distance along the center line from
+/// m_csStationSpans. Before the first or after the last station this is a
+/// copy of that station's cross section. Between stations it is a blend of
+/// the matched points of the 2 stations. a_cs keeps its memory so one cross
+/// section can be reused for many points.
+/// \param[in] a_length: The distance along the center line.
+/// \param[out] a_cs: The cross section. Unchanged if there are no stations.
+//------------------------------------------------------------------------------
+void XmStamperIo::StationCrossSection(double a_length, XmStampCrossSection &a_cs) const
+{
+  if (m_csStationSpans.empty())
+    return;
+  // first span that ends after a_length
+  auto it = std::upper_bound(
+    m_csStationSpans.begin(), m_csStationSpans.end(), a_length,
+    [](double a_len, const XmStampStationSpan &a_span) { return a_len < a_span.m_end; });
+  int station(-1);
+  if (it == m_csStationSpans.end())
+    station = m_csStationSpans.back().m_endStation;
+  else if (a_length <= it->m_beg)
+    station = it->m_begStation;
+  if (station >= 0)
+  {
+    a_cs = m_stationCs[station];
+    return;
+  }
+
+  const double percent = (a_length - it->m_beg) / (it->m_end - it->m_beg);
+  const XmStampCrossSection &beg(it->m_begCs), &end(it->m_endCs);
+  a_cs.m_leftMax = beg.m_leftMax - (percent * (beg.m_leftMax - end.m_leftMax));
+  a_cs.m_idxLeftShoulder = beg.m_idxLeftShoulder;
+  iBlendPts(beg.m_left, end.m_left, percent, a_cs.m_left);
+  a_cs.m_rightMax = beg.m_rightMax - (percent * (beg.m_rightMax - end.m_rightMax));
+  a_cs.m_idxRightShoulder = beg.m_idxRightShoulder;
+  iBlendPts(beg.m_right, end.m_right, percent, a_cs.m_right);
+} // XmStamperIo::StationCrossSection
+//------------------------------------------------------------------------------
 /// \brief Sets the precision for stamper output
 /// \param[in] a_precision: The number of digits of precision for stamper output
 //------------------------------------------------------------------------------
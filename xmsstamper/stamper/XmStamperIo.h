@@ -26,6 +26,7 @@ namespace xms
 
 //----- Structs / Classes ------------------------------------------------------
 class TrTin;
+class XmBathymetryStore;
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \class XmStampRaster
@@ -54,6 +55,28 @@ public:
   bool ReadFromFile(std::ifstream & a_file);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmStampVolumes
+/// \brief Changes made to a raster when a stamp is burned into it
+class XmStampVolumes
+{
+public:
+  XmStampVolumes()
+  : m_cutVolume(0.0)
+  , m_fillVolume(0.0)
+  , m_numChangedCells(0)
+  , m_depths()
+  {
+  }
+
+  double m_cutVolume;    ///< volume removed from cells that had values
+  double m_fillVolume;   ///< volume added to cells that had values
+  int m_numChangedCells; ///< number of cells whose value changed
+  /// new minus old value of each cell when asked for. 0 for unchanged cells
+  /// and the raster's no data value for cells that had no value.
+  std::vector<double> m_depths;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \class XmWingWall
 /// \brief Wing wall definition for feature stamp end cap
@@ -123,11 +146,16 @@ public:
   XmStamperEndCap()
   : m_type(2)
   , m_angle(0)
+  , m_maxChordDeviation(0)
   {
   }
   // TODO: Make this string a string for type?
   int m_type;              ///< type of end cap: 0- guidebank, 1- sloped abutment, 2- wing wall
   double m_angle;          ///< degrees from -45 to 45
+  /// max distance between the curved edge of a guidebank or sloped abutment and
+  /// the stamped points. 0 uses the fixed resolution (15 degree sloped abutment
+  /// transitions and XmGuidebank::m_nPts).
+  double m_maxChordDeviation;
   XmGuidebank m_guidebank; ///< guidebank definition
   XmSlopedAbutment m_slopedAbutment; ///< sloped abutment definition
   XmWingWall m_wingWall;             ///< wing wall definition
@@ -165,6 +193,71 @@ public:
   bool ReadFromFile(std::ifstream & a_file);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmStampCrossSectionLibrary
+/// \brief Cross section templates stored once and shared by many center line
+/// points. The profiles of all templates are kept as 2D (offset, elevation)
+/// points in one array and are only copied out when a center line point
+/// needs them.
+class XmStampCrossSectionLibrary
+{
+public:
+  XmStampCrossSectionLibrary();
+
+  int Add(const XmStampCrossSection &a_cs);
+  int NumTemplates() const;
+  bool Get(int a_idx, XmStampCrossSection &a_cs) const;
+  bool GetValues(int a_idx, XmStampCrossSection &a_cs) const;
+  bool HasProfile(int a_idx) const;
+  void Clear();
+
+  void WriteToBinary(std::ostream &a_os) const;
+  bool ReadFromBinary(std::istream &a_is);
+
+private:
+  /// \brief Where the profile of a template is in m_pts and its other values
+  struct stTemplate
+  {
+    int m_leftBeg;          ///< index of the first left point in m_pts
+    int m_leftCount;        ///< number of left points
+    double m_leftMax;       ///< max x value for left side
+    int m_idxLeftShoulder;  ///< index to the shoulder point in the left points
+    int m_rightBeg;         ///< index of the first right point in m_pts
+    int m_rightCount;       ///< number of right points
+    double m_rightMax;      ///< max x value for right side
+    int m_idxRightShoulder; ///< index to the shoulder point in the right points
+  };
+
+  std::vector<stTemplate> m_templates; ///< the templates
+  VecPt2d m_pts;                       ///< profile points of all the templates
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmStampStationSpan
+/// \brief Two neighboring cross section stations. The points of their cross
+/// sections are matched up so a cross section between them is a blend of the
+/// matched points.
+class XmStampStationSpan
+{
+public:
+  XmStampStationSpan()
+  : m_beg(0.0)
+  , m_end(0.0)
+  , m_begStation(-1)
+  , m_endStation(-1)
+  , m_begCs()
+  , m_endCs()
+  {
+  }
+
+  double m_beg;                ///< distance of the first station
+  double m_end;                ///< distance of the second station
+  int m_begStation;            ///< index of the first station in m_stationCs
+  int m_endStation;            ///< index of the second station in m_stationCs
+  XmStampCrossSection m_begCs; ///< first cross section with matched points
+  XmStampCrossSection m_endCs; ///< second cross section with matched points
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \class XmStamperIo
 /// \brief Stamping inputs/outputs class
@@ -176,11 +269,39 @@ public:
   : m_centerLine()
   , m_stampingType(0)
   , m_cs()
+  , m_csLibrary()
+  , m_csTemplates()
+  , m_csStations()
+  , m_stationCs()
+  , m_csStationLengths()
+  , m_csStationSpans()
+  , m_centerLineTolerance(0.0)
+  , m_stripTriangulation(false)
+  , m_geometryOnly(false)
+  , m_lazyOutputs(false)
+  , m_weldPoints(false)
+  , m_hilbertOrder(false)
+  , m_spliceIntoBathymetry(false)
+  , m_rasterDepths(false)
+  , m_tinVolumes(false)
+  , m_flatBreaklinesOnly(false)
   , m_firstEndCap()
   , m_lastEndCap()
   , m_bathymetry()
+  , m_bathymetryStore()
   , m_outTin()
   , m_outBreakLines()
+  , m_outBreakLineOffsets()
+  , m_outBreakLinePts()
+  , m_outBreakLineTypes()
+  , m_outNumCenterLinePtsRemoved(0)
+  , m_outNumWeldedPts(0)
+  , m_outPoints()
+  , m_outOuterPolygons()
+  , m_outSplicedTin()
+  , m_outVolumes()
+  , m_outTinCutVolume(0.0)
+  , m_outTinFillVolume(0.0)
   {
   }
 
@@ -191,24 +312,140 @@ public:
   int m_stampingType;
   /// cross sections along the polyLine
   std::vector<XmStampCrossSection> m_cs;
+  /// shared cross section templates. Optional.
+  BSHP<XmStampCrossSectionLibrary> m_csLibrary;
+  /// index into m_csLibrary for each center line point (-1 for none). A
+  /// cross section in m_cs with points overrides the template. When used
+  /// m_cs may be left empty. During the stamp m_cs only keeps the max values
+  /// and shoulder indexes of a template; use CrossSection() to get the points.
+  VecInt m_csTemplates;
+  /// distances along the center line (in xy) of the cross sections in
+  /// m_stationCs. Optional. When used the cross section at each center line
+  /// point is interpolated from the stations and m_cs may be left empty.
+  VecDbl m_csStations;
+  /// cross sections at m_csStations
+  std::vector<XmStampCrossSection> m_stationCs;
+  /// Set by the stamp when m_csStations is used. The distance along the
+  /// center line of each point whose cross section is interpolated from the
+  /// stations, -1 for other points. m_cs only keeps the max values and
+  /// shoulder indexes of those points; use CrossSection() to get the points.
+  VecDbl m_csStationLengths;
+  /// Set by the stamp when m_csStations is used. The valid stations ordered
+  /// by distance, paired with their neighbors.
+  std::vector<XmStampStationSpan> m_csStationSpans;
+  /// Optional. When greater than 0, center line points within this distance
+  /// (in xy and in z) of a simplified center line are removed before stamping.
+  /// Points where the cross section changes are kept.
+  double m_centerLineTolerance;
+  /// Optional. When true, stamps without guidebank or sloped abutment end caps
+  /// are triangulated one cross section strip at a time instead of
+  /// triangulating all points and then adding the breaklines. Falls back to
+  /// the full triangulation when a strip can't be triangulated.
+  bool m_stripTriangulation;
+  /// Optional. When true the stamp is not triangulated. m_outTin is not set;
+  /// the points are in m_outPoints and the breaklines and outer polygons refer
+  /// to them. Ignored when m_raster or m_targetPoints has values.
+  bool m_geometryOnly;
+  /// Optional. When true DoStamp only creates the points, breaklines and outer
+  /// polygons. m_outTin is not set; the TIN is triangulated the first time
+  /// XmStamper::GetTin, GetTrisAdjToPts, BurnRaster or StampPoints is called.
+  /// Use BurnRaster and StampPoints instead of m_raster and m_targetPoints.
+  /// The stamp fails if m_raster or m_targetPoints has values or
+  /// m_weldPoints, m_hilbertOrder, m_spliceIntoBathymetry or m_tinVolumes is
+  /// set. m_stripTriangulation is not used.
+  bool m_lazyOutputs;
+  /// Optional. When true coincident points of the stamp pieces and end caps
+  /// are merged and the triangles, breaklines and outer polygons are updated
+  /// to use them. Not allowed with m_lazyOutputs.
+  bool m_weldPoints;
+  /// Optional. When true the output points are sorted along a Hilbert curve
+  /// and the triangles by the location of their centroids on the curve. The
+  /// breaklines and outer polygons use the new point indexes. Not allowed
+  /// with m_lazyOutputs.
+  bool m_hilbertOrder;
+  /// Optional. When true and m_bathymetry is set the stamp is spliced into a
+  /// copy of the bathymetry TIN and put in m_outSplicedTin. Only the
+  /// bathymetry triangles touching the stamp are replaced. Stamp elevations
+  /// are limited by m_stampingType. Not done with only m_bathymetryStore.
+  /// Ignored with m_geometryOnly and not allowed with m_lazyOutputs.
+  bool m_spliceIntoBathymetry;
+  /// Optional. When true m_outVolumes.m_depths has the change of each cell of
+  /// m_raster.
+  bool m_rasterDepths;
+  /// Optional. When true and m_bathymetry or m_bathymetryStore is set the
+  /// exact cut and fill volumes between the stamp TIN and the bathymetry are
+  /// put in m_outTinCutVolume and m_outTinFillVolume. The indexed bathymetry
+  /// is kept by the XmStamper for later stamps on the same m_bathymetry.
+  /// Ignored with m_geometryOnly and not allowed with m_lazyOutputs.
+  bool m_tinVolumes;
+  /// Optional. When true only the offsets form of the break lines
+  /// (m_outBreakLineOffsets, m_outBreakLinePts) is filled and m_outBreakLines
+  /// is left empty.
+  bool m_flatBreaklinesOnly;
   /// end cap at beginnig of polyline
   XmStamperEndCap m_firstEndCap;
   /// end cap at end of polyline
   XmStamperEndCap m_lastEndCap;
   /// underlying bathymetry
   BSHP<TrTin> m_bathymetry;
+  /// underlying bathymetry in an on-disk store. Only the part around the stamp
+  /// is loaded. Used when m_bathymetry is not set. Not written by
+  /// WriteToBinary.
+  BSHP<XmBathymetryStore> m_bathymetryStore;
 
   /// Output
   /// TIN created by the stamp operation
   BSHP<TrTin> m_outTin;
   /// break lines that are honored in the TIN
   VecInt2d m_outBreakLines;
+  /// start of each break line in m_outBreakLinePts. One more entry than the
+  /// number of break lines.
+  VecInt m_outBreakLineOffsets;
+  /// point indexes of all break lines, one after another
+  VecInt m_outBreakLinePts;
+  /// type of each break line (centerline, cross section, shoulder...)
+  VecInt m_outBreakLineTypes;
+  /// number of center line points removed because of m_centerLineTolerance
+  int m_outNumCenterLinePtsRemoved;
+  /// number of points removed because of m_weldPoints
+  int m_outNumWeldedPts;
+  /// points created by the stamp when m_geometryOnly is set
+  VecPt3d m_outPoints;
+  /// outer boundary of each piece of the stamp (closed, point indexes). The
+  /// stamp has more than one piece when it is broken up by the bathymetry.
+  VecInt2d m_outOuterPolygons;
+  /// bathymetry with the stamp spliced in when m_spliceIntoBathymetry is set
+  BSHP<TrTin> m_outSplicedTin;
+  /// cut and fill volumes of the changes made to m_raster
+  XmStampVolumes m_outVolumes;
+  /// volume where the stamp TIN is below m_bathymetry when m_tinVolumes is set
+  double m_outTinCutVolume;
+  /// volume where the stamp TIN is above m_bathymetry when m_tinVolumes is set
+  double m_outTinFillVolume;
   /// Input/output raster to stamp the resulting elevations onto this raster
   XmStampRaster m_raster;
+  /// Input/output points (mesh nodes, survey points...) to stamp the
+  /// resulting elevations onto. Uses the same rule as m_raster; points with
+  /// XM_NODATA elevations take the stamp elevation. Points outside the stamp
+  /// are not changed.
+  VecPt3d m_targetPoints;
 
   bool ReadFromFile(std::ifstream &a_file);
   void WriteToFile(std::ofstream &a_file, const std::string &a_cardName) const;
   void SetPrecisionForOutput(int a_precision);
+  void PrepareCrossSectionLibrary();
+  bool HasCrossSection(size_t a_idx) const;
+  const XmStampCrossSection &CrossSection(size_t a_idx, XmStampCrossSection &a_buf) const;
+  void StationCrossSection(double a_length, XmStampCrossSection &a_cs) const;
+
+  bool ReadFromBinary(std::istream &a_is);
+  bool WriteToBinary(std::ostream &a_os) const;
+
+  static bool WriteTinToBinaryFile(const std::string &a_fileName,
+                                   const BSHP<TrTin> &a_tin,
+                                   bool a_canonicalOrder = false,
+                                   bool a_adjacency = false);
+  static bool ReadTinFromBinaryFile(const std::string &a_fileName, const BSHP<TrTin> &a_tin);
 }; // XmStamperIo
 
 //----- Function prototypes ----------------------------------------------------
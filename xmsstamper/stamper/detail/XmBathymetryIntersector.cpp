@@ -28,9 +28,11 @@
 #include <xmsgrid/geometry/GmMultiPolyIntersectionSorterTerse.h>
 #include <xmsgrid/geometry/GmTriSearch.h>
 #include <xmsstamper/stamper/detail/XmStamper3dPts.h>
+#include <xmsstamper/stamper/XmBathymetryStore.h>
 #include <xmsstamper/stamper/XmStamperIo.h>
 #include <xmsgrid/triangulate/TrTin.h>
 #include <xmscore/misc/XmConst.h>
+#include <xmsstamper/stamper/detail/XmUtil.h>
 
 // 6. Non-shared code headers
 
@@ -44,6 +46,10 @@ namespace xms
 {
 //----- Constants / Enumerations -----------------------------------------------
 
+/// Minimum number of cross sections intersected by each thread. Each extra
+/// thread builds its own intersector so small inputs are done serially.
+const size_t MIN_XSECTS_PER_THREAD = 32;
+
 //----- Classes / Structs ------------------------------------------------------
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -58,10 +64,19 @@ public:
   virtual void DecomposeCenterLine(XmStamperIo& a_io, std::vector<XmStamperIo>& a_vIo) override;
   virtual void IntersectXsects(XmStamper3dPts& a_pts) override;
   virtual void IntersectEndCaps(XmStamperIo& a_io, XmStamper3dPts& a_pts) override;
+  //------------------------------------------------------------------------------
+  /// \brief Gets the xy tolerance used to compare points. It is relative to the
+  /// size of the bathymetry TIN.
+  /// \return The tolerance.
+  //------------------------------------------------------------------------------
+  virtual double XyTol() const override { return m_xyTol; }
 
   void ClassifyPoints(VecPt3d& a_pts, VecInt& a_ptLocation);
   void CreateIntersector();
+  BSHP<GmMultiPolyIntersector> NewIntersector();
+  void CreateThreadIntersectors(int a_numThreads);
   void Intersect3dPts(VecPt3d& a_pts);
+  void Intersect3dPts(GmMultiPolyIntersector& a_intersect, VecPt3d& a_pts);
   void IntersectXsectSide(VecPt3d& a_cl, VecPt3d2d& a_side);
   void IntersectSlopedAbutment(XmStamperIo& a_io, XmStamper3dPts& a_pts, bool a_first);
   void IntersectGuideBank(XmStamperIo& a_io, XmStamper3dPts& a_pts, bool a_first);
@@ -73,7 +88,10 @@ public:
   BSHP<GmMultiPolyIntersector>
     m_intersect;   ///< polygon intersector for intersecting objects with the bathemetry TIN
   VecInt m_triIds; ///< the ids of the triangles in the intersector
-  double m_xyTol;  ///< xy tolerance for geometry comparisons
+  VecInt2d m_polys; ///< the triangles in the intersector
+  std::vector<BSHP<GmMultiPolyIntersector>>
+    m_threadIntersect; ///< intersectors used by additional threads
+  double m_xyTol;      ///< xy tolerance for geometry comparisons
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -127,11 +145,24 @@ void XmBathymetryIntersectorImpl::IntersectCenterLine(XmStamperIo& a_io)
   std::vector<XmStampCrossSection> vXs, ioXs(a_io.m_cs);
   if (ioXs.size() != line.size())
     ioXs.resize(line.size());
+  // template indexes and station lengths stay with their cross sections
+  VecInt vTemplates, &ioTemplates(a_io.m_csTemplates);
+  bool templates = !ioTemplates.empty();
+  if (templates)
+    ioTemplates.resize(line.size(), -1);
+  VecDbl vLengths, &ioLengths(a_io.m_csStationLengths);
+  bool lengths = !ioLengths.empty();
+  if (lengths)
+    ioLengths.resize(line.size(), -1.0);
   for (size_t i = 1; i < line.size(); ++i)
   {
     Pt3d &p0(line[i - 1]), &p1(line[i]);
     line1.push_back(p0);
     vXs.push_back(ioXs[i - 1]);
+    if (templates)
+      vTemplates.push_back(ioTemplates[i - 1]);
+    if (lengths)
+      vLengths.push_back(ioLengths[i - 1]);
     m_intersect->TraverseLineSegment(p0.x, p0.y, p1.x, p1.y, triIds, tVals);
     for (size_t j = 0; j < triIds.size(); ++j)
     {
@@ -150,6 +181,10 @@ void XmBathymetryIntersectorImpl::IntersectCenterLine(XmStamperIo& a_io)
         {
           line1.push_back(iPt);
           vXs.push_back(XmStampCrossSection());
+          if (templates)
+            vTemplates.push_back(-1);
+          if (lengths)
+            vLengths.push_back(-1.0);
         }
       }
     }
@@ -158,9 +193,17 @@ void XmBathymetryIntersectorImpl::IntersectCenterLine(XmStamperIo& a_io)
   {
     line1.push_back(line.back());
     vXs.push_back(ioXs.back());
+    if (templates)
+      vTemplates.push_back(ioTemplates.back());
+    if (lengths)
+      vLengths.push_back(ioLengths.back());
   }
   line.swap(line1);
   a_io.m_cs.swap(vXs);
+  if (templates)
+    ioTemplates.swap(vTemplates);
+  if (lengths)
+    ioLengths.swap(vLengths);
 } // XmBathymetryIntersectorImpl::IntersectCenterLine
 //------------------------------------------------------------------------------
 /// \brief Intersects the center line from a feature stamp operation with
@@ -241,6 +284,10 @@ void XmBathymetryIntersectorImpl::DecomposeCenterLine(XmStamperIo& a_io,
       XmStamperIo io = a_io;
       io.m_centerLine.resize(idx - start + 1);
       io.m_cs.resize(idx - start + 1);
+      if (!io.m_csTemplates.empty())
+        io.m_csTemplates.resize(idx - start + 1);
+      if (!io.m_csStationLengths.empty())
+        io.m_csStationLengths.resize(idx - start + 1);
       if (start != 0)
         a_io.m_firstEndCap = XmStamperEndCap(); // remove the first end cap
       if (idx != lastIdx)
@@ -249,6 +296,10 @@ void XmBathymetryIntersectorImpl::DecomposeCenterLine(XmStamperIo& a_io,
       {
         io.m_centerLine[j] = a_io.m_centerLine[i];
         io.m_cs[j] = a_io.m_cs[i];
+        if (!io.m_csTemplates.empty())
+          io.m_csTemplates[j] = a_io.m_csTemplates[i];
+        if (!io.m_csStationLengths.empty())
+          io.m_csStationLengths[j] = a_io.m_csStationLengths[i];
       }
       a_vIo.push_back(io);
     }
@@ -348,9 +399,11 @@ void XmBathymetryIntersectorImpl::IntersectEndCaps(XmStamperIo& a_io, XmStamper3
     IntersectGuideBank(a_io, a_pts, false);
 } // XmBathymetryIntersectorImpl::IntersectEndCaps
 //------------------------------------------------------------------------------
-/// \brief Intersects left or right side of a cross section with bathymetry
-/// \param a_cl: ???
-/// \param a_side: ???
+/// \brief Intersects left or right side of a cross section with bathymetry.
+/// The cross sections are independent so large inputs are processed in
+/// parallel with one intersector per thread.
+/// \param a_cl: Center line point for each cross section
+/// \param a_side: Cross section points for each center line point
 //------------------------------------------------------------------------------
 void XmBathymetryIntersectorImpl::IntersectXsectSide(VecPt3d& a_cl, VecPt3d2d& a_side)
 {
@@ -359,17 +412,22 @@ void XmBathymetryIntersectorImpl::IntersectXsectSide(VecPt3d& a_cl, VecPt3d2d& a
     return;
   VecPt3d& cl(a_cl);
   XM_ENSURE_TRUE(xs.size() == cl.size());
-  for (size_t i = 0; i < cl.size(); ++i)
-  {
+  int nThreads = XmUtil::NumThreads(cl.size(), MIN_XSECTS_PER_THREAD);
+  CreateThreadIntersectors(nThreads);
+  XmUtil::ParallelFor(cl.size(), nThreads, [&](int a_thread, size_t a_begin, size_t a_end) {
+    GmMultiPolyIntersector& intersect(a_thread == 0 ? *m_intersect
+                                                    : *m_threadIntersect[a_thread - 1]);
     VecPt3d line;
-    line.reserve(xs[i].size() + 1);
-    line.push_back(cl[i]);
-    for (auto& p : xs[i])
-      line.push_back(p);
-    Intersect3dPts(line);
-    line.erase(line.begin());
-    xs[i] = line;
-  }
+    for (size_t i = a_begin; i < a_end; ++i)
+    {
+      line.clear();
+      line.reserve(xs[i].size() + 1);
+      line.push_back(cl[i]);
+      line.insert(line.end(), xs[i].begin(), xs[i].end());
+      Intersect3dPts(intersect, line);
+      xs[i].assign(line.begin() + 1, line.end());
+    }
+  });
 } // XmBathymetryIntersectorImpl::IntersectXsectSide
 //------------------------------------------------------------------------------
 /// \brief Creates a multi poly intersector if one does not exist
@@ -378,6 +436,7 @@ void XmBathymetryIntersectorImpl::CreateIntersector()
 {
   if (m_intersect)
     m_intersect.reset();
+  m_threadIntersect.clear();
 
   const VecPt3d& pts(m_tin->Points());
   VecInt &tris(m_tin->Triangles()), vTri(3, 0);
@@ -434,7 +493,8 @@ void XmBathymetryIntersectorImpl::CreateIntersector()
     }
   }
 
-  VecInt2d polys(triCount, vTri);
+  VecInt2d& polys(m_polys);
+  polys.assign(triCount, vTri);
   m_triIds.resize(triCount);
   for (size_t i = 0, cnt = 0; i < tris.size(); i += 3)
   {
@@ -460,16 +520,45 @@ void XmBathymetryIntersectorImpl::CreateIntersector()
     ++cnt;
   }
 
+  m_intersect = NewIntersector();
+} // XmBathymetryIntersectorImpl::CreateIntersector
+//------------------------------------------------------------------------------
+/// \brief Creates a multi poly intersector from the triangles found in
+/// CreateIntersector
+/// \return The new intersector
+//------------------------------------------------------------------------------
+BSHP<GmMultiPolyIntersector> XmBathymetryIntersectorImpl::NewIntersector()
+{
   BSHP<GmMultiPolyIntersectionSorterTerse> sorterTerse =
     boost::make_shared<GmMultiPolyIntersectionSorterTerse>();
   BSHP<GmMultiPolyIntersectionSorter> sorter = BDPC<GmMultiPolyIntersectionSorter>(sorterTerse);
-  m_intersect = GmMultiPolyIntersector::New(pts, polys, sorter);
-} // XmBathymetryIntersectorImpl::CreateIntersector
+  return GmMultiPolyIntersector::New(m_tin->Points(), m_polys, sorter);
+} // XmBathymetryIntersectorImpl::NewIntersector
+//------------------------------------------------------------------------------
+/// \brief Makes sure there is an intersector for each thread. The
+/// GmMultiPolyIntersector keeps traversal state so it can't be shared.
+/// \param[in] a_numThreads The number of threads that will be used.
+//------------------------------------------------------------------------------
+void XmBathymetryIntersectorImpl::CreateThreadIntersectors(int a_numThreads)
+{
+  while ((int)m_threadIntersect.size() < a_numThreads - 1)
+    m_threadIntersect.push_back(NewIntersector());
+} // XmBathymetryIntersectorImpl::CreateThreadIntersectors
 //------------------------------------------------------------------------------
 /// \brief Intersects a line with a surface
 /// \param a_pts: ???
 //------------------------------------------------------------------------------
 void XmBathymetryIntersectorImpl::Intersect3dPts(VecPt3d& a_pts)
+{
+  Intersect3dPts(*m_intersect, a_pts);
+} // XmBathymetryIntersectorImpl::Intersect3dPts
+//------------------------------------------------------------------------------
+/// \brief Intersects a line with a surface using the given intersector
+/// \param a_intersect: The intersector to traverse the line with
+/// \param a_pts: The line. Truncated at the first intersection.
+//------------------------------------------------------------------------------
+void XmBathymetryIntersectorImpl::Intersect3dPts(GmMultiPolyIntersector& a_intersect,
+                                                 VecPt3d& a_pts)
 {
   VecPt3d& pts(m_tin->Points());
   VecInt& tris(m_tin->Triangles());
@@ -482,7 +571,7 @@ void XmBathymetryIntersectorImpl::Intersect3dPts(VecPt3d& a_pts)
   for (size_t i = 1; !done && i < line.size(); ++i)
   {
     Pt3d &p0(line[i - 1]), &p1(line[i]);
-    m_intersect->TraverseLineSegment(p0.x, p0.y, p1.x, p1.y, triIds, tVals);
+    a_intersect.TraverseLineSegment(p0.x, p0.y, p1.x, p1.y, triIds, tVals);
     for (size_t j = 0; !done && j < triIds.size(); ++j)
     {
       if (triIds[j] < 0)
@@ -615,6 +704,38 @@ BSHP<XmBathymetryIntersector> XmBathymetryIntersector::New(BSHP<TrTin> a_tin, BS
   return p;
 } // XmBathymetryIntersector::New
 //------------------------------------------------------------------------------
+/// \brief Creates a XmBathymetryIntersector class from the part of a
+/// bathymetry store that overlaps the stamp
+/// \param[in] a_store The store with the bathymetry
+/// \param[in] a_stamp The tin defined by the stamp
+/// \param[in] a_halo Distance added around the stamp extents when loading
+/// the bathymetry
+/// \return Shared ptr to a BathymetryIntersector
+//------------------------------------------------------------------------------
+BSHP<XmBathymetryIntersector> XmBathymetryIntersector::New(BSHP<XmBathymetryStore> a_store,
+                                                           BSHP<TrTin> a_stamp,
+                                                           double a_halo)
+{
+  BSHP<XmBathymetryIntersector> p;
+  XM_ENSURE_TRUE(a_store && a_store->IsOpen() && a_stamp, p);
+  Pt3d sMin, sMax;
+  a_stamp->GetExtents(sMin, sMax);
+  sMin.x -= a_halo;
+  sMin.y -= a_halo;
+  sMax.x += a_halo;
+  sMax.y += a_halo;
+  BSHP<TrTin> tin = a_store->LoadRegion(sMin, sMax);
+  XM_ENSURE_TRUE(tin, p);
+
+  XmBathymetryIntersectorImpl* impl = new XmBathymetryIntersectorImpl(tin, a_stamp);
+  p.reset(impl);
+  // use the same tolerance as the whole bathymetry TIN
+  Pt3d pMin, pMax;
+  a_store->GetExtents(pMin, pMax);
+  impl->m_xyTol = Mdist(pMin.x, pMin.y, pMax.x, pMax.y) * 1e-9;
+  return p;
+} // XmBathymetryIntersector::New
+//------------------------------------------------------------------------------
 /// \brief
 //------------------------------------------------------------------------------
 XmBathymetryIntersector::XmBathymetryIntersector()
@@ -636,6 +757,7 @@ XmBathymetryIntersector::~XmBathymetryIntersector()
 using namespace xms;
 #include <xmsstamper/stamper/detail/XmBathymetryIntersector.t.h>
 
+#include <xmscore/misc/environment.h>
 #include <xmscore/testing/TestTools.h>
 
 //------------------------------------------------------------------------------
@@ -666,6 +788,38 @@ void XmBathymetryIntersectorUnitTests::testIntersectCenterLine()
   TS_ASSERT_DELTA_VECPT3D(basePts, io.m_centerLine, tol);
 } // stXmampInterpCrossSectionTests::testIntersectCenterLine
 //------------------------------------------------------------------------------
+/// \brief Tests intersecting the center line with a region loaded from a
+/// bathymetry store gives the same result as the whole TIN
+//------------------------------------------------------------------------------
+void XmBathymetryIntersectorUnitTests::testIntersectCenterLineFromStore()
+{
+  BSHP<TrTin> tin = trBuildTin();
+  VecPt3d& pts(tin->Points());
+  pts[3].z = pts[4].z = pts[7].z = pts[8].z = 10.0;
+  XmStamperIo io;
+  io.m_centerLine = {{7.5, -1, 5}, {7.5, 9, 5}, {15, 6, 5}};
+  XmStamperIo ioStore(io);
+  // stamp covering the center line
+  BSHP<TrTin> stamp = TrTin::New();
+  stamp->Points() = {{6, -2, 5}, {16, -2, 5}, {16, 10, 5}, {6, 10, 5}};
+  stamp->Triangles() = {0, 1, 2, 0, 2, 3};
+
+  XmBathymetryIntersectorImpl b(tin, stamp);
+  b.IntersectCenterLine(io);
+  TS_ASSERT(io.m_centerLine.size() > 3);
+
+  std::string fname(XMS_TEST_PATH + std::string("stamping/bathymetryStoreIntersect_out.bin"));
+  TS_ASSERT(XmBathymetryStore::WriteStore(fname, tin, 2));
+  BSHP<XmBathymetryStore> store = XmBathymetryStore::New();
+  TS_ASSERT(store->Open(fname));
+  BSHP<XmBathymetryIntersector> bStore = XmBathymetryIntersector::New(store, stamp, 1.0);
+  TS_ASSERT(bStore);
+  if (!bStore)
+    return;
+  bStore->IntersectCenterLine(ioStore);
+  TS_ASSERT_DELTA_VECPT3D(io.m_centerLine, ioStore.m_centerLine, 1e-9);
+} // XmBathymetryIntersectorUnitTests::testIntersectCenterLineFromStore
+//------------------------------------------------------------------------------
 /// \brief Tests Intersecting cross sections with TIN
 //------------------------------------------------------------------------------
 void XmBathymetryIntersectorUnitTests::testIntersectXsects()
@@ -686,6 +840,47 @@ void XmBathymetryIntersectorUnitTests::testIntersectXsects()
   TS_ASSERT_DELTA_VECPT3D(basePts, xpts.m_xsPts.m_left[0], tol);
 } // XmBathymetryIntersectorUnitTests::testIntersectXsects
 //------------------------------------------------------------------------------
+/// \brief Tests that intersecting many cross sections on several threads gives
+/// the same result as intersecting them serially
+//------------------------------------------------------------------------------
+void XmBathymetryIntersectorUnitTests::testIntersectXsectsParallel()
+{
+  BSHP<TrTin> tin = trBuildTin(), stTin;
+  VecPt3d& pts(tin->Points());
+  pts[3].z = pts[4].z = pts[7].z = pts[8].z = 10.0;
+
+  XmStamper3dPts xpts;
+  for (int i = 0; i < 200; ++i)
+  {
+    double y = 8.5 + i / 200.0;
+    xpts.m_xsPts.m_centerLine.push_back(Pt3d(5, y, 11));
+    xpts.m_xsPts.m_left.push_back({{6, y, 11}, {7, y, 11}, {8, y, 11}, {9, y, 9}});
+    xpts.m_xsPts.m_right.push_back({{4, y, 11}, {3, y, 11}, {1, y, 9}});
+  }
+  XmStamper3dPts serialPts(xpts);
+
+  XmUtil::SetMaxThreads(1);
+  {
+    XmBathymetryIntersectorImpl b(tin, stTin);
+    b.IntersectXsects(serialPts);
+  }
+  XmUtil::SetMaxThreads(4);
+  {
+    XmBathymetryIntersectorImpl b(tin, stTin);
+    b.IntersectXsects(xpts);
+  }
+  XmUtil::SetMaxThreads(0);
+
+  TS_ASSERT_EQUALS(serialPts.m_xsPts.m_left.size(), xpts.m_xsPts.m_left.size());
+  for (size_t i = 0; i < serialPts.m_xsPts.m_left.size(); ++i)
+  {
+    TS_ASSERT_EQUALS_VEC(serialPts.m_xsPts.m_left[i], xpts.m_xsPts.m_left[i]);
+    TS_ASSERT_EQUALS_VEC(serialPts.m_xsPts.m_right[i], xpts.m_xsPts.m_right[i]);
+  }
+  VecPt3d basePts = {{6, 8.5, 11}, {7, 8.5, 11}, {8, 8.5, 11}, {8.5, 8.5, 10}};
+  TS_ASSERT_DELTA_VECPT3D(basePts, xpts.m_xsPts.m_left[0], 1e-2);
+} // XmBathymetryIntersectorUnitTests::testIntersectXsectsParallel
+//------------------------------------------------------------------------------
 /// \brief Tests point classification compared to the TIN (on, below, above,
 /// outside)
 //------------------------------------------------------------------------------
@@ -29,6 +29,7 @@ namespace xms
 class XmStamper3dPts;
 class XmStamperIo;
 class TrTin;
+class XmBathymetryStore;
 
 //----- Function prototypes ----------------------------------------------------
 
@@ -39,6 +40,9 @@ class XmBathymetryIntersector
 {
 public:
   static BSHP<XmBathymetryIntersector> New(BSHP<TrTin> a_tin, BSHP<TrTin> a_stamp);
+  static BSHP<XmBathymetryIntersector> New(BSHP<XmBathymetryStore> a_store,
+                                           BSHP<TrTin> a_stamp,
+                                           double a_halo);
 
   XmBathymetryIntersector();
   virtual ~XmBathymetryIntersector();
@@ -48,6 +52,7 @@ public:
   virtual void DecomposeCenterLine(XmStamperIo& a_io, std::vector<XmStamperIo>& a_vIo) = 0;
   virtual void IntersectXsects(XmStamper3dPts& a_pts) = 0;
   virtual void IntersectEndCaps(XmStamperIo& a_io, XmStamper3dPts& a_pts) = 0;
+  virtual double XyTol() const = 0;
 
 private:
   XM_DISALLOW_COPY_AND_ASSIGN(XmBathymetryIntersector);
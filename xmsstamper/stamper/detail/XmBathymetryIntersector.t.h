@@ -31,7 +31,9 @@ class XmBathymetryIntersectorUnitTests : public CxxTest::TestSuite
 public:
   void testCreateClass();
   void testIntersectCenterLine();
+  void testIntersectCenterLineFromStore();
   void testIntersectXsects();
+  void testIntersectXsectsParallel();
   void testClassifyPoints();
   void testDescomposeCenterLine();
 }; // XmBathymetryIntersectorUnitTests
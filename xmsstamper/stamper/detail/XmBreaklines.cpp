@@ -56,13 +56,15 @@ public:
   XmBreaklinesImpl();
   ~XmBreaklinesImpl();
 
-  virtual bool CreateBreaklines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes) override;
+  virtual bool CreateBreaklines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx) override;
   //------------------------------------------------------------------------------
   /// \brief Returns the outer polygon of the stamp operation
   /// \return The outer polyogn.
   //------------------------------------------------------------------------------
   virtual const VecInt& GetOuterPolygon() override { return m_outerPoly; }
-  bool BreaklinesIntersect(const VecInt2d& a_bl, const VecPt3d& a_pts) override;
+  bool BreaklinesIntersect(const VecInt& a_offsets,
+                           const VecInt& a_blPts,
+                           const VecPt3d& a_pts) override;
 
   void CreateOuterPolygonBreakline(cs3dPtIdx& a_ptIdx,
                                    VecInt& a_leftCsEndPts,
@@ -103,60 +105,56 @@ XmBreaklinesImpl::~XmBreaklinesImpl()
 {
 } // XmBreaklinesImpl::~XmBreaklinesImpl
 //------------------------------------------------------------------------------
-/// \brief Creates breaklines
+/// \brief Creates breaklines. They are written to the m_outBreakLineOffsets,
+/// m_outBreakLinePts and m_outBreakLineTypes members of a_io.
 /// \param[in,out] a_io XmamperIo class
 /// \param[in] a_ptIdx The indexes of the points in the TIN created by stamping
-/// \param[out] a_blTypes The type of breakline (centerline, shoulder, xsect)
 /// \return true if breaklines successfully created.
 //------------------------------------------------------------------------------
-bool XmBreaklinesImpl::CreateBreaklines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes)
+bool XmBreaklinesImpl::CreateBreaklines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx)
 {
-  a_blTypes.resize(0);
-  VecInt2d& b(a_io.m_outBreakLines);
+  a_io.m_outBreakLineOffsets.assign(1, 0);
+  a_io.m_outBreakLinePts.resize(0);
+  a_io.m_outBreakLineTypes.resize(0);
+  VecInt& b(a_io.m_outBreakLinePts);
   // break line for the center line
-  b.push_back(a_ptIdx.m_centerLine);
-  a_blTypes.push_back(BL_CENTERLINE);
+  b.insert(b.end(), a_ptIdx.m_centerLine.begin(), a_ptIdx.m_centerLine.end());
+  EndBreakline(a_io, BL_CENTERLINE);
   // break line for each cross section
   VecInt leftCsEndPts, rightCsEndPts, leftShoulder, rightShoulder;
   VecInt firstXsPts, lastXsPts;
   for (size_t i = 0; i < a_ptIdx.m_centerLine.size(); ++i)
   {
-    VecInt ixs;
+    size_t start = b.size();
     // reverse add the left side
 	if (i < a_ptIdx.m_xsPts.m_left.size())
     {
       auto p = a_ptIdx.m_xsPts.m_left[i].rbegin();
       auto end = a_ptIdx.m_xsPts.m_left[i].rend();
       for (; p != end; ++p)
-        ixs.push_back(*p);
+        b.push_back(*p);
     }
     // put in the center line point
-    ixs.push_back(a_ptIdx.m_centerLine[i]);
+    b.push_back(a_ptIdx.m_centerLine[i]);
     // forward add the right side
 	if (i < a_ptIdx.m_xsPts.m_right.size())
     {
       auto p = a_ptIdx.m_xsPts.m_right[i].begin();
       auto end = a_ptIdx.m_xsPts.m_right[i].end();
       for (; p != end; ++p)
-        ixs.push_back(*p);
-    }
-    b.push_back(ixs);
-    a_blTypes.push_back(BL_XSECT);
-    if (i == 0)
-    {
-      firstXsPts = ixs;
-      a_blTypes.back() = BL_END;
-    }
-    if (i + 1 == a_ptIdx.m_centerLine.size())
-    {
-      lastXsPts = ixs;
-      a_blTypes.back() = BL_END;
+        b.push_back(*p);
     }
+    bool first(i == 0), last(i + 1 == a_ptIdx.m_centerLine.size());
+    if (first)
+      firstXsPts.assign(b.begin() + start, b.end());
+    if (last)
+      lastXsPts.assign(b.begin() + start, b.end());
+    EndBreakline(a_io, first || last ? BL_END : BL_XSECT);
 
     // left side shoulder and endpts
 	if (i < a_ptIdx.m_xsPts.m_left.size())
     {
-      VecInt& v(a_ptIdx.m_xsPts.m_left[i]);
+      stIdxRange v(a_ptIdx.m_xsPts.m_left[i]);
       int leftIdx = std::max(a_io.m_cs[i].m_idxLeftShoulder - 1, 0);
       if (!v.empty())
       {
@@ -177,7 +175,7 @@ bool XmBreaklinesImpl::CreateBreaklines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, V
     // right side shoulder and endpts
 	if (i < a_ptIdx.m_xsPts.m_right.size())
     {
-      VecInt& v(a_ptIdx.m_xsPts.m_right[i]);
+      stIdxRange v(a_ptIdx.m_xsPts.m_right[i]);
       int rightIdx = std::max(a_io.m_cs[i].m_idxRightShoulder - 1, 0);
       if (!v.empty())
       {
@@ -196,17 +194,13 @@ bool XmBreaklinesImpl::CreateBreaklines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, V
       }
     }
   }
-  b.push_back(leftCsEndPts);
-  a_blTypes.push_back(BL_END);
-  b.push_back(rightCsEndPts);
-  a_blTypes.push_back(BL_END);
-  b.push_back(leftShoulder);
-  a_blTypes.push_back(BL_SHOULDER);
-  b.push_back(rightShoulder);
-  a_blTypes.push_back(BL_SHOULDER);
+  AddBreakline(a_io, leftCsEndPts, BL_END);
+  AddBreakline(a_io, rightCsEndPts, BL_END);
+  AddBreakline(a_io, leftShoulder, BL_SHOULDER);
+  AddBreakline(a_io, rightShoulder, BL_SHOULDER);
 
-  m_slopedAbutment->GetEndCapBreakLines(a_io, a_ptIdx, a_blTypes);
-  m_guideBank->GetEndCapBreakLines(a_io, a_ptIdx, a_blTypes);
+  m_slopedAbutment->GetEndCapBreakLines(a_io, a_ptIdx);
+  m_guideBank->GetEndCapBreakLines(a_io, a_ptIdx);
 
   CreateOuterPolygonBreakline(a_ptIdx, leftCsEndPts, rightCsEndPts, firstXsPts, lastXsPts, a_io);
 
@@ -273,26 +267,28 @@ void XmBreaklinesImpl::GetEndCapEndPoints(cs3dPtIdx& a_ptIdx,
 } // XmBreaklinesImpl::GetEndCapEndPoints
 //------------------------------------------------------------------------------
 /// \brief Check if any breakline segments intersect
-/// \param[in] a_bl Breaklines (indexes to the points)
+/// \param[in] a_offsets Start of each breakline in a_blPts (one extra at end)
+/// \param[in] a_blPts Point indexes of all breaklines
 /// \param[in] a_pts The point locations created in the stamp operation
 /// \return true if any breakline segments intersect a segment with a non shared
 /// point index
 //------------------------------------------------------------------------------
-bool XmBreaklinesImpl::BreaklinesIntersect(const VecInt2d& a_bl, const VecPt3d& a_pts)
+bool XmBreaklinesImpl::BreaklinesIntersect(const VecInt& a_offsets,
+                                           const VecInt& a_blPts,
+                                           const VecPt3d& a_pts)
 {
-  const VecInt2d& vbl(a_bl);
   // create vector of breakline segments
   std::pair<int, int> p;
   std::vector<std::pair<int, int>> vSegs;
   Pt3d bMin, bMax;
   ValueBox aBox;
   std::vector<ValueBox> vBoxes;
-  for (const auto& bl : vbl)
+  for (size_t b = 0; b + 1 < a_offsets.size(); ++b)
   {
-    for (size_t i = 1; i < bl.size(); ++i)
+    for (int i = a_offsets[b] + 1; i < a_offsets[b + 1]; ++i)
     {
-      p.first = bl[i - 1];
-      p.second = bl[i];
+      p.first = a_blPts[i - 1];
+      p.second = a_blPts[i];
       const Pt3d &p0(a_pts[p.first]), &p1(a_pts[p.second]);
       if (p0.x < p1.x)
       {
@@ -365,6 +361,31 @@ BSHP<XmBreaklines> XmBreaklines::New()
   return p;
 } // XmBreaklines::New
 //------------------------------------------------------------------------------
+/// \brief Appends a breakline to the m_outBreakLineOffsets, m_outBreakLinePts
+/// and m_outBreakLineTypes members of a_io.
+/// \param[in,out] a_io StamperIo class
+/// \param[in] a_bl The point indexes of the breakline
+/// \param[in] a_type The type of breakline (centerline, shoulder, xsect, end)
+//------------------------------------------------------------------------------
+void XmBreaklines::AddBreakline(XmStamperIo& a_io, const VecInt& a_bl, int a_type)
+{
+  a_io.m_outBreakLinePts.insert(a_io.m_outBreakLinePts.end(), a_bl.begin(), a_bl.end());
+  EndBreakline(a_io, a_type);
+} // XmBreaklines::AddBreakline
+//------------------------------------------------------------------------------
+/// \brief Ends the breakline made of the points added to a_io.m_outBreakLinePts
+/// since the last breakline.
+/// \param[in,out] a_io StamperIo class
+/// \param[in] a_type The type of breakline (centerline, shoulder, xsect, end)
+//------------------------------------------------------------------------------
+void XmBreaklines::EndBreakline(XmStamperIo& a_io, int a_type)
+{
+  if (a_io.m_outBreakLineOffsets.empty())
+    a_io.m_outBreakLineOffsets.push_back(0);
+  a_io.m_outBreakLineOffsets.push_back((int)a_io.m_outBreakLinePts.size());
+  a_io.m_outBreakLineTypes.push_back(a_type);
+} // XmBreaklines::EndBreakline
+//------------------------------------------------------------------------------
 /// \brief
 //------------------------------------------------------------------------------
 XmBreaklines::XmBreaklines()
@@ -42,12 +42,17 @@ public:
   /// enumeration to identify types of breaklines
   enum { BL_CENTERLINE = 0, BL_XSECT, BL_SHOULDER, BL_END };
 
+  static void AddBreakline(XmStamperIo& a_io, const VecInt& a_bl, int a_type);
+  static void EndBreakline(XmStamperIo& a_io, int a_type);
+
   /// \cond
-  virtual bool CreateBreaklines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes) = 0;
+  virtual bool CreateBreaklines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx) = 0;
 
   virtual const VecInt& GetOuterPolygon() = 0;
 
-  virtual bool BreaklinesIntersect(const VecInt2d& a_bl, const VecPt3d& a_pts) = 0;
+  virtual bool BreaklinesIntersect(const VecInt& a_offsets,
+                                   const VecInt& a_blPts,
+                                   const VecPt3d& a_pts) = 0;
 
 private:
   XM_DISALLOW_COPY_AND_ASSIGN(XmBreaklines);
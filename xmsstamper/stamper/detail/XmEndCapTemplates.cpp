@@ -0,0 +1,198 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup stamping
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsstamper/stamper/detail/XmEndCapTemplates.h>
+
+// 3. Standard library headers
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmsstamper/stamper/XmStamperIo.h>
+
+// 6. Non-shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Classes / Structs ------------------------------------------------------
+
+//----- Internal functions -----------------------------------------------------
+namespace
+{
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The cached templates. The oldest template is dropped when the cache
+/// is full.
+struct iTemplateCache
+{
+  std::mutex m_mutex;  ///< guards the other members
+  size_t m_max = 256;  ///< max number of templates. 0 turns the cache off.
+  std::deque<std::string> m_order; ///< keys in the order they were added
+  /// cross sections for each key
+  std::unordered_map<std::string, std::vector<XmStampCrossSection>> m_templates;
+};
+//------------------------------------------------------------------------------
+/// \brief Gets the process wide cache.
+/// \return The cache.
+//------------------------------------------------------------------------------
+iTemplateCache& iCache()
+{
+  static iTemplateCache cache;
+  return cache;
+} // iCache
+//------------------------------------------------------------------------------
+/// \brief Appends the bytes of a value to a key.
+/// \param[in,out] a_key The key
+/// \param[in] a_val The value
+//------------------------------------------------------------------------------
+template <typename T>
+void iAppendBytes(std::string& a_key, const T& a_val)
+{
+  a_key.append(reinterpret_cast<const char*>(&a_val), sizeof(T));
+} // iAppendBytes
+
+} // unnamed namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmEndCapTemplates
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Gets the cross sections stored for a key.
+/// \param[in] a_key The key made with the AppendToKey methods
+/// \param[out] a_cs The cross sections
+/// \return true if the key was found.
+//------------------------------------------------------------------------------
+bool XmEndCapTemplates::Find(const std::string& a_key, std::vector<XmStampCrossSection>& a_cs)
+{
+  iTemplateCache& cache(iCache());
+  std::lock_guard<std::mutex> lock(cache.m_mutex);
+  auto it = cache.m_templates.find(a_key);
+  if (it == cache.m_templates.end())
+    return false;
+  a_cs = it->second;
+  return true;
+} // XmEndCapTemplates::Find
+//------------------------------------------------------------------------------
+/// \brief Stores the cross sections for a key.
+/// \param[in] a_key The key made with the AppendToKey methods
+/// \param[in] a_cs The cross sections
+//------------------------------------------------------------------------------
+void XmEndCapTemplates::Add(const std::string& a_key, const std::vector<XmStampCrossSection>& a_cs)
+{
+  iTemplateCache& cache(iCache());
+  std::lock_guard<std::mutex> lock(cache.m_mutex);
+  if (cache.m_max == 0 || cache.m_templates.find(a_key) != cache.m_templates.end())
+    return;
+  while (cache.m_order.size() >= cache.m_max)
+  {
+    cache.m_templates.erase(cache.m_order.front());
+    cache.m_order.pop_front();
+  }
+  cache.m_templates[a_key] = a_cs;
+  cache.m_order.push_back(a_key);
+} // XmEndCapTemplates::Add
+//------------------------------------------------------------------------------
+/// \brief Removes all of the templates.
+//------------------------------------------------------------------------------
+void XmEndCapTemplates::Clear()
+{
+  iTemplateCache& cache(iCache());
+  std::lock_guard<std::mutex> lock(cache.m_mutex);
+  cache.m_templates.clear();
+  cache.m_order.clear();
+} // XmEndCapTemplates::Clear
+//------------------------------------------------------------------------------
+/// \brief Sets the max number of templates that are kept. The oldest are
+/// removed when there are more.
+/// \param[in] a_maxTemplates The max number of templates. 0 turns off the
+/// cache. The default is 256.
+//------------------------------------------------------------------------------
+void XmEndCapTemplates::SetMaxTemplates(size_t a_maxTemplates)
+{
+  iTemplateCache& cache(iCache());
+  std::lock_guard<std::mutex> lock(cache.m_mutex);
+  cache.m_max = a_maxTemplates;
+  while (cache.m_order.size() > cache.m_max)
+  {
+    cache.m_templates.erase(cache.m_order.front());
+    cache.m_order.pop_front();
+  }
+} // XmEndCapTemplates::SetMaxTemplates
+//------------------------------------------------------------------------------
+/// \brief Gets the number of templates in the cache.
+/// \return The number of templates.
+//------------------------------------------------------------------------------
+size_t XmEndCapTemplates::NumTemplates()
+{
+  iTemplateCache& cache(iCache());
+  std::lock_guard<std::mutex> lock(cache.m_mutex);
+  return cache.m_templates.size();
+} // XmEndCapTemplates::NumTemplates
+//------------------------------------------------------------------------------
+/// \brief Appends a value to a key.
+/// \param[in,out] a_key The key
+/// \param[in] a_val The value
+//------------------------------------------------------------------------------
+void XmEndCapTemplates::AppendToKey(std::string& a_key, double a_val)
+{
+  iAppendBytes(a_key, a_val);
+} // XmEndCapTemplates::AppendToKey
+//------------------------------------------------------------------------------
+/// \brief Appends a value to a key.
+/// \param[in,out] a_key The key
+/// \param[in] a_val The value
+//------------------------------------------------------------------------------
+void XmEndCapTemplates::AppendToKey(std::string& a_key, int a_val)
+{
+  iAppendBytes(a_key, a_val);
+} // XmEndCapTemplates::AppendToKey
+//------------------------------------------------------------------------------
+/// \brief Appends points to a key.
+/// \param[in,out] a_key The key
+/// \param[in] a_pts The points
+//------------------------------------------------------------------------------
+void XmEndCapTemplates::AppendToKey(std::string& a_key, const VecPt3d& a_pts)
+{
+  iAppendBytes(a_key, a_pts.size());
+  for (const auto& p : a_pts)
+  {
+    iAppendBytes(a_key, p.x);
+    iAppendBytes(a_key, p.y);
+    iAppendBytes(a_key, p.z);
+  }
+} // XmEndCapTemplates::AppendToKey
+//------------------------------------------------------------------------------
+/// \brief Appends a cross section to a key.
+/// \param[in,out] a_key The key
+/// \param[in] a_cs The cross section
+//------------------------------------------------------------------------------
+void XmEndCapTemplates::AppendToKey(std::string& a_key, const XmStampCrossSection& a_cs)
+{
+  AppendToKey(a_key, a_cs.m_left);
+  AppendToKey(a_key, a_cs.m_leftMax);
+  AppendToKey(a_key, a_cs.m_idxLeftShoulder);
+  AppendToKey(a_key, a_cs.m_right);
+  AppendToKey(a_key, a_cs.m_rightMax);
+  AppendToKey(a_key, a_cs.m_idxRightShoulder);
+} // XmEndCapTemplates::AppendToKey
+
+} // namespace xms
@@ -0,0 +1,57 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup stamping
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+#include <string>
+#include <vector>
+
+// 4. External library headers
+#include <xmscore/stl/vector.h>
+
+// 5. Shared code headers
+
+//----- Namespace declaration --------------------------------------------------
+namespace xms
+{
+//----- Forward declarations ---------------------------------------------------
+class XmStampCrossSection;
+
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Structs / Classes ------------------------------------------------------
+
+//----- Function prototypes ----------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmEndCapTemplates
+/// \brief Process wide cache of end cap cross sections in their local frame
+/// (before they are moved to the end of the center line). Stamps with the same
+/// end cap and cross section reuse the cross sections instead of interpolating
+/// them again. Keys hold the exact bits of the inputs so cached results are
+/// the same as computed ones. Safe to use from multiple threads.
+class XmEndCapTemplates
+{
+public:
+  static bool Find(const std::string& a_key, std::vector<XmStampCrossSection>& a_cs);
+  static void Add(const std::string& a_key, const std::vector<XmStampCrossSection>& a_cs);
+  static void Clear();
+  static void SetMaxTemplates(size_t a_maxTemplates);
+  static size_t NumTemplates();
+
+  static void AppendToKey(std::string& a_key, double a_val);
+  static void AppendToKey(std::string& a_key, int a_val);
+  static void AppendToKey(std::string& a_key, const VecPt3d& a_pts);
+  static void AppendToKey(std::string& a_key, const XmStampCrossSection& a_cs);
+
+private:
+  XmEndCapTemplates();
+}; // XmEndCapTemplates
+
+} // namespace xms
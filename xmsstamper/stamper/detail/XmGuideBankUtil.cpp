@@ -13,6 +13,7 @@
 #include <xmsstamper/stamper/detail/XmGuideBankUtil.h>
 
 // 3. Standard library headers
+#include <algorithm>
 #include <cmath>
 
 // 4. External library headers
@@ -22,6 +23,7 @@
 #include <xmsgrid/geometry/geoms.h>
 #include <xmsstamper/stamper/XmStamperIo.h>
 #include <xmsstamper/stamper/detail/XmBreaklines.h>
+#include <xmsstamper/stamper/detail/XmEndCapTemplates.h>
 #include <xmsstamper/stamper/detail/XmStamper3dPts.h>
 #include <xmsstamper/stamper/detail/XmStampInterpCrossSection.h>
 #include <xmsstamper/stamper/detail/XmUtil.h>
@@ -40,6 +42,56 @@ namespace xms
 
 //----- Classes / Structs ------------------------------------------------------
 
+namespace
+{
+const int MAX_GUIDEBANK_PTS = 500; ///< upper limit when sampling by chord deviation
+
+//------------------------------------------------------------------------------
+/// \brief Gets the elevation along the major axis of the guidebank ellipse
+/// \param[in] a_gb The guidebank
+/// \param[in] a_x Distance along the minor axis (0 to m_radius2)
+/// \return The distance along the major axis.
+//------------------------------------------------------------------------------
+double iGuidebankMajor(const XmGuidebank& a_gb, double a_x)
+{
+  double r = 1.0 - pow(a_gb.m_radius2 - a_x, 2.0) / pow(a_gb.m_radius2, 2.0);
+  return a_gb.m_radius1 * sqrt(std::max(0.0, r));
+} // iGuidebankMajor
+//------------------------------------------------------------------------------
+/// \brief Gets the number of guidebank center line points so that the chords
+/// between them are within a_maxChordDeviation of the ellipse. Points are
+/// spaced evenly along the minor axis, as with a fixed number of points.
+/// \param[in] a_gb The guidebank
+/// \param[in] a_maxChordDeviation Max distance between a chord and the ellipse
+/// \return The number of points.
+//------------------------------------------------------------------------------
+int iGuidebankNumPts(const XmGuidebank& a_gb, double a_maxChordDeviation)
+{
+  if (a_gb.m_radius1 <= 0.0 || a_gb.m_radius2 <= 0.0)
+    return a_gb.m_nPts;
+  int nPts = 3;
+  for (; nPts < MAX_GUIDEBANK_PTS; ++nPts)
+  {
+    double dx = a_gb.m_radius2 / (double)(nPts - 1);
+    double maxDev(0), y0(0);
+    for (int i = 1; i < nPts && maxDev <= a_maxChordDeviation; ++i)
+    {
+      double x0 = dx * (i - 1);
+      double y1 = iGuidebankMajor(a_gb, dx * i);
+      double ym = iGuidebankMajor(a_gb, x0 + 0.5 * dx);
+      // distance from the ellipse at the middle of the interval to the chord
+      double len = sqrt(dx * dx + (y1 - y0) * (y1 - y0));
+      double dev = fabs((y1 - y0) * 0.5 * dx - dx * (ym - y0)) / len;
+      maxDev = std::max(maxDev, dev);
+      y0 = y1;
+    }
+    if (maxDev <= a_maxChordDeviation)
+      break;
+  }
+  return nPts;
+} // iGuidebankNumPts
+} // unnamed namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief Implementaion of XmGuideBankUtil
 class XmGuideBankUtilImpl : public XmGuideBankUtil
@@ -53,19 +105,17 @@ public:
                                   VecInt& a_firstEndCapEndPts,
                                   VecInt& a_lastEndCapEndPts,
                                   XmStamperIo& a_io) override;
-  virtual void GetEndCapBreakLines(XmStamperIo& a_io,
-                                   cs3dPtIdx& a_ptIdx,
-                                   VecInt& a_blTypes) override;
+  virtual void GetEndCapBreakLines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx) override;
 
   void GuideBankCenterLine();
   void AdjustEndCapCrossSection();
   void CrossSectionTo3dPts();
   void GuideBankEndCap();
-  void BreakLinesAddCenterLine(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes);
-  void BreakLinesAddEndPoints(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes);
-  void BreakLinesAddCrossSections(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes);
-  void BreakLinesAddEndCap(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes);
-  void BreakLinesAddShoulders(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes);
+  void BreakLinesAddCenterLine(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx);
+  void BreakLinesAddEndPoints(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx);
+  void BreakLinesAddCrossSections(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx);
+  void BreakLinesAddEndCap(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx);
+  void BreakLinesAddShoulders(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx);
 
   bool m_first;            ///< flag indicating if this is from the first end of the stamp
   XmStamperIo* m_io;       ///< io class that has the stamping inputs
@@ -160,6 +210,8 @@ void XmGuideBankUtilImpl::GuideBankCenterLine()
 
   // calculate dx and dy based on the minor axis
   XmGuidebank& gb(cap.m_guidebank);
+  if (cap.m_maxChordDeviation > 0.0)
+    gb.m_nPts = iGuidebankNumPts(gb, cap.m_maxChordDeviation);
   double dy(0), dx = gb.m_radius2 / (double)(gb.m_nPts - 1);
   double dx1, dy1;
   gmComponentMagnitudes(&dx1, &dy1, &dx, &minorAngle, false);
@@ -192,11 +244,11 @@ void XmGuideBankUtilImpl::GuideBankCenterLine()
 void XmGuideBankUtilImpl::AdjustEndCapCrossSection()
 {
   XmStamperEndCap cap;
-  XmStampCrossSection cs;
+  XmStampCrossSection cs, buf;
   if (m_first)
   {
     cap = m_io->m_firstEndCap;
-    cs = m_io->m_cs[0];
+    cs = m_io->CrossSection(0, buf);
     // we need to swap the sides of the cross section
     XmStampCrossSection c1 = cs;
     cs.m_idxLeftShoulder = c1.m_idxRightShoulder;
@@ -209,7 +261,7 @@ void XmGuideBankUtilImpl::AdjustEndCapCrossSection()
   else
   {
     cap = m_io->m_lastEndCap;
-    cs = m_io->m_cs.back();
+    cs = m_io->CrossSection(m_io->m_cs.size() - 1, buf);
   }
   XmGuidebank& gb(cap.m_guidebank);
   // adjust the cross section for guide bank width
@@ -252,13 +304,14 @@ void XmGuideBankUtilImpl::CrossSectionTo3dPts()
     left = &m_3dpts->m_last_endcap.m_left;
     right = &m_3dpts->m_last_endcap.m_right;
   }
+  VecDbl leftCos, leftSin, rightCos, rightSin;
+  XmUtil::GetCenterLineSinCos(m_centerline, 1, leftCos, leftSin, rightCos, rightSin);
   for (size_t i = 1; i < m_centerline.size(); ++i)
   {
     Pt3d& p(m_centerline[i]);
-    double leftAngle, rightAngle;
-    XmUtil::GetAnglesFromCenterLine(i, m_centerline, leftAngle, rightAngle);
-    XmUtil::ConvertXsPointsTo3d(p, cs.m_left, cs.m_leftMax, leftAngle, *left);
-    XmUtil::ConvertXsPointsTo3d(p, cs.m_right, cs.m_rightMax, rightAngle, *right);
+    XmUtil::ConvertXsPointsTo3d(p, cs.m_left, cs.m_leftMax, leftCos[i - 1], leftSin[i - 1], *left);
+    XmUtil::ConvertXsPointsTo3d(p, cs.m_right, cs.m_rightMax, rightCos[i - 1], rightSin[i - 1],
+                                *right);
   }
 } // XmGuideBankUtilImpl::CrossSectionTo3dPts
 //------------------------------------------------------------------------------
@@ -267,20 +320,6 @@ void XmGuideBankUtilImpl::CrossSectionTo3dPts()
 void XmGuideBankUtilImpl::GuideBankEndCap()
 {
   XM_ENSURE_TRUE(m_centerline.size() > 1);
-  // average the left and right side to make the cross section that extends
-  // out along the center line of the guidebank
-  XmStampCrossSection leftCs(m_cs), rightCs(m_cs);
-  double leftLen = leftCs.m_leftMax;
-  double rightLen = rightCs.m_rightMax;
-  leftCs.m_idxRightShoulder = leftCs.m_idxLeftShoulder;
-  leftCs.m_right = leftCs.m_left;
-  leftCs.m_rightMax = leftCs.m_leftMax;
-  rightCs.m_idxLeftShoulder = rightCs.m_idxRightShoulder;
-  rightCs.m_left = rightCs.m_right;
-  rightCs.m_leftMax = rightCs.m_rightMax;
-  XmUtil::ScaleCrossSectionXvals(leftCs, 1 / leftCs.m_leftMax);
-  XmUtil::ScaleCrossSectionXvals(rightCs, 1 / rightCs.m_rightMax);
-
   double factor(1);
   // get vector for end of center line
   size_t ix = m_centerline.size() - 2;
@@ -304,27 +343,56 @@ void XmGuideBankUtilImpl::GuideBankEndCap()
     }
   };
 
-  // interpolate cross sections
-  BSHP<XmStampInterpCrossSection> interp = XmStampInterpCrossSection::New();
-  VecDbl vLen(11);
-  std::vector<XmStampCrossSection> vCs(11);
-  double incr = 1.0 / 12.0, percent(0);
+  // interpolate cross sections. They only depend on the cross section so
+  // they are shared by guidebanks with the same cross section.
+  std::string key("guidebank");
+  XmEndCapTemplates::AppendToKey(key, m_cs);
+  std::vector<XmStampCrossSection> vCs;
+  if (!XmEndCapTemplates::Find(key, vCs))
+  {
+    // average the left and right side to make the cross section that extends
+    // out along the center line of the guidebank
+    XmStampCrossSection leftCs(m_cs), rightCs(m_cs);
+    double leftLen = leftCs.m_leftMax;
+    double rightLen = rightCs.m_rightMax;
+    leftCs.m_idxRightShoulder = leftCs.m_idxLeftShoulder;
+    leftCs.m_right = leftCs.m_left;
+    leftCs.m_rightMax = leftCs.m_leftMax;
+    rightCs.m_idxLeftShoulder = rightCs.m_idxRightShoulder;
+    rightCs.m_left = rightCs.m_right;
+    rightCs.m_leftMax = rightCs.m_rightMax;
+    XmUtil::ScaleCrossSectionXvals(leftCs, 1 / leftCs.m_leftMax);
+    XmUtil::ScaleCrossSectionXvals(rightCs, 1 / rightCs.m_rightMax);
+
+    BSHP<XmStampInterpCrossSection> interp = XmStampInterpCrossSection::New();
+    double incr = 1.0 / 12.0, percent(0);
+    // interp the lengths and cross sections
+    VecDbl percents(11);
+    for (int i = 0; i < 11; ++i)
+    {
+      percent += incr;
+      percents[i] = percent;
+    }
+    interp->InterpCs(leftCs, rightCs, percents, vCs);
+    vCs.resize(11);
+    for (int i = 0; i < 11; ++i)
+    {
+      double len = leftLen + percents[i] * (leftLen - rightLen);
+      XmUtil::ScaleCrossSectionXvals(vCs[i], len);
+    }
+    XmEndCapTemplates::Add(key, vCs);
+  }
+
   double angle = startAngle;
   // add to the left
   VecPt3d2d* leftpts3d(&m_3dpts->m_first_endcap.m_left);
   if (!m_first)
     leftpts3d = &m_3dpts->m_last_endcap.m_left;
-  // interp the lengths and cross sections
-  for (int i = 0; i < 11; ++i)
+  for (size_t i = 0; i < vCs.size(); ++i)
   {
-    percent += incr;
     angle -= 15.0;
     angle = gmConvertAngleToBetween0And360(angle);
 
-    vLen[i] = leftLen + percent * (leftLen - rightLen);
-    interp->InterpCs(leftCs, rightCs, percent, vCs[i]);
-    XmUtil::ScaleCrossSectionXvals(vCs[i], vLen[i]);
-
     VecPt3d pts;
     myLambda(pts, vCs[i].m_left, angle, p0, factor);
     leftpts3d->push_back(pts);
@@ -343,29 +411,26 @@ void XmGuideBankUtilImpl::GetEndCapEndPoints(cs3dPtIdx& a_ptIdx,
                                              XmStamperIo& a_io)
 {
   // utility functions
-  auto myLambda_AddEndPtsForward = [](VecInt& a_endPts, VecInt2d& a_pts2d) {
-    auto it = a_pts2d.begin();
-    auto end = a_pts2d.end();
-    for (; it != end; ++it)
+  auto myLambda_AddEndPtsForward = [](VecInt& a_endPts, const stIdxRows& a_pts2d) {
+    for (size_t i = 0; i < a_pts2d.size(); ++i)
     {
-      if (!it->empty())
-        a_endPts.push_back(it->back());
+      if (!a_pts2d[i].empty())
+        a_endPts.push_back(a_pts2d[i].back());
     }
   };
-  auto myLambda_AddEndPtsReverse = [](VecInt& a_endPts, VecInt2d& a_pts2d) {
-    auto it = a_pts2d.rbegin();
-    auto end = a_pts2d.rend();
-    for (; it != end; ++it)
+  auto myLambda_AddEndPtsReverse = [](VecInt& a_endPts, const stIdxRows& a_pts2d) {
+    for (size_t i = a_pts2d.size(); i > 0; --i)
     {
-      if (!it->empty())
-        a_endPts.push_back(it->back());
+      if (!a_pts2d[i - 1].empty())
+        a_endPts.push_back(a_pts2d[i - 1].back());
     }
   };
-  auto myLambda_AddEndPtsLastXs = [](VecInt& a_endPts, int a_clPtIdx, VecInt2d& a_pts2dReverse,
-                                      VecInt2d& a_pts2dForward) {
+  auto myLambda_AddEndPtsLastXs = [](VecInt& a_endPts, int a_clPtIdx,
+                                      const stIdxRows& a_pts2dReverse,
+                                      const stIdxRows& a_pts2dForward) {
     { // reverse add pts from cross section at end of guidebank that intersected bathymetry
       // skip the first point because it was already added
-      VecInt& pts(a_pts2dReverse.back());
+      stIdxRange pts(a_pts2dReverse.back());
       auto it = pts.rbegin();
       it++;
       auto end = pts.rend();
@@ -374,7 +439,7 @@ void XmGuideBankUtilImpl::GetEndCapEndPoints(cs3dPtIdx& a_ptIdx,
     a_endPts.push_back(a_clPtIdx);
     { // forward add pts from cross section at end of guidebank that intersected bathymetry
       // skip the last point because it will be added later
-      VecInt& pts(a_pts2dForward.back());
+      stIdxRange pts(a_pts2dForward.back());
       auto it = pts.begin();
       auto end = pts.end();
       end--;
@@ -384,7 +449,7 @@ void XmGuideBankUtilImpl::GetEndCapEndPoints(cs3dPtIdx& a_ptIdx,
 
   if (a_io.m_lastEndCap.m_type == 0)
   { // last end cap
-    VecInt& cl(a_ptIdx.m_last_end_cap.m_centerLine);
+    const stIdxRange& cl(a_ptIdx.m_last_end_cap.m_centerLine);
     myLambda_AddEndPtsForward(a_lastEndCapEndPts, a_ptIdx.m_last_end_cap.m_left);
     // if the guidebank was cut off because of an intersection then we need to
     // use the last cross section also
@@ -397,7 +462,7 @@ void XmGuideBankUtilImpl::GetEndCapEndPoints(cs3dPtIdx& a_ptIdx,
   }
   if (a_io.m_firstEndCap.m_type == 0)
   { // first end cap
-    VecInt& cl(a_ptIdx.m_first_end_cap.m_centerLine);
+    const stIdxRange& cl(a_ptIdx.m_first_end_cap.m_centerLine);
     myLambda_AddEndPtsForward(a_firstEndCapEndPts, a_ptIdx.m_first_end_cap.m_right);
     // if the guidebank was cut off because of an intersection then we need to
     // use the last cross section also
@@ -413,29 +478,22 @@ void XmGuideBankUtilImpl::GetEndCapEndPoints(cs3dPtIdx& a_ptIdx,
 /// \brief breaklines from the end cap
 /// \param[in,out] a_io StamperIo class
 /// \param[in] a_ptIdx The indexes of the points in the TIN created by stamping
-/// \param[out] a_blTypes The type of break line
 //------------------------------------------------------------------------------
-void XmGuideBankUtilImpl::GetEndCapBreakLines(XmStamperIo& a_io,
-                                              cs3dPtIdx& a_ptIdx,
-                                              VecInt& a_blTypes)
+void XmGuideBankUtilImpl::GetEndCapBreakLines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx)
 {
-  BreakLinesAddCenterLine(a_io, a_ptIdx, a_blTypes);
-  BreakLinesAddEndPoints(a_io, a_ptIdx, a_blTypes);
-  BreakLinesAddCrossSections(a_io, a_ptIdx, a_blTypes);
-  BreakLinesAddEndCap(a_io, a_ptIdx, a_blTypes);
-  BreakLinesAddShoulders(a_io, a_ptIdx, a_blTypes);
+  BreakLinesAddCenterLine(a_io, a_ptIdx);
+  BreakLinesAddEndPoints(a_io, a_ptIdx);
+  BreakLinesAddCrossSections(a_io, a_ptIdx);
+  BreakLinesAddEndCap(a_io, a_ptIdx);
+  BreakLinesAddShoulders(a_io, a_ptIdx);
 } // XmGuideBankUtilImpl::GetEndCapBreakLines
 //------------------------------------------------------------------------------
 /// \brief breaklines from the center line
 /// \param[in,out] a_io StamperIo class
 /// \param[in] a_ptIdx The indexes of the points in the TIN created by stamping
-/// \param[out] a_blTypes The type of break line
 //------------------------------------------------------------------------------
-void XmGuideBankUtilImpl::BreakLinesAddCenterLine(XmStamperIo& a_io,
-                                                  cs3dPtIdx& a_ptIdx,
-                                                  VecInt& a_blTypes)
+void XmGuideBankUtilImpl::BreakLinesAddCenterLine(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx)
 {
-  VecInt2d& b(a_io.m_outBreakLines);
   VecInt bl;
   bool firstIsGuideBank(a_io.m_firstEndCap.m_type == 0);
   bool lastIsGuideBank(a_io.m_lastEndCap.m_type == 0);
@@ -448,8 +506,7 @@ void XmGuideBankUtilImpl::BreakLinesAddCenterLine(XmStamperIo& a_io,
       auto beg = a_ptIdx.m_first_end_cap.m_centerLine.begin();
       auto end = a_ptIdx.m_first_end_cap.m_centerLine.end();
       bl.insert(bl.end(), beg, end);
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_CENTERLINE);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_CENTERLINE);
     }
   }
   if (lastIsGuideBank)
@@ -461,8 +518,7 @@ void XmGuideBankUtilImpl::BreakLinesAddCenterLine(XmStamperIo& a_io,
       auto beg = a_ptIdx.m_last_end_cap.m_centerLine.begin();
       auto end = a_ptIdx.m_last_end_cap.m_centerLine.end();
       bl.insert(bl.end(), beg, end);
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_CENTERLINE);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_CENTERLINE);
     }
   }
 } // XmGuideBankUtilImpl::BreakLinesAddCenterLine
@@ -470,21 +526,17 @@ void XmGuideBankUtilImpl::BreakLinesAddCenterLine(XmStamperIo& a_io,
 /// \brief breaklines the outer edge of the stamp
 /// \param[in,out] a_io StamperIo class
 /// \param[in] a_ptIdx The indexes of the points in the TIN created by stamping
-/// \param[out] a_blTypes The type of break line
 //------------------------------------------------------------------------------
-void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io,
-                                                 cs3dPtIdx& a_ptIdx,
-                                                 VecInt& a_blTypes)
+void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx)
 {
-  VecInt2d& b(a_io.m_outBreakLines);
   bool firstIsGuideBank(a_io.m_firstEndCap.m_type == 0);
   bool lastIsGuideBank(a_io.m_lastEndCap.m_type == 0);
   VecInt bl, firstEndCapEndPts, lastEndCapEndPts;
   GetEndCapEndPoints(a_ptIdx, firstEndCapEndPts, lastEndCapEndPts, a_io);
 
   {
-    VecInt& cl(a_ptIdx.m_first_end_cap.m_centerLine);
-    VecInt2d& vl(a_ptIdx.m_first_end_cap.m_left);
+    const stIdxRange& cl(a_ptIdx.m_first_end_cap.m_centerLine);
+    const stIdxRows& vl(a_ptIdx.m_first_end_cap.m_left);
     if (firstIsGuideBank && !cl.empty())
     { // breaklines for the end points
       bl.resize(0);
@@ -492,8 +544,7 @@ void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io,
       auto beg = firstEndCapEndPts.begin();
       auto end = beg + (a_ptIdx.m_first_end_cap.m_centerLine.size() - 1);
       bl.insert(bl.end(), beg, end);
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_END);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_END);
 
       if (vl.size() > cl.size())
       {
@@ -501,8 +552,7 @@ void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io,
         beg = end - 1;
         end = beg + 14;
         bl.insert(bl.end(), beg, end);
-        b.push_back(bl);
-        a_blTypes.push_back(XmBreaklines::BL_END);
+        XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_END);
       }
 
       bl.resize(0);
@@ -510,13 +560,12 @@ void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io,
       end = firstEndCapEndPts.end();
       bl.insert(bl.end(), beg, end);
       bl.push_back(a_ptIdx.m_xsPts.m_right.front().back());
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_END);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_END);
     }
   }
   {
-    VecInt& cl(a_ptIdx.m_last_end_cap.m_centerLine);
-    VecInt2d& vl(a_ptIdx.m_last_end_cap.m_left);
+    const stIdxRange& cl(a_ptIdx.m_last_end_cap.m_centerLine);
+    const stIdxRows& vl(a_ptIdx.m_last_end_cap.m_left);
     if (lastIsGuideBank && !cl.empty())
     { // breaklines for the end points
       bl.resize(0);
@@ -524,8 +573,7 @@ void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io,
       auto beg = lastEndCapEndPts.begin();
       auto end = beg + (a_ptIdx.m_last_end_cap.m_centerLine.size());
       bl.insert(bl.end(), beg, end);
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_END);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_END);
 
       if (vl.size() > cl.size())
       {
@@ -533,8 +581,7 @@ void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io,
         beg = end - 1;
         end = beg + 13;
         bl.insert(bl.end(), beg, end);
-        b.push_back(bl);
-        a_blTypes.push_back(XmBreaklines::BL_END);
+        XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_END);
       }
 
       bl.resize(0);
@@ -542,8 +589,7 @@ void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io,
       beg = end - (a_ptIdx.m_last_end_cap.m_centerLine.size());
       bl.insert(bl.end(), beg, end);
       bl.push_back(a_ptIdx.m_xsPts.m_right.back().back());
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_END);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_END);
     }
   }
 } // XmGuideBankUtilImpl::BreakLinesAddEndPoints
@@ -551,19 +597,15 @@ void XmGuideBankUtilImpl::BreakLinesAddEndPoints(XmStamperIo& a_io,
 /// \brief breaklines for cross sections
 /// \param[in,out] a_io StamperIo class
 /// \param[in] a_ptIdx The indexes of the points in the TIN created by stamping
-/// \param[out] a_blTypes The type of break line
 //------------------------------------------------------------------------------
-void XmGuideBankUtilImpl::BreakLinesAddCrossSections(XmStamperIo& a_io,
-                                                     cs3dPtIdx& a_ptIdx,
-                                                     VecInt& a_blTypes)
+void XmGuideBankUtilImpl::BreakLinesAddCrossSections(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx)
 {
-  VecInt2d& b(a_io.m_outBreakLines);
   bool firstIsGuideBank(a_io.m_firstEndCap.m_type == 0);
   bool lastIsGuideBank(a_io.m_lastEndCap.m_type == 0);
   VecInt bl;
   if (firstIsGuideBank)
   { // breaklines for cross sections
-    VecInt& v(a_ptIdx.m_first_end_cap.m_centerLine);
+    const stIdxRange& v(a_ptIdx.m_first_end_cap.m_centerLine);
     for (size_t i = 0; i < v.size(); ++i)
     {
       bl.resize(0);
@@ -581,13 +623,12 @@ void XmGuideBankUtilImpl::BreakLinesAddCrossSections(XmStamperIo& a_io,
         auto end = a_ptIdx.m_first_end_cap.m_right[i].end();
         bl.insert(bl.end(), beg, end);
       }
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_XSECT);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_XSECT);
     }
   }
   if (lastIsGuideBank)
   { // breaklines for cross sections
-    VecInt& v(a_ptIdx.m_last_end_cap.m_centerLine);
+    const stIdxRange& v(a_ptIdx.m_last_end_cap.m_centerLine);
     for (size_t i = 0; i < v.size(); ++i)
     {
       bl.resize(0);
@@ -605,8 +646,7 @@ void XmGuideBankUtilImpl::BreakLinesAddCrossSections(XmStamperIo& a_io,
         auto end = a_ptIdx.m_last_end_cap.m_right[i].end();
         bl.insert(bl.end(), beg, end);
       }
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_XSECT);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_XSECT);
     }
   }
 } // XmGuideBankUtilImpl::BreakLinesAddCrossSections
@@ -614,20 +654,16 @@ void XmGuideBankUtilImpl::BreakLinesAddCrossSections(XmStamperIo& a_io,
 /// \brief breaklines for end cap
 /// \param[in,out] a_io StamperIo class
 /// \param[in] a_ptIdx The indexes of the points in the TIN created by stamping
-/// \param[out] a_blTypes The type of break line
 //------------------------------------------------------------------------------
-void XmGuideBankUtilImpl::BreakLinesAddEndCap(XmStamperIo& a_io,
-                                              cs3dPtIdx& a_ptIdx,
-                                              VecInt& a_blTypes)
+void XmGuideBankUtilImpl::BreakLinesAddEndCap(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx)
 {
-  VecInt2d& b(a_io.m_outBreakLines);
   bool firstIsGuideBank(a_io.m_firstEndCap.m_type == 0);
   bool lastIsGuideBank(a_io.m_lastEndCap.m_type == 0);
   VecInt bl;
   if (firstIsGuideBank)
   {
-    VecInt& v(a_ptIdx.m_first_end_cap.m_centerLine);
-    VecInt2d& v1(a_ptIdx.m_first_end_cap.m_left);
+    const stIdxRange& v(a_ptIdx.m_first_end_cap.m_centerLine);
+    const stIdxRows& v1(a_ptIdx.m_first_end_cap.m_left);
     if (v1.size() > v.size())
     {
       // breaklines for the end cap
@@ -638,15 +674,14 @@ void XmGuideBankUtilImpl::BreakLinesAddEndCap(XmStamperIo& a_io,
         auto beg = v1[i].begin();
         auto end = v1[i].end();
         bl.insert(bl.end(), beg, end);
-        b.push_back(bl);
-        a_blTypes.push_back(XmBreaklines::BL_XSECT);
+        XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_XSECT);
       }
     }
   }
   if (lastIsGuideBank)
   {
-    VecInt& v(a_ptIdx.m_last_end_cap.m_centerLine);
-    VecInt2d& v1(a_ptIdx.m_last_end_cap.m_left);
+    const stIdxRange& v(a_ptIdx.m_last_end_cap.m_centerLine);
+    const stIdxRows& v1(a_ptIdx.m_last_end_cap.m_left);
     if (v1.size() > v.size())
     {
       // breaklines for the end cap
@@ -657,8 +692,7 @@ void XmGuideBankUtilImpl::BreakLinesAddEndCap(XmStamperIo& a_io,
         auto beg = v1[i].begin();
         auto end = v1[i].end();
         bl.insert(bl.end(), beg, end);
-        b.push_back(bl);
-        a_blTypes.push_back(XmBreaklines::BL_XSECT);
+        XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_XSECT);
       }
     }
   }
@@ -667,21 +701,17 @@ void XmGuideBankUtilImpl::BreakLinesAddEndCap(XmStamperIo& a_io,
 /// \brief breaklines for end cap
 /// \param[in,out] a_io StamperIo class
 /// \param[in] a_ptIdx The indexes of the points in the TIN created by stamping
-/// \param[out] a_blTypes The type of break line
 //------------------------------------------------------------------------------
-void XmGuideBankUtilImpl::BreakLinesAddShoulders(XmStamperIo& a_io,
-                                                 cs3dPtIdx& a_ptIdx,
-                                                 VecInt& a_blTypes)
+void XmGuideBankUtilImpl::BreakLinesAddShoulders(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx)
 {
-  VecInt2d& b(a_io.m_outBreakLines);
   bool firstIsGuideBank(a_io.m_firstEndCap.m_type == 0);
   bool lastIsGuideBank(a_io.m_lastEndCap.m_type == 0);
   VecInt bl;
   if (firstIsGuideBank && !a_ptIdx.m_first_end_cap.m_centerLine.empty())
   {
-    VecInt& v(a_ptIdx.m_first_end_cap.m_centerLine);
-    VecInt2d& v1(a_ptIdx.m_first_end_cap.m_left);
-    VecInt2d& vR(a_ptIdx.m_first_end_cap.m_right);
+    const stIdxRange& v(a_ptIdx.m_first_end_cap.m_centerLine);
+    const stIdxRows& v1(a_ptIdx.m_first_end_cap.m_left);
+    const stIdxRows& vR(a_ptIdx.m_first_end_cap.m_right);
 
     // Left and right are backwards for the first guide bank
     // breaklines for the shoulders
@@ -694,8 +724,7 @@ void XmGuideBankUtilImpl::BreakLinesAddShoulders(XmStamperIo& a_io,
     {
       bl.push_back(v1[i][lShoulder]);
     }
-    b.push_back(bl);
-    a_blTypes.push_back(XmBreaklines::BL_SHOULDER);
+    XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_SHOULDER);
     // end cap shoulder
     if (v1.size() > v.size())
     {
@@ -705,8 +734,7 @@ void XmGuideBankUtilImpl::BreakLinesAddShoulders(XmStamperIo& a_io,
         bl.push_back(v1[i][lShoulder]);
       }
       bl.push_back(vR.back()[rShoulder]);
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_SHOULDER);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_SHOULDER);
     }
     // right shoulder
     bl.resize(0);
@@ -715,14 +743,13 @@ void XmGuideBankUtilImpl::BreakLinesAddShoulders(XmStamperIo& a_io,
     {
       bl.push_back(vR[i][rShoulder]);
     }
-    b.push_back(bl);
-    a_blTypes.push_back(XmBreaklines::BL_SHOULDER);
+    XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_SHOULDER);
   }
   if (lastIsGuideBank && !a_ptIdx.m_last_end_cap.m_centerLine.empty())
   {
-    VecInt& v(a_ptIdx.m_last_end_cap.m_centerLine);
-    VecInt2d& v1(a_ptIdx.m_last_end_cap.m_left);
-    VecInt2d& vR(a_ptIdx.m_last_end_cap.m_right);
+    const stIdxRange& v(a_ptIdx.m_last_end_cap.m_centerLine);
+    const stIdxRows& v1(a_ptIdx.m_last_end_cap.m_left);
+    const stIdxRows& vR(a_ptIdx.m_last_end_cap.m_right);
 
     // breaklines for the shoulders
     int lShoulder(a_io.m_cs.back().m_idxLeftShoulder - 1),
@@ -734,8 +761,7 @@ void XmGuideBankUtilImpl::BreakLinesAddShoulders(XmStamperIo& a_io,
     {
       bl.push_back(v1[i][lShoulder]);
     }
-    b.push_back(bl);
-    a_blTypes.push_back(XmBreaklines::BL_SHOULDER);
+    XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_SHOULDER);
     // end cap shoulder
     if (v1.size() > v.size())
     {
@@ -745,8 +771,7 @@ void XmGuideBankUtilImpl::BreakLinesAddShoulders(XmStamperIo& a_io,
         bl.push_back(v1[i][lShoulder]);
       }
       bl.push_back(vR.back()[rShoulder]);
-      b.push_back(bl);
-      a_blTypes.push_back(XmBreaklines::BL_SHOULDER);
+      XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_SHOULDER);
     }
     // right shoulder
     bl.resize(0);
@@ -755,8 +780,7 @@ void XmGuideBankUtilImpl::BreakLinesAddShoulders(XmStamperIo& a_io,
     {
       bl.push_back(vR[i][rShoulder]);
     }
-    b.push_back(bl);
-    a_blTypes.push_back(XmBreaklines::BL_SHOULDER);
+    XmBreaklines::AddBreakline(a_io, bl, XmBreaklines::BL_SHOULDER);
   }
 } // XmGuideBankUtilImpl::BreakLinesAddShoulders
 
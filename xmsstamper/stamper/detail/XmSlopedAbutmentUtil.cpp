@@ -13,6 +13,7 @@
 #include <xmsstamper/stamper/detail/XmSlopedAbutmentUtil.h>
 
 // 3. Standard library headers
+#include <algorithm>
 
 // 4. External library headers
 
@@ -22,6 +23,7 @@
 #include <xmscore/misc/xmstype.h>
 #include <xmsstamper/stamper/XmStamperIo.h>
 #include <xmsstamper/stamper/detail/XmBreaklines.h>
+#include <xmsstamper/stamper/detail/XmEndCapTemplates.h>
 #include <xmsstamper/stamper/detail/XmStamper3dPts.h>
 #include <xmsstamper/stamper/detail/XmStampInterpCrossSection.h>
 #include <xmsstamper/stamper/detail/XmUtil.h>
@@ -53,9 +55,7 @@ public:
                                   VecInt& a_firstEndCapEndPts,
                                   VecInt& a_lastEndCapEndPts,
                                   XmStamperIo& a_io) override;
-  virtual void GetEndCapBreakLines(XmStamperIo& a_io,
-                                   cs3dPtIdx& a_ptIdx,
-                                   VecInt& a_blTypes) override;
+  virtual void GetEndCapBreakLines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx) override;
 
   /// \cond
   enum { SA_LEFT = 0, SA_RIGHT };
@@ -92,14 +92,16 @@ public:
   /// cross section at the end cap
   double m_angleLeftTransition = 0.0;
   /// incremental angle to transition between sloped abutment and the left side
-  /// of the cross section at the end cap. The target increment in 15 degrees.
+  /// of the cross section at the end cap. The target increment in 15 degrees
+  /// unless the end cap has a max chord deviation.
   double m_angleLeftIncrement = 0.0;
   int m_nDivLeft = 0; ///< number of divisions for left side transition
   /// transition angle between the sloped abutment and the right side of the
   /// cross section at the end cap
   double m_angleRightTransition = 0.0;
   /// incremental angle to transition between sloped abutment and the left side
-  /// of the cross section at the end cap. The target increment in 15 degrees.
+  /// of the cross section at the end cap. The target increment in 15 degrees
+  /// unless the end cap has a max chord deviation.
   double m_angleRightIncrement = 0.0;
   int m_nDivRight = 0; ///< number of divisions for right side transition
   /// interpolated cross sections for the left side transition
@@ -174,9 +176,10 @@ void XmSlopedAbutmentUtilImpl::DoConvertTo3d(bool a_first,
 //------------------------------------------------------------------------------
 bool XmSlopedAbutmentUtilImpl::Setup()
 {
+  XmStampCrossSection buf;
   if (m_first)
   {
-    m_cs = m_io->m_cs[0];
+    m_cs = m_io->CrossSection(0, buf);
     m_pt1 = m_io->m_centerLine[0];
     m_pt2 = m_io->m_centerLine[1];
 
@@ -200,7 +203,7 @@ bool XmSlopedAbutmentUtilImpl::Setup()
   }
   else
   {
-    m_cs = m_io->m_cs.back();
+    m_cs = m_io->CrossSection(m_io->m_cs.size() - 1, buf);
     m_pt2 = m_io->m_centerLine.back();
     size_t ix = m_io->m_centerLine.size() - 2;
     m_pt1 = m_io->m_centerLine[ix];
@@ -310,9 +313,21 @@ void XmSlopedAbutmentUtilImpl::ComputeTransitionAngles()
     m_angleLeftTransition = 90.0 - m_cap.m_angle;
     m_angleRightTransition = 90.0 + m_cap.m_angle;
   }
-  m_nDivLeft = static_cast<int>(m_angleLeftTransition / 15.0);
+  if (m_cap.m_maxChordDeviation > 0.0)
+  {
+    // the outer edge of the transition is the farthest from the shoulder
+    double leftRadius = std::max(m_sa.m_maxX, m_csLeft.m_leftMax);
+    double rightRadius = std::max(m_sa.m_maxX, m_csRight.m_rightMax);
+    m_nDivLeft = XmUtil::ArcDivisions(m_angleLeftTransition, leftRadius, m_cap.m_maxChordDeviation);
+    m_nDivRight =
+      XmUtil::ArcDivisions(m_angleRightTransition, rightRadius, m_cap.m_maxChordDeviation);
+  }
+  else
+  {
+    m_nDivLeft = static_cast<int>(m_angleLeftTransition / 15.0);
+    m_nDivRight = static_cast<int>(m_angleRightTransition / 15.0);
+  }
   m_angleLeftIncrement = m_angleLeftTransition / m_nDivLeft;
-  m_nDivRight = static_cast<int>(m_angleRightTransition / 15.0);
   m_angleRightIncrement = m_angleRightTransition / m_nDivRight;
 } // XmSlopedAbutmentUtilImpl::ComputeTransitionAngles
 //------------------------------------------------------------------------------
@@ -323,8 +338,6 @@ void XmSlopedAbutmentUtilImpl::ComputeTransitionAngles()
 //------------------------------------------------------------------------------
 void XmSlopedAbutmentUtilImpl::InterpolateCrossSections(int a_side)
 {
-  BSHP<XmStampInterpCrossSection> interp = XmStampInterpCrossSection::New();
-
   double angleFactor(-1.0);
 
   // left side
@@ -344,25 +357,45 @@ void XmSlopedAbutmentUtilImpl::InterpolateCrossSections(int a_side)
     angleIncrement = m_angleRightIncrement;
     vAngles = &m_interpAnglesRight;
   }
-  XmStampCrossSection saXsect = m_saXsect;
-  double saMaxLen = saXsect.m_leftMax;
-  EnsureCrossSectionAtMaxX(saXsect);
-  XmUtil::ScaleCrossSectionXvals(saXsect, 1 / saMaxLen);
-  EnsureCrossSectionAtMaxX(next);
-  XmUtil::ScaleCrossSectionXvals(next, 1 / maxLen);
-
-  if (!m_first)
-    angleFactor *= -1.0;
-  XmStampCrossSection cs;
   vCs->push_back(m_saXsect);
   vAngles->push_back(m_angleCenterLine);
-  for (int i = 1; i < nDiv; ++i)
+  if (!m_first)
+    angleFactor *= -1.0;
+
+  // the transition cross sections only depend on the sloped abutment, the
+  // cross section and the number of divisions
+  std::string key("sloped abutment");
+  XmEndCapTemplates::AppendToKey(key, a_side);
+  XmEndCapTemplates::AppendToKey(key, nDiv);
+  XmEndCapTemplates::AppendToKey(key, m_saXsect);
+  XmEndCapTemplates::AppendToKey(key, next);
+  std::vector<XmStampCrossSection> interpCs;
+  if (!XmEndCapTemplates::Find(key, interpCs))
+  {
+    XmStampCrossSection saXsect = m_saXsect;
+    double saMaxLen = saXsect.m_leftMax;
+    EnsureCrossSectionAtMaxX(saXsect);
+    XmUtil::ScaleCrossSectionXvals(saXsect, 1 / saMaxLen);
+    EnsureCrossSectionAtMaxX(next);
+    XmUtil::ScaleCrossSectionXvals(next, 1 / maxLen);
+
+    VecDbl percents;
+    for (int i = 1; i < nDiv; ++i)
+      percents.push_back((static_cast<double>(i)) / nDiv);
+    BSHP<XmStampInterpCrossSection> interp = XmStampInterpCrossSection::New();
+    interp->InterpCs(saXsect, next, percents, interpCs);
+    interpCs.resize(percents.size());
+    for (int i = 1; i < nDiv; ++i)
+    {
+      double percent = percents[i - 1];
+      double len = saMaxLen + percent * (maxLen - saMaxLen);
+      XmUtil::ScaleCrossSectionXvals(interpCs[i - 1], len);
+    }
+    XmEndCapTemplates::Add(key, interpCs);
+  }
+  for (int i = 1; i < nDiv && i - 1 < (int)interpCs.size(); ++i)
   {
-    double percent = (static_cast<double>(i)) / nDiv;
-    interp->InterpCs(saXsect, next, percent, cs);
-    double len = saMaxLen + percent * (maxLen - saMaxLen);
-    XmUtil::ScaleCrossSectionXvals(cs, len);
-    vCs->push_back(cs);
+    vCs->push_back(interpCs[i - 1]);
     double angle = m_angleCenterLine + (i * angleIncrement * angleFactor);
     vAngles->push_back(angle);
   }
@@ -433,46 +466,38 @@ void XmSlopedAbutmentUtilImpl::GetEndCapEndPoints(cs3dPtIdx& a_ptIdx,
   if (a_io.m_lastEndCap.m_type == 1)
   { // last end cap
     {
-      VecInt2d& vLeft(a_ptIdx.m_last_end_cap.m_left);
-      auto it = vLeft.rbegin();
-      auto end = vLeft.rend();
-      for (; it != end; ++it)
+      const stIdxRows& vLeft(a_ptIdx.m_last_end_cap.m_left);
+      for (size_t i = vLeft.size(); i > 0; --i)
       {
-        if (!it->empty())
-          a_lastEndCapEndPts.push_back(it->back());
+        if (!vLeft[i - 1].empty())
+          a_lastEndCapEndPts.push_back(vLeft[i - 1].back());
       }
     }
     {
-      VecInt2d& vRight(a_ptIdx.m_last_end_cap.m_right);
-      auto it = vRight.begin();
-      auto end = vRight.end();
-      for (; it != end; ++it)
+      const stIdxRows& vRight(a_ptIdx.m_last_end_cap.m_right);
+      for (size_t i = 0; i < vRight.size(); ++i)
       {
-        if (!it->empty())
-          a_lastEndCapEndPts.push_back(it->back());
+        if (!vRight[i].empty())
+          a_lastEndCapEndPts.push_back(vRight[i].back());
       }
     }
   }
   if (a_io.m_firstEndCap.m_type == 1)
   { // first end cap
     {
-      VecInt2d& vRight(a_ptIdx.m_first_end_cap.m_right);
-      auto it = vRight.rbegin();
-      auto end = vRight.rend();
-      for (; it != end; ++it)
+      const stIdxRows& vRight(a_ptIdx.m_first_end_cap.m_right);
+      for (size_t i = vRight.size(); i > 0; --i)
       {
-        if (!it->empty())
-          a_firstEndCapEndPts.push_back(it->back());
+        if (!vRight[i - 1].empty())
+          a_firstEndCapEndPts.push_back(vRight[i - 1].back());
       }
     }
     {
-      VecInt2d& vLeft(a_ptIdx.m_first_end_cap.m_left);
-      auto it = vLeft.begin();
-      auto end = vLeft.end();
-      for (; it != end; ++it)
+      const stIdxRows& vLeft(a_ptIdx.m_first_end_cap.m_left);
+      for (size_t i = 0; i < vLeft.size(); ++i)
       {
-        if (!it->empty())
-          a_firstEndCapEndPts.push_back(it->back());
+        if (!vLeft[i].empty())
+          a_firstEndCapEndPts.push_back(vLeft[i].back());
       }
     }
   }
@@ -481,13 +506,9 @@ void XmSlopedAbutmentUtilImpl::GetEndCapEndPoints(cs3dPtIdx& a_ptIdx,
 /// \brief breaklines from the end cap
 /// \param[in,out] a_io StamperIo class
 /// \param[in] a_ptIdx The indexes of the points in the TIN created by stamping
-/// \param[out] a_blTypes The type of break line (center, xsect, shoulder)
 //------------------------------------------------------------------------------
-void XmSlopedAbutmentUtilImpl::GetEndCapBreakLines(XmStamperIo& a_io,
-                                                   cs3dPtIdx& a_ptIdx,
-                                                   VecInt& a_blTypes)
+void XmSlopedAbutmentUtilImpl::GetEndCapBreakLines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx)
 {
-  VecInt2d& b(a_io.m_outBreakLines);
   bool firstIsSlopedAbutment(a_io.m_firstEndCap.m_type == 1);
   bool lastIsSlopedAbutment(a_io.m_lastEndCap.m_type == 1);
   // get endcap end points
@@ -500,8 +521,7 @@ void XmSlopedAbutmentUtilImpl::GetEndCapBreakLines(XmStamperIo& a_io,
     firstEndCapEndPts.insert(firstEndCapEndPts.begin(), ix);
     ix = a_ptIdx.m_xsPts.m_left.front().back();
     firstEndCapEndPts.push_back(ix);
-    b.push_back(firstEndCapEndPts);
-    a_blTypes.push_back(XmBreaklines::BL_END);
+    XmBreaklines::AddBreakline(a_io, firstEndCapEndPts, XmBreaklines::BL_END);
   }
   if (lastIsSlopedAbutment)
   {
@@ -509,19 +529,18 @@ void XmSlopedAbutmentUtilImpl::GetEndCapBreakLines(XmStamperIo& a_io,
     lastEndCapEndPts.insert(lastEndCapEndPts.begin(), ix);
     ix = a_ptIdx.m_xsPts.m_right.back().back();
     lastEndCapEndPts.push_back(ix);
-    b.push_back(lastEndCapEndPts);
-    a_blTypes.push_back(XmBreaklines::BL_END);
+    XmBreaklines::AddBreakline(a_io, lastEndCapEndPts, XmBreaklines::BL_END);
   }
 
   // get other endcap breaklines
-  auto myLambda = [](VecInt2d& v2d, int ix, VecInt2d& outbl, VecInt& type) {
+  auto myLambda = [](const stIdxRows& v2d, int ix, XmStamperIo& io) {
+    VecInt& outbl(io.m_outBreakLinePts);
     for (size_t i = 0; i < v2d.size(); ++i)
     {
-      VecInt& v(v2d[i]);
-      VecInt bl(1, ix);
-      bl.insert(bl.begin(), v.rbegin(), v.rend());
-      outbl.push_back(bl);
-      type.push_back(XmBreaklines::BL_XSECT);
+      stIdxRange v(v2d[i]);
+      outbl.insert(outbl.end(), v.rbegin(), v.rend());
+      outbl.push_back(ix);
+      XmBreaklines::EndBreakline(io, XmBreaklines::BL_XSECT);
     }
   };
 
@@ -531,11 +550,11 @@ void XmSlopedAbutmentUtilImpl::GetEndCapBreakLines(XmStamperIo& a_io,
     // get left shoulder index for first xsect
     leftShoulder = a_io.m_cs.front().m_idxLeftShoulder;
     ix = a_ptIdx.m_xsPts.m_left.front()[leftShoulder - 1];
-    myLambda(a_ptIdx.m_first_end_cap.m_left, ix, b, a_blTypes);
+    myLambda(a_ptIdx.m_first_end_cap.m_left, ix, a_io);
     // get right shoulder index for first xsect
     rightShoulder = a_io.m_cs.front().m_idxRightShoulder;
     ix = a_ptIdx.m_xsPts.m_right.front()[rightShoulder - 1];
-    myLambda(a_ptIdx.m_first_end_cap.m_right, ix, b, a_blTypes);
+    myLambda(a_ptIdx.m_first_end_cap.m_right, ix, a_io);
   }
 
   if (lastIsSlopedAbutment)
@@ -543,11 +562,11 @@ void XmSlopedAbutmentUtilImpl::GetEndCapBreakLines(XmStamperIo& a_io,
     // left shoulder index for last cross section
     leftShoulder = a_io.m_cs.back().m_idxLeftShoulder;
     ix = a_ptIdx.m_xsPts.m_left.back()[leftShoulder - 1];
-    myLambda(a_ptIdx.m_last_end_cap.m_left, ix, b, a_blTypes);
+    myLambda(a_ptIdx.m_last_end_cap.m_left, ix, a_io);
     // right shoulder index for last cross section
     rightShoulder = a_io.m_cs.back().m_idxLeftShoulder;
     ix = a_ptIdx.m_xsPts.m_right.back()[rightShoulder - 1];
-    myLambda(a_ptIdx.m_last_end_cap.m_right, ix, b, a_blTypes);
+    myLambda(a_ptIdx.m_last_end_cap.m_right, ix, a_io);
   }
 } // XmSlopedAbutmentUtilImpl::GetEndCapBreakLines
 
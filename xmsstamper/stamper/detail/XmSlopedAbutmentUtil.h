@@ -45,7 +45,7 @@ public:
                                   VecInt& a_firstEndCapEndPts,
                                   VecInt& a_lastEndCapEndPts,
                                   XmStamperIo& a_io) = 0;
-  virtual void GetEndCapBreakLines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx, VecInt& a_blTypes) = 0;
+  virtual void GetEndCapBreakLines(XmStamperIo& a_io, cs3dPtIdx& a_ptIdx) = 0;
 
 private:
   XM_DISALLOW_COPY_AND_ASSIGN(XmSlopedAbutmentUtil);
@@ -180,6 +180,7 @@ void XmStampEndCapImpl::RotateCrossSection(double a_angle, Pt3d& a_clPt, VecPt3d
   Pt3d p0(a_clPt);
 
   double oldMag(0), oldAngle(0);
+  double cosAngle = cos(a_angle * (XM_PI / 180.0));
   for (size_t i = 0; i < a_cs.size(); ++i)
   {
     Pt3d p1(a_cs[i]), p2(p1);
@@ -191,7 +192,7 @@ void XmStampEndCapImpl::RotateCrossSection(double a_angle, Pt3d& a_clPt, VecPt3d
     // new angle
     double newAngle = oldAngle + a_angle;
     // new magnitude
-    double newMag = oldMag / cos(a_angle * (XM_PI / 180.0));
+    double newMag = oldMag / cosAngle;
 
     // calculate new x,y points
     gmComponentMagnitudes(&p2.x, &p2.y, &newMag, &newAngle, false);
@@ -13,6 +13,7 @@
 #include <xmsstamper/stamper/detail/XmStampInterpCrossSection.h>
 
 // 3. Standard library headers
+#include <algorithm>
 #include <map>
 
 // 4. External library headers
@@ -24,6 +25,7 @@
 #include <xmsgrid/geometry/geoms.h>
 #include <xmscore/misc/Observer.h>
 #include <xmsstamper/stamper/XmStamperIo.h>
+#include <xmsstamper/stamper/detail/XmUtil.h>
 
 // 6. Non-shared code headers
 
@@ -37,6 +39,9 @@ namespace xms
 {
 //----- Constants / Enumerations -----------------------------------------------
 
+/// Minimum number of missing cross sections interpolated by each thread.
+const size_t MIN_XSECTS_PER_THREAD = 32;
+
 //----- Classes / Structs ------------------------------------------------------
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -48,29 +53,86 @@ public:
   ~XmStampInterpCrossSectionImpl();
 
   virtual void InterpMissingCrossSections(XmStamperIo& a_) override;
+  virtual void CrossSectionsFromStations(XmStamperIo& a_) override;
   virtual bool ValidCrossSectionsExist(XmStamperIo& a_) override;
-  virtual void InterpCs(XmStampCrossSection& a_prev,
-                        XmStampCrossSection& a_next,
+  virtual void InterpCs(const XmStampCrossSection& a_prev,
+                        const XmStampCrossSection& a_next,
                         double a_percent,
                         XmStampCrossSection& a_cs) override;
+  virtual void InterpCs(const XmStampCrossSection& a_prev,
+                        const XmStampCrossSection& a_next,
+                        const VecDbl& a_percents,
+                        std::vector<XmStampCrossSection>& a_cs) override;
+
+  /// \brief Buffers reused while matching up the points of 2 cross sections
+  struct stPairScratch
+  {
+    VecDbl m_t1;                ///< t values of the first cross section part
+    VecDbl m_t2;                ///< t values of the second cross section part
+    Pt3d m_p1;                  ///< center line point of the first cross section
+    Pt3d m_p2;                  ///< center line point of the second cross section
+    VecPt3d m_left1;            ///< left points matched on the first cross section
+    VecPt3d m_left2;            ///< left points matched on the second cross section
+    VecPt3d m_right1;           ///< right points matched on the first cross section
+    VecPt3d m_right2;           ///< right points matched on the second cross section
+    size_t m_leftShoulder;      ///< index of the left shoulder in the matched points
+    size_t m_rightShoulder;     ///< index of the right shoulder in the matched points
+    XmStampCrossSection m_prev; ///< first cross section when read from a template
+    XmStampCrossSection m_next; ///< second cross section when read from a template
+  };
 
   BSHP<Observer> m_observer; ///< progress observer
   XmStamperIo* m_io;         ///< pointer to the inputs to the stamp operation
+  stPairScratch m_scratch;   ///< buffers for the single threaded methods
 
   int FindFirstValidCrossSection();
   int FindLastValidCrossSection();
   int FindNextValidCrossSection(int a_idx);
-  void InterpCs(int a_prev, int a_next, double a_percent, XmStampCrossSection& a_cs);
-  void InterpPts(VecPt3d& a_v1,
+  void InterpCs(int a_prev,
+                int a_next,
+                double a_percent,
+                XmStampCrossSection& a_cs,
+                stPairScratch& a_scratch);
+  bool PairCs(const XmStampCrossSection& a_prev,
+              const XmStampCrossSection& a_next,
+              stPairScratch& a_scratch);
+  void BlendCs(const XmStampCrossSection& a_prev,
+               const XmStampCrossSection& a_next,
+               const stPairScratch& a_scratch,
+               double a_percent,
+               XmStampCrossSection& a_cs);
+  void InterpPts(const VecPt3d& a_v1,
                  int a_beg1,
                  int a_end1,
-                 VecPt3d& a_v2,
+                 const VecPt3d& a_v2,
                  int a_beg2,
                  int a_end2,
                  double a_percent,
                  VecPt3d& a_interpPts);
-  void CalcTvals(VecPt3d& a_v, int a_beg, int a_end, VecDbl& a_t);
-  Pt3d PtFromT(VecPt3d& a_v, int a_beg, VecDbl& a_t, double a_tval);
+  void PairPts(const VecPt3d& a_v1,
+               int a_beg1,
+               int a_end1,
+               const VecPt3d& a_v2,
+               int a_beg2,
+               int a_end2,
+               stPairScratch& a_scratch,
+               VecPt3d& a_pts1,
+               VecPt3d& a_pts2);
+  bool PairPtsMerge(const VecPt3d& a_v1,
+                    int a_beg1,
+                    const VecDbl& a_t1,
+                    const VecPt3d& a_v2,
+                    int a_beg2,
+                    const VecDbl& a_t2,
+                    VecPt3d& a_pts1,
+                    VecPt3d& a_pts2);
+  void CalcTvals(const VecPt3d& a_v, int a_beg, int a_end, VecDbl& a_t);
+  Pt3d PtFromT(const VecPt3d& a_v, int a_beg, const VecDbl& a_t, double a_tval);
+  Pt3d PtFromTWalk(const VecPt3d& a_v,
+                   int a_beg,
+                   const VecDbl& a_t,
+                   double a_tval,
+                   size_t& a_k);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -84,6 +146,7 @@ public:
 XmStampInterpCrossSectionImpl::XmStampInterpCrossSectionImpl()
 : m_observer()
 , m_io(nullptr)
+, m_scratch()
 {
 } // XmStampInterpCrossSectionImpl::XmStampInterpCrossSectionImpl
 //------------------------------------------------------------------------------
@@ -101,11 +164,13 @@ void XmStampInterpCrossSectionImpl::InterpMissingCrossSections(XmStamperIo& a_)
 {
   m_io = &a_;
 
-  // make sure shoulder index is not 0 on any cross section
+  // make sure shoulder index is not 0 on any cross section. Templates are
+  // not changed. PrepareCrossSectionLibrary copies those with a 0 index.
+  // Cross sections from stations read their shoulder indexes from m_cs.
   for (size_t i = 0; i < m_io->m_cs.size(); ++i)
   {
     auto& cs(m_io->m_cs[i]);
-    if (cs.m_left.size() > 1 || cs.m_right.size() > 1)
+    if (m_io->HasCrossSection(i))
     {
       if (cs.m_idxLeftShoulder < 1)
         cs.m_idxLeftShoulder = 1;
@@ -114,43 +179,176 @@ void XmStampInterpCrossSectionImpl::InterpMissingCrossSections(XmStamperIo& a_)
     }
   }
 
+  // cross sections from templates are copied by template index and those
+  // from stations by station length
+  VecInt& templates(m_io->m_csTemplates);
+  if (!templates.empty())
+    templates.resize(m_io->m_cs.size(), -1);
+  VecDbl& lengths(m_io->m_csStationLengths);
+  if (!lengths.empty())
+    lengths.resize(m_io->m_cs.size(), -1.0);
   int first = FindFirstValidCrossSection();
   // copy this cross section to any before it
   for (int i = 0; i < first; ++i)
   {
     m_io->m_cs[i] = m_io->m_cs[first];
+    if (!templates.empty())
+      templates[i] = templates[first];
+    if (!lengths.empty())
+      lengths[i] = lengths[first];
   }
   int last = FindLastValidCrossSection();
   // copy this cross section to any after it
   for (size_t i = (size_t)(last + 1); last >= 0 && i < m_io->m_cs.size(); ++i)
   {
     m_io->m_cs[i] = m_io->m_cs[last];
+    if (!templates.empty())
+      templates[i] = templates[last];
+    if (!lengths.empty())
+      lengths[i] = lengths[last];
   }
-  // loop between first and last to fill in the cross sections
-  const VecPt3d& pts(m_io->m_centerLine);
-  int prev = first, next;
-  double prevDist, nextDist, percent;
+  if (first < 0 || last - first < 2)
+    return;
+
+  // one pass to find the previous and next valid cross section of each
+  // missing cross section between first and last
+  VecInt missing, prevIdx, nextIdx;
+  int prev = first;
   for (int i = first + 1; i < last; ++i)
   {
-    auto& cs(m_io->m_cs[i]);
-    if (cs.m_left.size() > 1 || cs.m_right.size() > 1)
+    if (m_io->HasCrossSection(i))
     {
       prev = i;
       continue;
     }
-
-    // get the next valid cross section
-    next = FindNextValidCrossSection(i);
-    // get distance between current and previous
-    prevDist = gmXyDistance(pts[prev], pts[i]);
-    // get distance between current and next
-    nextDist = gmXyDistance(pts[i], pts[next]);
-    percent = prevDist / (prevDist + nextDist);
-    // interpolate the cross section
-    InterpCs(prev, next, percent, cs);
+    missing.push_back(i);
+    prevIdx.push_back(prev);
   }
+  nextIdx.assign(missing.size(), last);
+  int next = last;
+  for (size_t j = missing.size(), i = (size_t)last; j > 0; --j)
+  {
+    for (; i > (size_t)missing[j - 1]; --i)
+    {
+      if (m_io->HasCrossSection(i))
+        next = (int)i;
+    }
+    nextIdx[j - 1] = next;
+  }
+
+  // interpolate the cross sections. Each one only reads valid cross sections
+  // so they can be done in parallel.
+  const VecPt3d& pts(m_io->m_centerLine);
+  int nThreads = XmUtil::NumThreads(missing.size(), MIN_XSECTS_PER_THREAD);
+  std::vector<stPairScratch> scratch(nThreads);
+  XmUtil::ParallelFor(missing.size(), nThreads, [&](int a_thread, size_t a_begin, size_t a_end) {
+    for (size_t j = a_begin; j < a_end; ++j)
+    {
+      int i = missing[j];
+      // get distance between current and previous
+      double prevDist = gmXyDistance(pts[prevIdx[j]], pts[i]);
+      // get distance between current and next
+      double nextDist = gmXyDistance(pts[i], pts[nextIdx[j]]);
+      double percent = prevDist / (prevDist + nextDist);
+      // interpolate the cross section
+      InterpCs(prevIdx[j], nextIdx[j], percent, m_io->m_cs[i], scratch[a_thread]);
+    }
+  });
 } // XmStampInterpCrossSectionImpl::InterpMissingCrossSections
 //------------------------------------------------------------------------------
+/// \brief Sets up the cross sections given at stations along the center
+/// line. Each center line point gets a cross section interpolated between the
+/// stations before and after it. Points before the first or after the last
+/// station get that station's cross section. The points of the stations are
+/// matched up once for each pair of neighboring stations and the cross
+/// section of a center line point is only blended when it is read with
+/// XmStamperIo::CrossSection(). m_cs keeps the max values and shoulder
+/// indexes. Cross sections already in m_cs that have points are kept.
+/// \param [in,out] a_ The inputs and outputs for the feature stamp operation
+//------------------------------------------------------------------------------
+void XmStampInterpCrossSectionImpl::CrossSectionsFromStations(XmStamperIo& a_)
+{
+  m_io = &a_;
+  a_.m_csStationLengths.clear();
+  a_.m_csStationSpans.clear();
+  if (a_.m_csStations.empty())
+    return;
+  XM_ENSURE_TRUE(a_.m_csStations.size() == a_.m_stationCs.size());
+
+  // stations with valid cross sections ordered by distance
+  VecInt order;
+  for (size_t i = 0; i < a_.m_stationCs.size(); ++i)
+  {
+    const auto& cs(a_.m_stationCs[i]);
+    if (cs.m_left.size() > 1 || cs.m_right.size() > 1)
+      order.push_back((int)i);
+  }
+  if (order.empty())
+    return;
+  const VecDbl& stations(a_.m_csStations);
+  std::stable_sort(order.begin(), order.end(),
+                   [&stations](int a, int b) { return stations[a] < stations[b]; });
+
+  // match up the points of each pair of neighboring stations
+  std::vector<XmStampStationSpan>& spans(a_.m_csStationSpans);
+  spans.resize(std::max<size_t>(order.size() - 1, 1));
+  for (size_t k = 0; k < spans.size(); ++k)
+  {
+    XmStampStationSpan& span(spans[k]);
+    span.m_begStation = order[k];
+    span.m_endStation = order[std::min(k + 1, order.size() - 1)];
+    span.m_beg = stations[span.m_begStation];
+    span.m_end = stations[span.m_endStation];
+    const XmStampCrossSection& prev(a_.m_stationCs[span.m_begStation]);
+    const XmStampCrossSection& next(a_.m_stationCs[span.m_endStation]);
+    if (!(span.m_beg < span.m_end) || !PairCs(prev, next, m_scratch))
+      continue;
+    const stPairScratch& s(m_scratch);
+    XmStampCrossSection &beg(span.m_begCs), &end(span.m_endCs);
+    beg.m_left.assign(1, s.m_p1);
+    beg.m_left.insert(beg.m_left.end(), s.m_left1.begin(), s.m_left1.end());
+    beg.m_right.assign(1, s.m_p1);
+    beg.m_right.insert(beg.m_right.end(), s.m_right1.begin(), s.m_right1.end());
+    end.m_left.assign(1, s.m_p2);
+    end.m_left.insert(end.m_left.end(), s.m_left2.begin(), s.m_left2.end());
+    end.m_right.assign(1, s.m_p2);
+    end.m_right.insert(end.m_right.end(), s.m_right2.begin(), s.m_right2.end());
+    beg.m_leftMax = prev.m_leftMax;
+    beg.m_rightMax = prev.m_rightMax;
+    end.m_leftMax = next.m_leftMax;
+    end.m_rightMax = next.m_rightMax;
+    beg.m_idxLeftShoulder = end.m_idxLeftShoulder = (int)s.m_leftShoulder;
+    beg.m_idxRightShoulder = end.m_idxRightShoulder = (int)s.m_rightShoulder;
+  }
+
+  // cumulative length along the center line at each point
+  const VecPt3d& pts(a_.m_centerLine);
+  VecDbl len(pts.size(), 0.0);
+  for (size_t i = 1; i < pts.size(); ++i)
+    len[i] = len[i - 1] + gmXyDistance(pts[i - 1], pts[i]);
+
+  if (a_.m_cs.size() < pts.size())
+    a_.m_cs.resize(pts.size());
+  if (!a_.m_csTemplates.empty())
+    a_.m_csTemplates.resize(a_.m_cs.size(), -1);
+  a_.m_csStationLengths.assign(a_.m_cs.size(), -1.0);
+  XmStampCrossSection& cs(m_scratch.m_prev);
+  for (size_t i = 0; i < pts.size(); ++i)
+  {
+    if (a_.HasCrossSection(i))
+      continue;
+    a_.m_csStationLengths[i] = len[i];
+    a_.StationCrossSection(len[i], cs);
+    XmStampCrossSection& ioCs(a_.m_cs[i]);
+    ioCs.m_left.clear();
+    ioCs.m_leftMax = cs.m_leftMax;
+    ioCs.m_idxLeftShoulder = cs.m_idxLeftShoulder;
+    ioCs.m_right.clear();
+    ioCs.m_rightMax = cs.m_rightMax;
+    ioCs.m_idxRightShoulder = cs.m_idxRightShoulder;
+  }
+} // XmStampInterpCrossSectionImpl::CrossSectionsFromStations
+//------------------------------------------------------------------------------
 /// \brief Interpolates the missing cross sections. Modifys the m_cs member of
 /// the XmStamperIo class that is passed to this method.
 /// \param [in,out] a_ The inputs and outputs for the feature stamp operation
@@ -182,8 +380,7 @@ int XmStampInterpCrossSectionImpl::FindLastValidCrossSection()
   int csIdx(-1);
   for (size_t i = m_io->m_cs.size(); csIdx == -1 && i > 0; --i)
   {
-    const auto& cs(m_io->m_cs[i - 1]);
-    if (cs.m_left.size() > 1 || cs.m_right.size() > 1)
+    if (m_io->HasCrossSection(i - 1))
     {
       csIdx = static_cast<int>(i - 1);
     }
@@ -204,8 +401,7 @@ int XmStampInterpCrossSectionImpl::FindNextValidCrossSection(int a_idx)
     start = a_idx + 1;
   for (size_t i = start; csIdx == -1 && i < m_io->m_cs.size(); ++i)
   {
-    const auto& cs(m_io->m_cs[i]);
-    if (cs.m_left.size() > 1 || cs.m_right.size() > 1)
+    if (m_io->HasCrossSection(i))
     {
       csIdx = static_cast<int>(i);
     }
@@ -220,14 +416,18 @@ int XmStampInterpCrossSectionImpl::FindNextValidCrossSection(int a_idx)
 /// \param[in] a_percent Interpolation weight applied to the prev/next cross
 /// sections.
 /// \param[out] a_cs The newly interpolated cross section.
+/// \param[in,out] a_scratch Buffers reused between calls. One per thread.
 //------------------------------------------------------------------------------
 void XmStampInterpCrossSectionImpl::InterpCs(int a_prev,
                                              int a_next,
                                              double a_percent,
-                                             XmStampCrossSection& a_cs)
+                                             XmStampCrossSection& a_cs,
+                                             stPairScratch& a_scratch)
 {
-  XmStampCrossSection &pCs(m_io->m_cs[a_prev]), &nCs(m_io->m_cs[a_next]);
-  InterpCs(pCs, nCs, a_percent, a_cs);
+  const XmStampCrossSection& prev(m_io->CrossSection(a_prev, a_scratch.m_prev));
+  const XmStampCrossSection& next(m_io->CrossSection(a_next, a_scratch.m_next));
+  if (PairCs(prev, next, a_scratch))
+    BlendCs(prev, next, a_scratch, a_percent, a_cs);
 } // XmStampInterpCrossSectionImpl::InterpCs
 //------------------------------------------------------------------------------
 /// \brief Interpolates a cross section from 2 other cross sections using a
@@ -238,54 +438,125 @@ void XmStampInterpCrossSectionImpl::InterpCs(int a_prev,
 /// sections.
 /// \param[out] a_cs The newly interpolated cross section.
 //------------------------------------------------------------------------------
-void XmStampInterpCrossSectionImpl::InterpCs(XmStampCrossSection& a_prev,
-                                             XmStampCrossSection& a_next,
+void XmStampInterpCrossSectionImpl::InterpCs(const XmStampCrossSection& a_prev,
+                                             const XmStampCrossSection& a_next,
                                              double a_percent,
                                              XmStampCrossSection& a_cs)
 {
-  XmStampCrossSection &pCs(a_prev), &nCs(a_next);
-  XM_ENSURE_TRUE(!pCs.m_left.empty() || !pCs.m_right.empty());
-  XM_ENSURE_TRUE(!nCs.m_left.empty() || !nCs.m_right.empty());
+  if (PairCs(a_prev, a_next, m_scratch))
+    BlendCs(a_prev, a_next, m_scratch, a_percent, a_cs);
+} // XmStampInterpCrossSectionImpl::InterpCs
+//------------------------------------------------------------------------------
+/// \brief Interpolates several cross sections from 2 other cross sections,
+/// one for each weight. The profiles of the 2 cross sections are matched up
+/// once and then blended at each weight.
+/// \param[in] a_prev The first cross section used to interpolate.
+/// \param[in] a_next The second cross section used to interpolate.
+/// \param[in] a_percents Interpolation weights applied to the prev/next cross
+/// sections.
+/// \param[out] a_cs The newly interpolated cross sections. One per weight.
+//------------------------------------------------------------------------------
+void XmStampInterpCrossSectionImpl::InterpCs(const XmStampCrossSection& a_prev,
+                                             const XmStampCrossSection& a_next,
+                                             const VecDbl& a_percents,
+                                             std::vector<XmStampCrossSection>& a_cs)
+{
+  a_cs.clear();
+  if (!PairCs(a_prev, a_next, m_scratch))
+    return;
+  a_cs.resize(a_percents.size());
+  for (size_t i = 0; i < a_percents.size(); ++i)
+    BlendCs(a_prev, a_next, m_scratch, a_percents[i], a_cs[i]);
+} // XmStampInterpCrossSectionImpl::InterpCs
+//------------------------------------------------------------------------------
+/// \brief Matches up the points of 2 cross sections: center line to shoulder
+/// and then shoulder to end, on each side.
+/// \param[in] a_prev The first cross section.
+/// \param[in] a_next The second cross section.
+/// \param[in,out] a_scratch Gets the matched points. Its buffers are reused.
+/// \return false if either cross section has no points.
+//------------------------------------------------------------------------------
+bool XmStampInterpCrossSectionImpl::PairCs(const XmStampCrossSection& a_prev,
+                                           const XmStampCrossSection& a_next,
+                                           stPairScratch& a_scratch)
+{
+  const XmStampCrossSection &pCs(a_prev), &nCs(a_next);
+  XM_ENSURE_TRUE(!pCs.m_left.empty() || !pCs.m_right.empty(), false);
+  XM_ENSURE_TRUE(!nCs.m_left.empty() || !nCs.m_right.empty(), false);
   // get the interpolated center line location because the Interp pts
   // method will not do the t = 0 location
-  Pt3d pt, p1, p2;
-  if (!pCs.m_left.empty())
-    p1 = pCs.m_left[0];
-  else if (!pCs.m_right.empty())
-    p1 = pCs.m_right[0];
-  if (!nCs.m_left.empty())
-    p2 = nCs.m_left[0];
-  else if (!nCs.m_right.empty())
-    p2 = nCs.m_right[0];
-  pt.x = p1.x - (a_percent * (p1.x - p2.x));
-  pt.y = p1.y - (a_percent * (p1.y - p2.y));
-  a_cs.m_left.assign(1, pt);
-  a_cs.m_right.assign(1, pt);
-
-  // Left side interpolation
-  VecPt3d &l1(pCs.m_left), &l2(nCs.m_left), &l3(a_cs.m_left);
+  stPairScratch& s(a_scratch);
+  s.m_p1 = pCs.m_left.empty() ? pCs.m_right[0] : pCs.m_left[0];
+  s.m_p2 = nCs.m_left.empty() ? nCs.m_right[0] : nCs.m_left[0];
+
+  s.m_left1.clear();
+  s.m_left2.clear();
+  const VecPt3d &l1(pCs.m_left), &l2(nCs.m_left);
   int ls1(pCs.m_idxLeftShoulder), ls2(nCs.m_idxLeftShoulder);
-  // interpolate points between the center line and the left shoulder
-  InterpPts(l1, 0, ls1, l2, 0, ls2, a_percent, l3);
-  a_cs.m_idxLeftShoulder = std::max(0, (int)l3.size() - 1);
-  // interpolate points between left shoulder and end
+  PairPts(l1, 0, ls1, l2, 0, ls2, s, s.m_left1, s.m_left2);
+  s.m_leftShoulder = s.m_left1.size();
   int lend1((int)pCs.m_left.size() - 1), lend2((int)nCs.m_left.size() - 1);
-  InterpPts(l1, ls1, lend1, l2, ls2, lend2, a_percent, l3);
-  // interpolate max dist
-  a_cs.m_leftMax = a_prev.m_leftMax - (a_percent * (a_prev.m_leftMax - a_next.m_leftMax));
+  PairPts(l1, ls1, lend1, l2, ls2, lend2, s, s.m_left1, s.m_left2);
 
-  // Right side interpolation
-  VecPt3d &r1(pCs.m_right), &r2(nCs.m_right), &r3(a_cs.m_right);
+  s.m_right1.clear();
+  s.m_right2.clear();
+  const VecPt3d &r1(pCs.m_right), &r2(nCs.m_right);
   int rs1(pCs.m_idxRightShoulder), rs2(nCs.m_idxRightShoulder);
-  // interpolate points between the center line and the left shoulder
-  InterpPts(r1, 0, rs1, r2, 0, rs2, a_percent, r3);
-  a_cs.m_idxRightShoulder = std::max(0, (int)r3.size() - 1);
-  // interpolate points between left shoulder and end
+  PairPts(r1, 0, rs1, r2, 0, rs2, s, s.m_right1, s.m_right2);
+  s.m_rightShoulder = s.m_right1.size();
   int rend1((int)pCs.m_right.size() - 1), rend2((int)nCs.m_right.size() - 1);
-  InterpPts(r1, rs1, rend1, r2, rs2, rend2, a_percent, r3);
-  // interpolate max dist
-  a_cs.m_rightMax = a_prev.m_rightMax - (a_percent * (a_prev.m_rightMax - a_next.m_rightMax));
-} // XmStampInterpCrossSectionImpl::InterpCs
+  PairPts(r1, rs1, rend1, r2, rs2, rend2, s, s.m_right1, s.m_right2);
+  return true;
+} // XmStampInterpCrossSectionImpl::PairCs
+//------------------------------------------------------------------------------
+/// \brief Blends the points matched by PairCs at a weight. a_cs keeps its
+/// memory so it can be reused for the next cross section.
+/// \param[in] a_prev The first cross section given to PairCs.
+/// \param[in] a_next The second cross section given to PairCs.
+/// \param[in] a_scratch The matched points from PairCs.
+/// \param[in] a_percent Interpolation weight applied to the prev/next cross
+/// sections.
+/// \param[out] a_cs The newly interpolated cross section.
+//------------------------------------------------------------------------------
+void XmStampInterpCrossSectionImpl::BlendCs(const XmStampCrossSection& a_prev,
+                                            const XmStampCrossSection& a_next,
+                                            const stPairScratch& a_scratch,
+                                            double a_percent,
+                                            XmStampCrossSection& a_cs)
+{
+  const stPairScratch& s(a_scratch);
+  const double percent = a_percent;
+  // interpolate max dist. Read before a_cs is written in case it is a_prev.
+  double leftMax = a_prev.m_leftMax - (percent * (a_prev.m_leftMax - a_next.m_leftMax));
+  double rightMax = a_prev.m_rightMax - (percent * (a_prev.m_rightMax - a_next.m_rightMax));
+  Pt3d pt;
+  pt.x = s.m_p1.x - (percent * (s.m_p1.x - s.m_p2.x));
+  pt.y = s.m_p1.y - (percent * (s.m_p1.y - s.m_p2.y));
+
+  a_cs.m_left.resize(s.m_left1.size() + 1);
+  a_cs.m_left[0] = pt;
+  for (size_t j = 0; j < s.m_left1.size(); ++j)
+  {
+    Pt3d& p(a_cs.m_left[j + 1]);
+    p.x = s.m_left1[j].x - (percent * (s.m_left1[j].x - s.m_left2[j].x));
+    p.y = s.m_left1[j].y - (percent * (s.m_left1[j].y - s.m_left2[j].y));
+    p.z = 0.0;
+  }
+  a_cs.m_idxLeftShoulder = (int)s.m_leftShoulder;
+  a_cs.m_leftMax = leftMax;
+
+  a_cs.m_right.resize(s.m_right1.size() + 1);
+  a_cs.m_right[0] = pt;
+  for (size_t j = 0; j < s.m_right1.size(); ++j)
+  {
+    Pt3d& p(a_cs.m_right[j + 1]);
+    p.x = s.m_right1[j].x - (percent * (s.m_right1[j].x - s.m_right2[j].x));
+    p.y = s.m_right1[j].y - (percent * (s.m_right1[j].y - s.m_right2[j].y));
+    p.z = 0.0;
+  }
+  a_cs.m_idxRightShoulder = (int)s.m_rightShoulder;
+  a_cs.m_rightMax = rightMax;
+} // XmStampInterpCrossSectionImpl::BlendCs
 //------------------------------------------------------------------------------
 /// \brief Interpolates part of 2 cross sections to part of a new cross section.
 /// Separate interpolations are done for the cross section between the center
@@ -301,34 +572,125 @@ void XmStampInterpCrossSectionImpl::InterpCs(XmStampCrossSection& a_prev,
 /// sections.
 /// \param[out] a_interpPts Vector of newly interpolated points
 //------------------------------------------------------------------------------
-void XmStampInterpCrossSectionImpl::InterpPts(VecPt3d& a_v1,
+void XmStampInterpCrossSectionImpl::InterpPts(const VecPt3d& a_v1,
                                               int a_beg1,
                                               int a_end1,
-                                              VecPt3d& a_v2,
+                                              const VecPt3d& a_v2,
                                               int a_beg2,
                                               int a_end2,
                                               double a_percent,
                                               VecPt3d& a_interpPts)
 {
-  VecDbl t1, t2;
+  VecPt3d pts1, pts2;
+  PairPts(a_v1, a_beg1, a_end1, a_v2, a_beg2, a_end2, m_scratch, pts1, pts2);
+  Pt3d pt;
+  for (size_t i = 0; i < pts1.size(); ++i)
+  {
+    pt.x = pts1[i].x - (a_percent * (pts1[i].x - pts2[i].x));
+    pt.y = pts1[i].y - (a_percent * (pts1[i].y - pts2[i].y));
+    a_interpPts.push_back(pt);
+  }
+} // XmStampInterpCrossSectionImpl::InterpPts
+//------------------------------------------------------------------------------
+/// \brief Matches up the points of part of 2 cross sections. Both parts are
+/// parameterized from 0 to 1 and a point is found on each part at every t
+/// value of either part (except 0).
+/// \param[in] a_v1 pts from the first cross section
+/// \param[in] a_beg1 Index to the start of the section of a_v1
+/// \param[in] a_end1 Index to the end of the section of a_v1
+/// \param[in] a_v2 pts from the second cross section
+/// \param[in] a_beg2 Index to the start of the section of a_v2
+/// \param[in] a_end2 Index to the end of the section of a_v2
+/// \param[in,out] a_scratch Its t value buffers are reused.
+/// \param[in,out] a_pts1 Points on the first cross section are appended
+/// \param[in,out] a_pts2 Points on the second cross section are appended
+//------------------------------------------------------------------------------
+void XmStampInterpCrossSectionImpl::PairPts(const VecPt3d& a_v1,
+                                            int a_beg1,
+                                            int a_end1,
+                                            const VecPt3d& a_v2,
+                                            int a_beg2,
+                                            int a_end2,
+                                            stPairScratch& a_scratch,
+                                            VecPt3d& a_pts1,
+                                            VecPt3d& a_pts2)
+{
+  VecDbl &t1(a_scratch.m_t1), &t2(a_scratch.m_t2);
   CalcTvals(a_v1, a_beg1, a_end1, t1);
   CalcTvals(a_v2, a_beg2, a_end2, t2);
-  // get a union of t values
+  if (PairPtsMerge(a_v1, a_beg1, t1, a_v2, a_beg2, t2, a_pts1, a_pts2))
+    return;
+
+  // t values are not increasing: get a union of t values
   SetDbl tvals(t1.begin(), t1.end());
   tvals.insert(t2.begin(), t2.end());
-
-  Pt3d p1, p2, pt;
   tvals.erase(0.0);
   for (const auto& t : tvals)
   {
-    p1 = PtFromT(a_v1, a_beg1, t1, t);
-    p2 = PtFromT(a_v2, a_beg2, t2, t);
-    pt.x = p1.x - (a_percent * (p1.x - p2.x));
-    pt.y = p1.y - (a_percent * (p1.y - p2.y));
-    a_interpPts.push_back(pt);
+    a_pts1.push_back(PtFromT(a_v1, a_beg1, t1, t));
+    a_pts2.push_back(PtFromT(a_v2, a_beg2, t2, t));
   }
+} // XmStampInterpCrossSectionImpl::PairPts
+//------------------------------------------------------------------------------
+/// \brief Matches up the points of part of 2 cross sections by walking both
+/// sets of t values together. Same result as looking up each t value in the
+/// sorted union with PtFromT.
+/// \param[in] a_v1 pts from the first cross section
+/// \param[in] a_beg1 Index to the start of the section of a_v1
+/// \param[in] a_t1 t values of the first cross section
+/// \param[in] a_v2 pts from the second cross section
+/// \param[in] a_beg2 Index to the start of the section of a_v2
+/// \param[in] a_t2 t values of the second cross section
+/// \param[in,out] a_pts1 Points on the first cross section are appended
+/// \param[in,out] a_pts2 Points on the second cross section are appended
+/// \return false if either set of t values is not increasing. Nothing is
+/// appended.
+//------------------------------------------------------------------------------
+bool XmStampInterpCrossSectionImpl::PairPtsMerge(const VecPt3d& a_v1,
+                                                 int a_beg1,
+                                                 const VecDbl& a_t1,
+                                                 const VecPt3d& a_v2,
+                                                 int a_beg2,
+                                                 const VecDbl& a_t2,
+                                                 VecPt3d& a_pts1,
+                                                 VecPt3d& a_pts2)
+{
+  // NaN values fail these comparisons too
+  for (size_t i = 1; i < a_t1.size(); ++i)
+  {
+    if (!(a_t1[i] >= a_t1[i - 1]))
+      return false;
+  }
+  for (size_t i = 1; i < a_t2.size(); ++i)
+  {
+    if (!(a_t2[i] >= a_t2[i - 1]))
+      return false;
+  }
+  if ((!a_t1.empty() && !(a_t1[0] == 0.0)) || (!a_t2.empty() && !(a_t2[0] == 0.0)))
+    return false;
 
-} // XmStampInterpCrossSectionImpl::InterpPts
+  size_t i1(0), i2(0), k1(1), k2(1);
+  const size_t n1(a_t1.size()), n2(a_t2.size());
+  a_pts1.reserve(a_pts1.size() + n1 + n2);
+  a_pts2.reserve(a_pts2.size() + n1 + n2);
+  bool first(true);
+  double prev(0.0);
+  while (i1 < n1 || i2 < n2)
+  {
+    double t;
+    if (i2 >= n2 || (i1 < n1 && a_t1[i1] < a_t2[i2]))
+      t = a_t1[i1++];
+    else
+      t = a_t2[i2++];
+    if (t == 0.0 || (!first && t == prev))
+      continue;
+    first = false;
+    prev = t;
+    a_pts1.push_back(PtFromTWalk(a_v1, a_beg1, a_t1, t, k1));
+    a_pts2.push_back(PtFromTWalk(a_v2, a_beg2, a_t2, t, k2));
+  }
+  return true;
+} // XmStampInterpCrossSectionImpl::PairPtsMerge
 //------------------------------------------------------------------------------
 /// \brief Calculates parametric t values from a vector of x,y coords based on x
 /// \param[in] a_v vector of x,y
@@ -336,8 +698,9 @@ void XmStampInterpCrossSectionImpl::InterpPts(VecPt3d& a_v1,
 /// \param[in] a_end Index to the end of the section of a_v
 /// \param[out] a_t Vector of calculated t values
 //------------------------------------------------------------------------------
-void XmStampInterpCrossSectionImpl::CalcTvals(VecPt3d& a_v, int a_beg, int a_end, VecDbl& a_t)
+void XmStampInterpCrossSectionImpl::CalcTvals(const VecPt3d& a_v, int a_beg, int a_end, VecDbl& a_t)
 {
+  a_t.clear();
   if (a_v.empty())
     return;
   a_t.assign(1, 0);
@@ -357,7 +720,10 @@ void XmStampInterpCrossSectionImpl::CalcTvals(VecPt3d& a_v, int a_beg, int a_end
 /// \param[in] a_tval Parametric tvalue
 /// \return the x,y location of the point at a_tval
 //------------------------------------------------------------------------------
-Pt3d XmStampInterpCrossSectionImpl::PtFromT(VecPt3d& a_v, int a_beg, VecDbl& a_t, double a_tval)
+Pt3d XmStampInterpCrossSectionImpl::PtFromT(const VecPt3d& a_v,
+                                            int a_beg,
+                                            const VecDbl& a_t,
+                                            double a_tval)
 {
   if (a_v.empty())
     return Pt3d();
@@ -393,6 +759,44 @@ Pt3d XmStampInterpCrossSectionImpl::PtFromT(VecPt3d& a_v, int a_beg, VecDbl& a_t
   r.y = p1.y + localt * (p2.y - p1.y);
   return r;
 } // XmStampInterpCrossSectionImpl::PtFromT
+//------------------------------------------------------------------------------
+/// \brief Calculates the x,y location of the point at a_tval when the t
+/// values are visited in increasing order. Same result as PtFromT.
+/// \param[in] a_v vector of x,y
+/// \param[in] a_beg Index to the start of the section of a_v
+/// \param[in] a_t Vector of calculated t values (increasing)
+/// \param[in] a_tval Parametric tvalue
+/// \param[in,out] a_k Index into a_t where the search starts. Start at 1.
+/// \return the x,y location of the point at a_tval
+//------------------------------------------------------------------------------
+Pt3d XmStampInterpCrossSectionImpl::PtFromTWalk(const VecPt3d& a_v,
+                                                int a_beg,
+                                                const VecDbl& a_t,
+                                                double a_tval,
+                                                size_t& a_k)
+{
+  if (a_v.empty())
+    return Pt3d();
+  if (a_t.size() == 1 && a_t[0] == 0.0)
+    return a_v[0];
+
+  // first t value that is not less than a_tval
+  while (a_k < a_t.size() && a_t[a_k] < a_tval)
+    ++a_k;
+  if (a_k >= a_t.size())
+    return PtFromT(a_v, a_beg, a_t, a_tval);
+  if (a_t[a_k] == a_tval)
+    return a_v[a_beg + a_k];
+  const Pt3d &p1(a_v[a_beg + a_k - 1]), &p2(a_v[a_beg + a_k]);
+  const double t1(a_t[a_k - 1]), t2(a_t[a_k]);
+  if (a_tval == t1)
+    return p1;
+  Pt3d r;
+  double localt = (a_tval - t1) / (t2 - t1);
+  r.x = p1.x + localt * (p2.x - p1.x);
+  r.y = p1.y + localt * (p2.y - p1.y);
+  return r;
+} // XmStampInterpCrossSectionImpl::PtFromTWalk
 
 //------------------------------------------------------------------------------
 /// \brief Creates a XmStampInterpCrossSection class.
@@ -425,6 +829,8 @@ XmStampInterpCrossSection::~XmStampInterpCrossSection()
 using namespace xms;
 #include <xmsstamper/stamper/detail/XmStampInterpCrossSection.t.h>
 
+#include <algorithm>
+
 #include <xmscore/testing/TestTools.h>
 
 //------------------------------------------------------------------------------
@@ -657,4 +1063,183 @@ void XmStampInterpCrossSectionUnitTests::testCrossSectionTutorial()
 } // XmStampInterpCrossSectionUnitTests::testCrossSectionTutorial
 //! [snip_test_Example_XmStamper_testCrossSectionTutorial]
 
+//------------------------------------------------------------------------------
+/// \brief Tests interpolating long runs of missing cross sections
+//------------------------------------------------------------------------------
+void XmStampInterpCrossSectionUnitTests::testLongRunsOfMissingCrossSections()
+{
+  XmStamperIo io;
+  const int numPts = 300;
+  for (int i = 0; i < numPts; ++i)
+    io.m_centerLine.push_back(Pt3d(i * 2.0, (i % 7) * 0.5, 0));
+  io.m_cs.assign(numPts, XmStampCrossSection());
+
+  XmStampCrossSection cs, cs1;
+  cs.m_left = {{0, 10}, {1, 11}, {2, 12}, {4, 11}, {5, 10}, {10, 5}, {15, 0}};
+  cs.m_idxLeftShoulder = 4;
+  cs.m_leftMax = 16;
+  cs.m_right = cs.m_left;
+  cs.m_idxRightShoulder = cs.m_idxLeftShoulder;
+  cs.m_rightMax = cs.m_leftMax;
+  cs1.m_left = {{0, 20}, {4, 19}, {6, 18}, {8, 18}, {10, 20}, {15, 15}, {20, 10}};
+  cs1.m_leftMax = 19;
+  cs1.m_idxLeftShoulder = 4;
+  cs1.m_right = {{0, 20}, {3, 18}, {20, 10}};
+  cs1.m_idxRightShoulder = 1;
+  cs1.m_rightMax = 22;
+  VecInt valid = {3, 90, 91, 200, 290};
+  for (size_t i = 0; i < valid.size(); ++i)
+    io.m_cs[valid[i]] = i % 2 ? cs1 : cs;
+  XmStamperIo base(io);
+
+  XmStampInterpCrossSectionImpl ip;
+  ip.InterpMissingCrossSections(io);
+
+  XmStampInterpCrossSectionImpl ipBase;
+  ipBase.m_io = &base;
+  for (int i = 0; i < numPts; ++i)
+  {
+    auto it = std::lower_bound(valid.begin(), valid.end(), i);
+    XmStampCrossSection expected;
+    if (it != valid.end() && *it == i)
+      expected = base.m_cs[i];
+    else if (it == valid.begin())
+      expected = base.m_cs[valid.front()];
+    else if (it == valid.end())
+      expected = base.m_cs[valid.back()];
+    else
+    {
+      int prev = *(it - 1), next = *it;
+      double prevDist = gmXyDistance(base.m_centerLine[prev], base.m_centerLine[i]);
+      double nextDist = gmXyDistance(base.m_centerLine[i], base.m_centerLine[next]);
+      ipBase.InterpCs(prev, next, prevDist / (prevDist + nextDist), expected, ipBase.m_scratch);
+    }
+    TS_ASSERT_EQUALS_VEC(expected.m_left, io.m_cs[i].m_left);
+    TS_ASSERT_EQUALS_VEC(expected.m_right, io.m_cs[i].m_right);
+    TS_ASSERT_EQUALS(expected.m_idxLeftShoulder, io.m_cs[i].m_idxLeftShoulder);
+    TS_ASSERT_EQUALS(expected.m_idxRightShoulder, io.m_cs[i].m_idxRightShoulder);
+    TS_ASSERT_EQUALS(expected.m_leftMax, io.m_cs[i].m_leftMax);
+    TS_ASSERT_EQUALS(expected.m_rightMax, io.m_cs[i].m_rightMax);
+  }
+} // XmStampInterpCrossSectionUnitTests::testLongRunsOfMissingCrossSections
+
+//------------------------------------------------------------------------------
+/// \brief Tests interpolating one pair of cross sections at several weights
+//------------------------------------------------------------------------------
+void XmStampInterpCrossSectionUnitTests::testInterpCsMultiplePercents()
+{
+  XmStampCrossSection cs, cs1;
+  cs.m_left = {{0, 10}, {1, 11}, {2, 12}, {4, 11}, {5, 10}, {10, 5}, {15, 0}};
+  cs.m_idxLeftShoulder = 4;
+  cs.m_leftMax = 16;
+  cs.m_right = {{0, 10}, {2, 10}, {2, 9}, {7, 4}};
+  cs.m_idxRightShoulder = 1;
+  cs.m_rightMax = 8;
+  cs1.m_left = {{0, 20}, {4, 19}, {6, 18}, {8, 18}, {10, 20}, {15, 15}, {20, 10}};
+  cs1.m_leftMax = 19;
+  cs1.m_idxLeftShoulder = 4;
+  cs1.m_right = {{0, 20}, {3, 18}, {20, 10}};
+  cs1.m_idxRightShoulder = 1;
+  cs1.m_rightMax = 22;
+
+  XmStampInterpCrossSectionImpl ip;
+  VecDbl percents = {0.0, 0.1, 0.25, 0.5, 0.9, 1.0};
+  std::vector<XmStampCrossSection> vCs;
+  ip.InterpCs(cs, cs1, percents, vCs);
+  TS_ASSERT_EQUALS(percents.size(), vCs.size());
+  for (size_t i = 0; i < percents.size() && i < vCs.size(); ++i)
+  {
+    XmStampCrossSection single;
+    ip.InterpCs(cs, cs1, percents[i], single);
+    TS_ASSERT_EQUALS_VEC(single.m_left, vCs[i].m_left);
+    TS_ASSERT_EQUALS_VEC(single.m_right, vCs[i].m_right);
+    TS_ASSERT_EQUALS(single.m_idxLeftShoulder, vCs[i].m_idxLeftShoulder);
+    TS_ASSERT_EQUALS(single.m_idxRightShoulder, vCs[i].m_idxRightShoulder);
+    TS_ASSERT_EQUALS(single.m_leftMax, vCs[i].m_leftMax);
+    TS_ASSERT_EQUALS(single.m_rightMax, vCs[i].m_rightMax);
+  }
+
+  // the t values up to the left shoulder are merged to 0.2, 0.4, 0.6, 0.8
+  // and 1.0. After the shoulder both have 0.5 and 1.0.
+  VecPt3d base = {{0.0, 15.0}, {1.5, 15.25}, {3.0, 15.5},  {4.5, 14.75},
+                  {6.0, 14.5}, {7.5, 15.0},  {12.5, 10.0}, {17.5, 5.0}};
+  TS_ASSERT_DELTA_VECPT2D(base, vCs[3].m_left, 1e-9);
+  TS_ASSERT_EQUALS(5, vCs[3].m_idxLeftShoulder);
+} // XmStampInterpCrossSectionUnitTests::testInterpCsMultiplePercents
+
+//------------------------------------------------------------------------------
+/// \brief Tests cross sections given at stations along the center line
+//------------------------------------------------------------------------------
+void XmStampInterpCrossSectionUnitTests::testCrossSectionsFromStations()
+{
+  XmStamperIo io;
+  for (int i = 0; i < 11; ++i)
+    io.m_centerLine.push_back(Pt3d(i * 10.0, 0, 0));
+
+  XmStampCrossSection cs, cs1, cs2;
+  cs.m_left = {{0, 10}, {1, 11}, {2, 12}, {4, 11}, {5, 10}, {10, 5}, {15, 0}};
+  cs.m_idxLeftShoulder = 4;
+  cs.m_leftMax = 16;
+  cs.m_right = cs.m_left;
+  cs.m_idxRightShoulder = cs.m_idxLeftShoulder;
+  cs.m_rightMax = cs.m_leftMax;
+  cs1.m_left = {{0, 20}, {4, 19}, {6, 18}, {8, 18}, {10, 20}, {15, 15}, {20, 10}};
+  cs1.m_leftMax = 19;
+  cs1.m_idxLeftShoulder = 4;
+  cs1.m_right = cs1.m_left;
+  cs1.m_idxRightShoulder = cs1.m_idxLeftShoulder;
+  cs1.m_rightMax = cs1.m_leftMax;
+  cs2.m_left = {{0, 5}, {5, 0}};
+  cs2.m_idxLeftShoulder = 1;
+  cs2.m_leftMax = 5;
+  cs2.m_right = cs2.m_left;
+  cs2.m_idxRightShoulder = 1;
+  cs2.m_rightMax = 5;
+
+  // stations out of order. The cross section at point 5 overrides.
+  io.m_csStations = {75.0, 25.0};
+  io.m_stationCs = {cs1, cs};
+  io.m_cs.assign(11, XmStampCrossSection());
+  io.m_cs[5] = cs2;
+
+  XmStampInterpCrossSectionImpl ip;
+  ip.CrossSectionsFromStations(io);
+  TS_ASSERT_EQUALS(11, io.m_cs.size());
+  TS_ASSERT_EQUALS(1, io.m_csStationSpans.size());
+  XmStampCrossSection buf;
+  for (int i = 0; i < 11; ++i)
+  {
+    XmStampCrossSection expected;
+    double x = i * 10.0;
+    if (i == 5)
+      expected = cs2;
+    else if (x <= 25.0)
+      expected = cs;
+    else if (x >= 75.0)
+      expected = cs1;
+    else
+      ip.InterpCs(cs, cs1, (x - 25.0) / 50.0, expected);
+    // the points are only blended when the cross section is read
+    TS_ASSERT(i == 5 || io.m_cs[i].m_left.empty());
+    TS_ASSERT(io.HasCrossSection(i));
+    const XmStampCrossSection& got(io.CrossSection(i, buf));
+    TS_ASSERT_EQUALS_VEC(expected.m_left, got.m_left);
+    TS_ASSERT_EQUALS_VEC(expected.m_right, got.m_right);
+    TS_ASSERT_EQUALS(expected.m_idxLeftShoulder, got.m_idxLeftShoulder);
+    TS_ASSERT_EQUALS(expected.m_leftMax, got.m_leftMax);
+  }
+
+  // m_cs can be left empty
+  io.m_cs.clear();
+  ip.CrossSectionsFromStations(io);
+  TS_ASSERT_EQUALS(11, io.m_cs.size());
+  TS_ASSERT_EQUALS_VEC(cs.m_left, io.CrossSection(0, buf).m_left);
+  TS_ASSERT_EQUALS_VEC(cs1.m_left, io.CrossSection(10, buf).m_left);
+  // at 50 the cross section is halfway between the 2 stations
+  XmStampCrossSection half;
+  ip.InterpCs(cs, cs1, 0.5, half);
+  TS_ASSERT_EQUALS_VEC(half.m_left, io.CrossSection(5, buf).m_left);
+  TS_ASSERT_EQUALS(17.5, io.CrossSection(5, buf).m_leftMax);
+} // XmStampInterpCrossSectionUnitTests::testCrossSectionsFromStations
+
 #endif
@@ -13,6 +13,7 @@
 // 4. External library headers
 #include <xmscore/misc/boost_defines.h>
 #include <xmscore/misc/base_macros.h> // for XM_DISALLOW_COPY_AND_ASSIGN
+#include <xmscore/stl/vector.h>
 
 // 5. Shared code headers
 
@@ -44,11 +45,16 @@ public:
   virtual ~XmStampInterpCrossSection();
   /// \cond
   virtual void InterpMissingCrossSections(XmStamperIo& a_) = 0;
+  virtual void CrossSectionsFromStations(XmStamperIo& a_) = 0;
   virtual bool ValidCrossSectionsExist(XmStamperIo& a_) = 0;
-  virtual void InterpCs(XmStampCrossSection& a_prev,
-                        XmStampCrossSection& a_next,
+  virtual void InterpCs(const XmStampCrossSection& a_prev,
+                        const XmStampCrossSection& a_next,
                         double a_percent,
                         XmStampCrossSection& a_cs) = 0;
+  virtual void InterpCs(const XmStampCrossSection& a_prev,
+                        const XmStampCrossSection& a_next,
+                        const VecDbl& a_percents,
+                        std::vector<XmStampCrossSection>& a_cs) = 0;
 
 private:
   XM_DISALLOW_COPY_AND_ASSIGN(XmStampInterpCrossSection);
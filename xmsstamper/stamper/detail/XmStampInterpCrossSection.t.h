@@ -27,6 +27,9 @@ public:
   void test1();
   void test2();
   void testCrossSectionTutorial();
+  void testLongRunsOfMissingCrossSections();
+  void testInterpCsMultiplePercents();
+  void testCrossSectionsFromStations();
 }; // XmStampInterpCrossSectionUnitTests
 
 #endif
@@ -41,15 +41,20 @@
 //------------------------------------------------------------------------------
 #include <xmsstamper/stamper/detail/XmStampTests.t.h>
 
+#include <climits>
+#include <cstring>
 #include <fstream>
+#include <sstream>
 
 #include <xmscore/misc/StringUtil.h> // stEqualNoCase
 #include <xmscore/misc/XmError.h> // XM_ENSURE_TRUE
 #include <xmscore/misc/xmstype.h> // XM_NODATA
 #include <xmscore/testing/TestTools.h>
 
+#include <xmsstamper/stamper/XmBathymetryStore.h>
 #include <xmsstamper/stamper/XmStamper.h>
 #include <xmsstamper/stamper/XmStamperIo.h>
+#include <xmsstamper/stamper/detail/XmEndCapTemplates.h>
 #include <xmsgrid/triangulate/TrTin.h>
 #include <xmscore/misc/environment.h>
 
@@ -351,4 +356,575 @@ void XmStampIntermediateTests::test_BuildRasterAndGetCellValue()
   TS_ASSERT_EQUALS(lastCell, 5);
   TS_ASSERT_EQUALS(raster.m_vals[lastCell], 5.0);
 } // XmStampIntermediateTests::test_BuildRasterAndGetCellValue
+//------------------------------------------------------------------------------
+/// \brief Tests writing and reading a TIN in the binary format.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_BinaryTin()
+{
+  std::string path(XMS_TEST_PATH);
+  path += "stamping/test_WingWall01/";
+  XmStamperIo io;
+  iBuildStamperIo(path, io);
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT(io.m_outTin);
+  if (!io.m_outTin)
+    return;
+
+  // original triangle order with adjacency
+  std::string fname(path + "tin_out.bin");
+  TS_ASSERT(XmStamperIo::WriteTinToBinaryFile(fname, io.m_outTin, false, true));
+  BSHP<TrTin> tin = TrTin::New();
+  TS_ASSERT(XmStamperIo::ReadTinFromBinaryFile(fname, tin));
+  TS_ASSERT_EQUALS_VEC(io.m_outTin->Points(), tin->Points());
+  TS_ASSERT_EQUALS_VEC(io.m_outTin->Triangles(), tin->Triangles());
+  TS_ASSERT(io.m_outTin->TrisAdjToPts() == tin->TrisAdjToPts());
+
+  // canonical order matches the text output
+  TS_ASSERT(XmStamperIo::WriteTinToBinaryFile(fname, io.m_outTin, true));
+  tin = TrTin::New();
+  TS_ASSERT(XmStamperIo::ReadTinFromBinaryFile(fname, tin));
+  TS_ASSERT_EQUALS_VEC(io.m_outTin->Points(), tin->Points());
+  TS_ASSERT_EQUALS(io.m_outTin->Triangles().size(), tin->Triangles().size());
+  const VecInt& tris(tin->Triangles());
+  for (size_t i = 0; i < tris.size(); i += 3)
+  {
+    TS_ASSERT(tris[i] < tris[i + 1] && tris[i] < tris[i + 2]);
+    if (i > 0)
+      TS_ASSERT(!std::lexicographical_compare(tris.begin() + i, tris.begin() + i + 3,
+                                              tris.begin() + i - 3, tris.begin() + i));
+  }
+  TS_ASSERT_EQUALS(io.m_outTin->NumPoints(), (int)tin->TrisAdjToPts().size());
+
+  // corrupt files are rejected. The header is the signature, version, flags
+  // and 3 counts followed by the points, triangles, adjacency offsets and
+  // adjacency entries.
+  TS_ASSERT(XmStamperIo::WriteTinToBinaryFile(fname, io.m_outTin, false, true));
+  std::string good;
+  {
+    std::ifstream is(fname.c_str(), std::ios::in | std::ios::binary);
+    std::stringstream ss;
+    ss << is.rdbuf();
+    good = ss.str();
+  }
+  const size_t numPtsPos = 8 + 2 * sizeof(uint32_t);
+  const size_t headerSize = numPtsPos + 3 * sizeof(int64_t);
+  const size_t trisBeg = headerSize + io.m_outTin->Points().size() * sizeof(Pt3d);
+  const size_t offsetsBeg = trisBeg + io.m_outTin->Triangles().size() * sizeof(int);
+  auto readCorrupt = [&](const std::string& a_bytes) {
+    {
+      std::ofstream os(fname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      os.write(a_bytes.data(), a_bytes.size());
+    }
+    BSHP<TrTin> badTin = TrTin::New();
+    return XmStamperIo::ReadTinFromBinaryFile(fname, badTin);
+  };
+  auto setValue = [](std::string& a_bytes, size_t a_pos, auto a_val) {
+    memcpy(&a_bytes[a_pos], &a_val, sizeof(a_val));
+  };
+  TS_ASSERT(readCorrupt(good));
+  std::string bad(good);
+  setValue(bad, numPtsPos, (int64_t)INT_MAX / 2); // more points than the file holds
+  TS_ASSERT(!readCorrupt(bad));
+  bad = good;
+  setValue(bad, numPtsPos, (int64_t)-1); // negative number of points
+  TS_ASSERT(!readCorrupt(bad));
+  bad = good;
+  setValue(bad, trisBeg, (int32_t)io.m_outTin->NumPoints()); // point index out of range
+  TS_ASSERT(!readCorrupt(bad));
+  bad = good;
+  setValue(bad, offsetsBeg + sizeof(int64_t), (int64_t)-1); // offsets not increasing
+  TS_ASSERT(!readCorrupt(bad));
+  bad = good;
+  setValue(bad, good.size() - sizeof(int), (int32_t)io.m_outTin->NumTriangles());
+  TS_ASSERT(!readCorrupt(bad)); // triangle index out of range
+  TS_ASSERT(!readCorrupt(good.substr(0, trisBeg + 6))); // truncated
+  remove(fname.c_str());
+} // XmStampIntermediateTests::test_BinaryTin
+//------------------------------------------------------------------------------
+/// \brief Tests writing and reading XmStamperIo in the binary format.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_BinaryStamperIo()
+{
+  std::string path(XMS_TEST_PATH);
+  path += "stamping/test_intersectBathymetry01/";
+  XmStamperIo io;
+  iBuildStamperIo(path, io);
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+
+  std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+  TS_ASSERT(io.WriteToBinary(ss));
+  XmStamperIo io2;
+  TS_ASSERT(io2.ReadFromBinary(ss));
+
+  // the text output must match the stamp baseline
+  std::string outFile(path + "StamperIo_bin_out.txt"), baseFile(path + "xmsng_base.txt");
+  iOutputToFile(outFile, io2);
+  TS_ASSERT_TXT_FILES_EQUAL(baseFile, outFile);
+
+  // raster
+  XmStamperIo ioRaster;
+  ioRaster.m_raster =
+    XmStampRaster(2, 3, 2.0, 1.0, Pt3d(1.0, 2.0), {0, 1, 2, 3, 4, 5}, XM_NODATA);
+  std::stringstream ssRaster(std::ios::in | std::ios::out | std::ios::binary);
+  TS_ASSERT(ioRaster.WriteToBinary(ssRaster));
+  XmStamperIo ioRaster2;
+  TS_ASSERT(ioRaster2.ReadFromBinary(ssRaster));
+  const XmStampRaster &r(ioRaster.m_raster), &r2(ioRaster2.m_raster);
+  TS_ASSERT_EQUALS(r.m_numPixelsX, r2.m_numPixelsX);
+  TS_ASSERT_EQUALS(r.m_numPixelsY, r2.m_numPixelsY);
+  TS_ASSERT_EQUALS(r.m_pixelSizeX, r2.m_pixelSizeX);
+  TS_ASSERT_EQUALS(r.m_pixelSizeY, r2.m_pixelSizeY);
+  TS_ASSERT_EQUALS(r.m_min, r2.m_min);
+  TS_ASSERT_EQUALS_VEC(r.m_vals, r2.m_vals);
+  TS_ASSERT_EQUALS(r.m_noData, r2.m_noData);
+
+  // options
+  XmStamperIo ioOpts;
+  ioOpts.m_csStations = {0.0, 10.0};
+  ioOpts.m_stationCs.assign(2, XmStampCrossSection());
+  ioOpts.m_stationCs[1].m_leftMax = 5.0;
+  ioOpts.m_firstEndCap.m_maxChordDeviation = 0.25;
+  ioOpts.m_lastEndCap.m_maxChordDeviation = 0.5;
+  ioOpts.m_centerLineTolerance = 0.1;
+  ioOpts.m_targetPoints = {{1, 2, 3}, {4, 5, XM_NODATA}};
+  ioOpts.m_stripTriangulation = true;
+  ioOpts.m_lazyOutputs = true;
+  ioOpts.m_hilbertOrder = true;
+  ioOpts.m_rasterDepths = true;
+  ioOpts.m_flatBreaklinesOnly = true;
+  std::stringstream ssOpts(std::ios::in | std::ios::out | std::ios::binary);
+  TS_ASSERT(ioOpts.WriteToBinary(ssOpts));
+  XmStamperIo ioOpts2;
+  ioOpts2.m_geometryOnly = ioOpts2.m_weldPoints = ioOpts2.m_tinVolumes = true;
+  TS_ASSERT(ioOpts2.ReadFromBinary(ssOpts));
+  TS_ASSERT_EQUALS_VEC(ioOpts.m_csStations, ioOpts2.m_csStations);
+  TS_ASSERT_EQUALS(2, ioOpts2.m_stationCs.size());
+  if (ioOpts2.m_stationCs.size() == 2)
+    TS_ASSERT_EQUALS(5.0, ioOpts2.m_stationCs[1].m_leftMax);
+  TS_ASSERT_EQUALS(0.25, ioOpts2.m_firstEndCap.m_maxChordDeviation);
+  TS_ASSERT_EQUALS(0.5, ioOpts2.m_lastEndCap.m_maxChordDeviation);
+  TS_ASSERT_EQUALS(0.1, ioOpts2.m_centerLineTolerance);
+  TS_ASSERT(ioOpts.m_targetPoints == ioOpts2.m_targetPoints);
+  TS_ASSERT(ioOpts2.m_stripTriangulation);
+  TS_ASSERT(!ioOpts2.m_geometryOnly);
+  TS_ASSERT(ioOpts2.m_lazyOutputs);
+  TS_ASSERT(!ioOpts2.m_weldPoints);
+  TS_ASSERT(ioOpts2.m_hilbertOrder);
+  TS_ASSERT(!ioOpts2.m_spliceIntoBathymetry);
+  TS_ASSERT(ioOpts2.m_rasterDepths);
+  TS_ASSERT(!ioOpts2.m_tinVolumes);
+  TS_ASSERT(ioOpts2.m_flatBreaklinesOnly);
+
+  // outputs
+  XmStamperIo ioOut;
+  ioOut.m_outBreakLines = {{0, 1}, {2, 3, 4}};
+  ioOut.m_outBreakLineOffsets = {0, 2, 5};
+  ioOut.m_outBreakLinePts = {0, 1, 2, 3, 4};
+  ioOut.m_outBreakLineTypes = {1, 2};
+  ioOut.m_outNumCenterLinePtsRemoved = 3;
+  ioOut.m_outNumWeldedPts = 4;
+  ioOut.m_outPoints = {{0, 0, 1}, {1, 0, 2}, {1, 1, 3}};
+  ioOut.m_outOuterPolygons = {{0, 1, 2}};
+  ioOut.m_outSplicedTin = TrTin::New();
+  ioOut.m_outSplicedTin->Points() = ioOut.m_outPoints;
+  ioOut.m_outSplicedTin->Triangles() = {0, 1, 2};
+  ioOut.m_outVolumes.m_cutVolume = 1.5;
+  ioOut.m_outVolumes.m_fillVolume = 2.5;
+  ioOut.m_outVolumes.m_numChangedCells = 2;
+  ioOut.m_outVolumes.m_depths = {0.0, -1.0, 2.0};
+  ioOut.m_outTinCutVolume = 3.5;
+  ioOut.m_outTinFillVolume = 4.5;
+  std::stringstream ssOut(std::ios::in | std::ios::out | std::ios::binary);
+  TS_ASSERT(ioOut.WriteToBinary(ssOut));
+  XmStamperIo ioOut2;
+  TS_ASSERT(ioOut2.ReadFromBinary(ssOut));
+  TS_ASSERT(ioOut.m_outBreakLines == ioOut2.m_outBreakLines);
+  TS_ASSERT_EQUALS_VEC(ioOut.m_outBreakLineOffsets, ioOut2.m_outBreakLineOffsets);
+  TS_ASSERT_EQUALS_VEC(ioOut.m_outBreakLinePts, ioOut2.m_outBreakLinePts);
+  TS_ASSERT_EQUALS_VEC(ioOut.m_outBreakLineTypes, ioOut2.m_outBreakLineTypes);
+  TS_ASSERT_EQUALS(3, ioOut2.m_outNumCenterLinePtsRemoved);
+  TS_ASSERT_EQUALS(4, ioOut2.m_outNumWeldedPts);
+  TS_ASSERT(ioOut.m_outPoints == ioOut2.m_outPoints);
+  TS_ASSERT(ioOut.m_outOuterPolygons == ioOut2.m_outOuterPolygons);
+  TS_ASSERT(ioOut2.m_outSplicedTin);
+  if (ioOut2.m_outSplicedTin)
+  {
+    TS_ASSERT(ioOut.m_outPoints == ioOut2.m_outSplicedTin->Points());
+    TS_ASSERT_EQUALS_VEC(VecInt({0, 1, 2}), ioOut2.m_outSplicedTin->Triangles());
+  }
+  TS_ASSERT_EQUALS(1.5, ioOut2.m_outVolumes.m_cutVolume);
+  TS_ASSERT_EQUALS(2.5, ioOut2.m_outVolumes.m_fillVolume);
+  TS_ASSERT_EQUALS(2, ioOut2.m_outVolumes.m_numChangedCells);
+  TS_ASSERT_EQUALS_VEC(ioOut.m_outVolumes.m_depths, ioOut2.m_outVolumes.m_depths);
+  TS_ASSERT_EQUALS(3.5, ioOut2.m_outTinCutVolume);
+  TS_ASSERT_EQUALS(4.5, ioOut2.m_outTinFillVolume);
+
+  // bad signature
+  std::stringstream bad("not a stamper io");
+  XmStamperIo io3;
+  TS_ASSERT(!io3.ReadFromBinary(bad));
+} // XmStampIntermediateTests::test_BinaryStamperIo
+//------------------------------------------------------------------------------
+/// \brief Tests stamping with cross sections from a template library.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_CrossSectionLibrary()
+{
+  std::string path(XMS_TEST_PATH);
+  path += "stamping/test_intersectBathymetry01/";
+  XmStamperIo io;
+  iBuildStamperIo(path, io);
+
+  // move the cross sections with points to a library
+  XmStamperIo ioLib(io);
+  ioLib.m_csLibrary.reset(new XmStampCrossSectionLibrary);
+  ioLib.m_csTemplates.assign(io.m_cs.size(), -1);
+  for (size_t i = 0; i < io.m_cs.size(); ++i)
+  {
+    const XmStampCrossSection& cs(io.m_cs[i]);
+    if (cs.m_left.size() > 1 || cs.m_right.size() > 1)
+      ioLib.m_csTemplates[i] = ioLib.m_csLibrary->Add(cs);
+  }
+  ioLib.m_cs.clear();
+  TS_ASSERT(ioLib.m_csLibrary->NumTemplates() > 0);
+
+  XmStampCrossSection cs;
+  TS_ASSERT(!ioLib.m_csLibrary->Get(-1, cs));
+  TS_ASSERT(ioLib.m_csLibrary->Get(0, cs));
+  for (size_t i = 0; i < io.m_cs.size(); ++i)
+  {
+    if (ioLib.m_csTemplates[i] == 0)
+    {
+      TS_ASSERT_EQUALS(io.m_cs[i].m_left.size(), cs.m_left.size());
+      TS_ASSERT_EQUALS(io.m_cs[i].m_idxLeftShoulder, cs.m_idxLeftShoulder);
+      TS_ASSERT_EQUALS(io.m_cs[i].m_rightMax, cs.m_rightMax);
+      break;
+    }
+  }
+
+  // the templates are copied out of the library only when a point is read
+  XmStamperIo ioPrep(ioLib);
+  ioPrep.PrepareCrossSectionLibrary();
+  TS_ASSERT_EQUALS(io.m_cs.size(), ioPrep.m_cs.size());
+  TS_ASSERT_EQUALS(io.m_cs.size(), ioPrep.m_csTemplates.size());
+  int numShared(0);
+  for (size_t i = 0; i < ioPrep.m_cs.size() && i < ioPrep.m_csTemplates.size(); ++i)
+  {
+    TS_ASSERT_EQUALS(io.m_cs[i].m_left.size() > 1 || io.m_cs[i].m_right.size() > 1,
+                     ioPrep.HasCrossSection(i));
+    if (ioPrep.m_csTemplates[i] < 0)
+      continue;
+    ++numShared;
+    TS_ASSERT(ioPrep.m_cs[i].m_left.empty() && ioPrep.m_cs[i].m_right.empty());
+    TS_ASSERT_EQUALS(io.m_cs[i].m_idxLeftShoulder, ioPrep.m_cs[i].m_idxLeftShoulder);
+    const XmStampCrossSection &tcs(ioPrep.CrossSection(i, cs));
+    TS_ASSERT(&tcs == &cs);
+    TS_ASSERT_DELTA_VECPT2D(io.m_cs[i].m_left, tcs.m_left, 0.0);
+    TS_ASSERT_DELTA_VECPT2D(io.m_cs[i].m_right, tcs.m_right, 0.0);
+    TS_ASSERT_EQUALS(io.m_cs[i].m_rightMax, tcs.m_rightMax);
+  }
+  TS_ASSERT(numShared > 0);
+
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  BSHP<XmStamper> s2 = XmStamper::New();
+  s2->DoStamp(ioLib);
+  TS_ASSERT(io.m_outTin && ioLib.m_outTin);
+  if (!io.m_outTin || !ioLib.m_outTin)
+    return;
+  TS_ASSERT_EQUALS_VEC(io.m_outTin->Points(), ioLib.m_outTin->Points());
+  TS_ASSERT_EQUALS_VEC(io.m_outTin->Triangles(), ioLib.m_outTin->Triangles());
+  TS_ASSERT(io.m_outBreakLines == ioLib.m_outBreakLines);
+} // XmStampIntermediateTests::test_CrossSectionLibrary
+//------------------------------------------------------------------------------
+/// \brief Tests the offsets form of the output breaklines.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_FlatBreaklines()
+{
+  std::string path(XMS_TEST_PATH);
+  path += "stamping/test_intersectBathymetry01/";
+  XmStamperIo io;
+  iBuildStamperIo(path, io);
+  XmStamperIo ioFlat(io);
+  ioFlat.m_flatBreaklinesOnly = true;
+
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT(!io.m_outBreakLines.empty());
+  TS_ASSERT_EQUALS(io.m_outBreakLines.size() + 1, io.m_outBreakLineOffsets.size());
+  TS_ASSERT_EQUALS(io.m_outBreakLines.size(), io.m_outBreakLineTypes.size());
+  for (size_t i = 0; i < io.m_outBreakLines.size() && i + 1 < io.m_outBreakLineOffsets.size(); ++i)
+  {
+    VecInt bl(io.m_outBreakLinePts.begin() + io.m_outBreakLineOffsets[i],
+              io.m_outBreakLinePts.begin() + io.m_outBreakLineOffsets[i + 1]);
+    TS_ASSERT_EQUALS_VEC(io.m_outBreakLines[i], bl);
+  }
+  TS_ASSERT(s->GetSegments() == io.m_outBreakLines);
+  TS_ASSERT_EQUALS_VEC(io.m_outBreakLineOffsets, s->GetSegmentOffsets());
+  TS_ASSERT_EQUALS_VEC(io.m_outBreakLinePts, s->GetSegmentPoints());
+  TS_ASSERT_EQUALS_VEC(io.m_outBreakLineTypes, s->GetBreaklineTypes());
+
+  BSHP<XmStamper> s2 = XmStamper::New();
+  s2->DoStamp(ioFlat);
+  TS_ASSERT(ioFlat.m_outBreakLines.empty());
+  TS_ASSERT_EQUALS_VEC(io.m_outBreakLineOffsets, ioFlat.m_outBreakLineOffsets);
+  TS_ASSERT_EQUALS_VEC(io.m_outBreakLinePts, ioFlat.m_outBreakLinePts);
+  TS_ASSERT_EQUALS_VEC(io.m_outBreakLineTypes, ioFlat.m_outBreakLineTypes);
+} // XmStampIntermediateTests::test_FlatBreaklines
+//------------------------------------------------------------------------------
+/// \brief Tests tessellating end caps by a max chord deviation.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_EndCapChordDeviation()
+{
+  std::string tests[2] = {"test_SlopedAbutment01/", "test_GuideBank02/"};
+  for (const auto& test : tests)
+  {
+    std::string path(XMS_TEST_PATH);
+    path += "stamping/" + test;
+    XmStamperIo io;
+    iBuildStamperIo(path, io);
+    XmStamperIo ioCoarse(io), ioFine(io);
+    ioCoarse.m_firstEndCap.m_maxChordDeviation = ioCoarse.m_lastEndCap.m_maxChordDeviation = 1e6;
+    ioFine.m_firstEndCap.m_maxChordDeviation = ioFine.m_lastEndCap.m_maxChordDeviation = 0.01;
+
+    BSHP<XmStamper> s = XmStamper::New();
+    s->DoStamp(ioCoarse);
+    s = XmStamper::New();
+    s->DoStamp(ioFine);
+    TS_ASSERT(ioCoarse.m_outTin && ioFine.m_outTin);
+    if (!ioCoarse.m_outTin || !ioFine.m_outTin)
+      continue;
+    TS_ASSERT(ioCoarse.m_outTin->Points().size() < ioFine.m_outTin->Points().size());
+  }
+} // XmStampIntermediateTests::test_EndCapChordDeviation
+//------------------------------------------------------------------------------
+/// \brief Tests removing redundant center line points before stamping.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_SimplifyCenterLine()
+{
+  XmStamperIo io;
+  io.m_stampingType = 1;
+  for (int i = 0; i < 21; ++i)
+    io.m_centerLine.push_back(Pt3d(i * 5.0, (i % 2) * 0.01, 10.0));
+  XmStampCrossSection cs;
+  cs.m_left = {{0, 10}, {5, 10}, {15, 0}};
+  cs.m_leftMax = 15;
+  cs.m_idxLeftShoulder = 1;
+  cs.m_right = cs.m_left;
+  cs.m_rightMax = cs.m_leftMax;
+  cs.m_idxRightShoulder = cs.m_idxLeftShoulder;
+  io.m_cs.assign(io.m_centerLine.size(), cs);
+  XmStamperIo ioSimple(io);
+  ioSimple.m_centerLineTolerance = 0.1;
+
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT_EQUALS(0, io.m_outNumCenterLinePtsRemoved);
+  s = XmStamper::New();
+  s->DoStamp(ioSimple);
+  TS_ASSERT_EQUALS(19, ioSimple.m_outNumCenterLinePtsRemoved);
+  TS_ASSERT(io.m_outTin && ioSimple.m_outTin);
+  if (!io.m_outTin || !ioSimple.m_outTin)
+    return;
+  TS_ASSERT(ioSimple.m_outTin->Points().size() < io.m_outTin->Points().size());
+  TS_ASSERT(ioSimple.m_outBreakLines.size() < io.m_outBreakLines.size());
+} // XmStampIntermediateTests::test_SimplifyCenterLine
+//------------------------------------------------------------------------------
+/// \brief Tests that cached end cap cross sections give the same stamp.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_EndCapTemplates()
+{
+  std::string tests[2] = {"test_SlopedAbutment01/", "test_GuideBank02/"};
+  for (const auto& test : tests)
+  {
+    std::string path(XMS_TEST_PATH);
+    path += "stamping/" + test;
+    XmStamperIo io;
+    iBuildStamperIo(path, io);
+    XmStamperIo io1(io), io2(io);
+
+    XmEndCapTemplates::Clear();
+    XmEndCapTemplates::SetMaxTemplates(0);
+    BSHP<XmStamper> s = XmStamper::New();
+    s->DoStamp(io);
+    TS_ASSERT_EQUALS(0, XmEndCapTemplates::NumTemplates());
+    XmEndCapTemplates::SetMaxTemplates(256);
+    s = XmStamper::New();
+    s->DoStamp(io1);
+    TS_ASSERT(XmEndCapTemplates::NumTemplates() > 0);
+    s = XmStamper::New();
+    s->DoStamp(io2);
+    TS_ASSERT(io.m_outTin && io1.m_outTin && io2.m_outTin);
+    if (!io.m_outTin || !io1.m_outTin || !io2.m_outTin)
+      continue;
+    TS_ASSERT(io.m_outTin->Points() == io1.m_outTin->Points());
+    TS_ASSERT(io.m_outTin->Points() == io2.m_outTin->Points());
+    TS_ASSERT(io.m_outBreakLines == io2.m_outBreakLines);
+  }
+
+  // the oldest template is dropped when the cache is full
+  XmEndCapTemplates::Clear();
+  XmEndCapTemplates::SetMaxTemplates(2);
+  std::vector<XmStampCrossSection> vCs(1), vCsOut;
+  vCs[0].m_left = {{0, 1}, {2, 3}};
+  XmEndCapTemplates::Add("a", vCs);
+  XmEndCapTemplates::Add("b", vCs);
+  XmEndCapTemplates::Add("c", vCs);
+  TS_ASSERT_EQUALS(2, XmEndCapTemplates::NumTemplates());
+  TS_ASSERT(!XmEndCapTemplates::Find("a", vCsOut));
+  TS_ASSERT(XmEndCapTemplates::Find("c", vCsOut));
+  TS_ASSERT_EQUALS_VEC(vCs[0].m_left, vCsOut[0].m_left);
+  XmEndCapTemplates::Clear();
+  XmEndCapTemplates::SetMaxTemplates(256);
+} // XmStampIntermediateTests::test_EndCapTemplates
+//------------------------------------------------------------------------------
+/// \brief Tests triangulating the stamp one cross section strip at a time.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_StripTriangulation()
+{
+  std::string path(XMS_TEST_PATH);
+  path += "stamping/test_WingWall01/";
+  XmStamperIo io;
+  iBuildStamperIo(path, io);
+  XmStamperIo ioStrips(io);
+  ioStrips.m_stripTriangulation = true;
+
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  s = XmStamper::New();
+  s->DoStamp(ioStrips);
+  TS_ASSERT(io.m_outTin && ioStrips.m_outTin);
+  if (!io.m_outTin || !ioStrips.m_outTin)
+    return;
+  // same points and breaklines. Both triangulate the same polygon so they have
+  // the same number of triangles and the same area.
+  TS_ASSERT(io.m_outTin->Points() == ioStrips.m_outTin->Points());
+  TS_ASSERT(io.m_outBreakLines == ioStrips.m_outBreakLines);
+  TS_ASSERT_EQUALS(io.m_outTin->NumTriangles(), ioStrips.m_outTin->NumTriangles());
+  auto area = [](const BSHP<TrTin>& a_tin) {
+    double sum(0);
+    const VecPt3d& pts(a_tin->Points());
+    const VecInt& tris(a_tin->Triangles());
+    for (size_t i = 0; i + 2 < tris.size(); i += 3)
+    {
+      const Pt3d &p0(pts[tris[i]]), &p1(pts[tris[i + 1]]), &p2(pts[tris[i + 2]]);
+      double a = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+      TS_ASSERT(a > 0.0);
+      sum += a / 2;
+    }
+    return sum;
+  };
+  TS_ASSERT_DELTA(area(io.m_outTin), area(ioStrips.m_outTin), 1e-6);
+} // XmStampIntermediateTests::test_StripTriangulation
+//------------------------------------------------------------------------------
+/// \brief Tests splicing the stamp into the bathymetry.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_SpliceIntoBathymetry()
+{
+  // the stamp is inside the bathymetry
+  std::string path(XMS_TEST_PATH);
+  path += "stamping/test_intersectBathymetry04/";
+  XmStamperIo io;
+  iBuildStamperIo(path, io);
+  TS_ASSERT(io.m_bathymetry);
+  if (!io.m_bathymetry)
+    return;
+  io.m_spliceIntoBathymetry = true;
+  int numBathPts = io.m_bathymetry->NumPoints();
+  int numBathTris = io.m_bathymetry->NumTriangles();
+
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+  TS_ASSERT(io.m_outTin);
+  TS_ASSERT(io.m_outSplicedTin);
+  TS_ASSERT_EQUALS(numBathPts, io.m_bathymetry->NumPoints());
+  TS_ASSERT_EQUALS(numBathTris, io.m_bathymetry->NumTriangles());
+  if (!io.m_outTin || !io.m_outSplicedTin)
+    return;
+
+  // kept bathymetry points followed by the stamp points
+  const BSHP<TrTin>& tin(io.m_outSplicedTin);
+  const VecPt3d& pts(tin->Points());
+  const VecInt& tris(tin->Triangles());
+  int numStampPts = io.m_outTin->NumPoints();
+  int numStampTris = io.m_outTin->NumTriangles();
+  int numKeptPts = tin->NumPoints() - numStampPts;
+  TS_ASSERT(numKeptPts > 0 && numKeptPts <= numBathPts);
+  if (numKeptPts <= 0)
+    return;
+  for (int i = 0; i < numStampPts; ++i)
+  {
+    TS_ASSERT_EQUALS(io.m_outTin->Points()[i].x, pts[numKeptPts + i].x);
+    TS_ASSERT_EQUALS(io.m_outTin->Points()[i].y, pts[numKeptPts + i].y);
+  }
+
+  // the bathymetry triangles minus the removed ones keep their order and are
+  // followed by the ring triangles and the stamp triangles
+  const VecPt3d& bathPts(io.m_bathymetry->Points());
+  const VecInt& bathTris(io.m_bathymetry->Triangles());
+  int numKeptTris(0);
+  for (int t = 0; t < numBathTris && numKeptTris < tin->NumTriangles(); ++t)
+  {
+    bool same(true);
+    for (int j = 0; j < 3; ++j)
+    {
+      const Pt3d &p0(bathPts[bathTris[3 * t + j]]), &p1(pts[tris[3 * numKeptTris + j]]);
+      same = same && p0.x == p1.x && p0.y == p1.y;
+    }
+    if (same)
+      ++numKeptTris;
+  }
+  int numRemovedTris = numBathTris - numKeptTris;
+  int numRingTris = tin->NumTriangles() - numKeptTris - numStampTris;
+  TS_ASSERT(numRemovedTris > 0);
+  TS_ASSERT(numRingTris > 0);
+  const VecInt& stampTris(io.m_outTin->Triangles());
+  for (int i = 0; i < 3 * numStampTris && numRingTris >= 0; ++i)
+    TS_ASSERT_EQUALS(stampTris[i] + numKeptPts, tris[3 * (numKeptTris + numRingTris) + i]);
+  // the ring fills the hole without overlaps: the spliced TIN covers the same
+  // area with the same boundary so it has 2 triangles for each added point
+  TS_ASSERT_EQUALS(tin->NumTriangles() - numBathTris, 2 * (tin->NumPoints() - numBathPts));
+
+  // all triangles are valid
+  for (size_t i = 0; i + 2 < tris.size(); i += 3)
+  {
+    const Pt3d &p0(pts[tris[i]]), &p1(pts[tris[i + 1]]), &p2(pts[tris[i + 2]]);
+    TS_ASSERT((p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x) > 0.0);
+  }
+} // XmStampIntermediateTests::test_SpliceIntoBathymetry
+//------------------------------------------------------------------------------
+/// \brief Tests stamping with the bathymetry read from a store.
+//------------------------------------------------------------------------------
+void XmStampIntermediateTests::test_BathymetryStore()
+{
+  std::string path(XMS_TEST_PATH);
+  path += "stamping/test_intersectBathymetry01/";
+  XmStamperIo io;
+  iBuildStamperIo(path, io);
+  TS_ASSERT(io.m_bathymetry);
+  if (!io.m_bathymetry)
+    return;
+  XmStamperIo ioStore(io);
+  BSHP<XmStamper> s = XmStamper::New();
+  s->DoStamp(io);
+
+  std::string fname(XMS_TEST_PATH + std::string("stamping/bathymetryStoreStamp_out.bin"));
+  TS_ASSERT(XmBathymetryStore::WriteStore(fname, io.m_bathymetry, 16));
+  ioStore.m_bathymetry.reset();
+  ioStore.m_bathymetryStore = XmBathymetryStore::New();
+  TS_ASSERT(ioStore.m_bathymetryStore->Open(fname));
+  s = XmStamper::New();
+  s->DoStamp(ioStore);
+
+  // same stamp as with the whole bathymetry TIN
+  TS_ASSERT(io.m_outTin);
+  TS_ASSERT(ioStore.m_outTin);
+  if (!io.m_outTin || !ioStore.m_outTin)
+    return;
+  TS_ASSERT_EQUALS(io.m_outTin->NumPoints(), ioStore.m_outTin->NumPoints());
+  TS_ASSERT_EQUALS(io.m_outTin->NumTriangles(), ioStore.m_outTin->NumTriangles());
+  TS_ASSERT_DELTA_VECPT3D(io.m_outTin->Points(), ioStore.m_outTin->Points(), 1e-6);
+  TS_ASSERT(io.m_outBreakLines == ioStore.m_outBreakLines);
+} // XmStampIntermediateTests::test_BathymetryStore
 #endif
@@ -54,6 +54,16 @@ public:
   void test_Bug12337();
   void test_Bug13552();
   void test_BuildRasterAndGetCellValue();
+  void test_BinaryTin();
+  void test_BinaryStamperIo();
+  void test_CrossSectionLibrary();
+  void test_FlatBreaklines();
+  void test_EndCapChordDeviation();
+  void test_SimplifyCenterLine();
+  void test_EndCapTemplates();
+  void test_StripTriangulation();
+  void test_SpliceIntoBathymetry();
+  void test_BathymetryStore();
 }; // XmStampIntermediateTests
 
 #endif
@@ -9,6 +9,8 @@
 //----- Included files ---------------------------------------------------------
 
 // 3. Standard library headers
+#include <cstddef>
+#include <iterator>
 
 // 4. External library headers
 #include <xmscore/stl/vector.h>
@@ -41,6 +43,18 @@ public:
   VecPt3d2d m_left;     ///< 3d locations of cross section points
   VecPt3d2d m_right;    ///< 3d locations of cross section points
   VecPt3d m_centerLine; ///< only used by guidebank
+
+  /// \brief Gets the total number of points
+  /// \return the number of points in m_left, m_right and m_centerLine
+  size_t NumPoints() const
+  {
+    size_t num = m_centerLine.size();
+    for (const auto& v : m_left)
+      num += v.size();
+    for (const auto& v : m_right)
+      num += v.size();
+    return num;
+  }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -60,17 +74,130 @@ public:
   stXs3dPts m_first_endcap; ///< 3d locations of first end cap
   stXs3dPts m_last_endcap;  ///< 3d locations of the last end cap
 };
+////////////////////////////////////////////////////////////////////////////////
+/// \class stIdxRange
+/// \brief Consecutive point indexes: m_beg, m_beg + 1 ... m_beg + m_cnt - 1.
+/// Read like a const VecInt.
+class stIdxRange
+{
+public:
+  /// \brief Iterator over the indexes of a stIdxRange
+  class const_iterator
+  {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category; ///< iterator category
+    typedef int value_type;                                    ///< value type
+    typedef std::ptrdiff_t difference_type;                    ///< difference type
+    typedef const int* pointer;                                ///< pointer type
+    typedef int reference;                                     ///< dereferenced type
+
+    /// \brief Constructor
+    /// \param[in] a_idx The index the iterator is at
+    explicit const_iterator(int a_idx = 0)
+    : m_idx(a_idx)
+    {
+    }
+    /// \return The index
+    int operator*() const { return m_idx; }
+    /// \return The iterator moved to the next index
+    const_iterator& operator++()
+    {
+      ++m_idx;
+      return *this;
+    }
+    /// \return The iterator before it is moved to the next index
+    const_iterator operator++(int) { return const_iterator(m_idx++); }
+    /// \return The iterator moved to the previous index
+    const_iterator& operator--()
+    {
+      --m_idx;
+      return *this;
+    }
+    /// \return The iterator before it is moved to the previous index
+    const_iterator operator--(int) { return const_iterator(m_idx--); }
+    /// \param[in] a_rhs The other iterator
+    /// \return true if both are at the same index
+    bool operator==(const const_iterator& a_rhs) const { return m_idx == a_rhs.m_idx; }
+    /// \param[in] a_rhs The other iterator
+    /// \return true if the iterators are at different indexes
+    bool operator!=(const const_iterator& a_rhs) const { return m_idx != a_rhs.m_idx; }
+
+  private:
+    int m_idx; ///< the index the iterator is at
+  };
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator; ///< reverse iterator
+
+  /// \brief Constructor
+  /// \param[in] a_beg The first index
+  /// \param[in] a_cnt The number of indexes
+  stIdxRange(int a_beg = 0, int a_cnt = 0)
+  : m_beg(a_beg)
+  , m_cnt(a_cnt)
+  {
+  }
+
+  /// \return The number of indexes
+  size_t size() const { return (size_t)m_cnt; }
+  /// \return true if there are no indexes
+  bool empty() const { return m_cnt == 0; }
+  /// \param[in] a_i Position in the range
+  /// \return The index at a_i
+  int operator[](size_t a_i) const { return m_beg + (int)a_i; }
+  /// \return The first index
+  int front() const { return m_beg; }
+  /// \return The last index
+  int back() const { return m_beg + m_cnt - 1; }
+  /// \return Iterator at the first index
+  const_iterator begin() const { return const_iterator(m_beg); }
+  /// \return Iterator past the last index
+  const_iterator end() const { return const_iterator(m_beg + m_cnt); }
+  /// \return Reverse iterator at the last index
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  /// \return Reverse iterator before the first index
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  int m_beg; ///< first index
+  int m_cnt; ///< number of indexes
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class stIdxRows
+/// \brief The point indexes of one side of a group of cross sections. The
+/// points of each cross section are consecutive in the stamp point array so
+/// only offsets are kept (CSR): cross section i has the indexes m_offsets[i]
+/// up to m_offsets[i + 1].
+class stIdxRows
+{
+public:
+  /// \return The number of cross sections
+  size_t size() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+  /// \return true if there are no cross sections
+  bool empty() const { return size() == 0; }
+  /// \param[in] a_i The cross section
+  /// \return The point indexes of cross section a_i
+  stIdxRange operator[](size_t a_i) const
+  {
+    return stIdxRange(m_offsets[a_i], m_offsets[a_i + 1] - m_offsets[a_i]);
+  }
+  /// \return The point indexes of the first cross section
+  stIdxRange front() const { return (*this)[0]; }
+  /// \return The point indexes of the last cross section
+  stIdxRange back() const { return (*this)[size() - 1]; }
+
+  VecInt m_offsets; ///< offset of each cross section and the end offset
+};
+
 /// helper struct to store point indexes
 struct csPtIdx
 {
-  VecInt2d m_left;     ///< indexes of cross section points
-  VecInt2d m_right;    ///< indexes of cross section points
-  VecInt m_centerLine; ///< used by guidebank
+  stIdxRows m_left;        ///< indexes of cross section points
+  stIdxRows m_right;       ///< indexes of cross section points
+  stIdxRange m_centerLine; ///< used by guidebank
 };
 /// helper struct to store point indexes
 struct cs3dPtIdx
 {
-  VecInt m_centerLine;     ///< indexes of cross section points
+  stIdxRange m_centerLine; ///< indexes of cross section points
   csPtIdx m_xsPts;         ///< helper struct to store point indexes
   csPtIdx m_first_end_cap; ///< helper struct to store point indexes
   csPtIdx m_last_end_cap;  ///< helper struct to store point indexes
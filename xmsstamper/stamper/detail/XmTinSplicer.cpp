@@ -0,0 +1,647 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup stamping
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsstamper/stamper/detail/XmTinSplicer.h>
+
+// 3. Standard library headers
+#include <unordered_set>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/XmConst.h>
+#include <xmscore/misc/XmError.h>
+#include <xmsgrid/geometry/geoms.h>
+#include <xmsgrid/geometry/GmTriSearch.h>
+#include <xmsgrid/triangulate/TrBreaklineAdder.h>
+#include <xmsgrid/triangulate/TrTin.h>
+#include <xmsgrid/triangulate/TrTriangulatorPoints.h>
+#include <xmsstamper/stamper/detail/XmUtil.h>
+
+// 6. Non-shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Classes / Structs ------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Implementaion of XmTinSplicer
+class XmTinSplicerImpl : public XmTinSplicer
+{
+public:
+  XmTinSplicerImpl();
+  ~XmTinSplicerImpl();
+
+  virtual BSHP<TrTin> Splice(BSHP<TrTin> a_bathymetry,
+                             BSHP<TrTin> a_stamp,
+                             const VecInt2d& a_outerPolys,
+                             int a_stampingType) override;
+
+  bool FindTouchedTriangles();
+  bool ClampStampElevations();
+  bool TriangulateRing();
+  BSHP<TrTin> BuildOutput();
+
+  BSHP<TrTin> m_bathymetry;      ///< TIN of the bathymetry
+  BSHP<TrTin> m_stamp;           ///< TIN of the stamp
+  VecInt2d m_polyIdxs;           ///< stamp point indexes of each outer polygon (closed)
+  VecPt3d2d m_polys;             ///< locations of each outer polygon
+  int m_stampingType;            ///< 0 - cut, 1 - fill, 2 - both
+  std::vector<char> m_removed;   ///< 1 for bathymetry triangles replaced by the stamp
+  std::vector<char> m_usedByRemoved; ///< 1 for bathymetry points of removed triangles
+  std::vector<char> m_dropPt;    ///< 1 for bathymetry points inside the stamp
+  VecInt m_cavityEdges;          ///< edges around the removed triangles (point pairs)
+  VecPt3d m_stampPts;            ///< stamp points limited by the stamping type
+  VecInt m_ringTris;             ///< triangles between the bathymetry and the stamp
+};
+
+//----- Internal functions -----------------------------------------------------
+namespace
+{
+//------------------------------------------------------------------------------
+/// \brief Finds the location of a point relative to a polygon.
+/// \param[in] a_poly The polygon (closed)
+/// \param[in] a_pt The point
+/// \return 1 (inside), 0 (on) or -1 (outside).
+//------------------------------------------------------------------------------
+int iPointInPolygon(const VecPt3d& a_poly, const Pt3d& a_pt)
+{
+  bool inside(false);
+  for (size_t i = 1; i < a_poly.size(); ++i)
+  {
+    const Pt3d &p0(a_poly[i - 1]), &p1(a_poly[i]);
+    // a_pt touches the edge
+    if (XmUtil::SegmentsCross(p0, p1, a_pt, a_pt, true))
+      return 0;
+    if ((p0.y > a_pt.y) != (p1.y > a_pt.y) &&
+        a_pt.x < p0.x + (a_pt.y - p0.y) * (p1.x - p0.x) / (p1.y - p0.y))
+      inside = !inside;
+  }
+  return inside ? 1 : -1;
+} // iPointInPolygon
+//------------------------------------------------------------------------------
+/// \brief Checks if a triangle overlaps or touches a polygon.
+/// \param[in] a_tri The 3 triangle points
+/// \param[in] a_poly The polygon (closed)
+/// \return true if they share any area or point.
+//------------------------------------------------------------------------------
+bool iTriangleTouchesPolygon(const Pt3d* a_tri[3], const VecPt3d& a_poly)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    if (iPointInPolygon(a_poly, *a_tri[i]) >= 0)
+      return true;
+  }
+  double area = XmUtil::Cross(*a_tri[0], *a_tri[1], *a_tri[2]);
+  for (size_t i = 1; i < a_poly.size(); ++i)
+  {
+    const Pt3d& p(a_poly[i]);
+    double c0 = XmUtil::Cross(*a_tri[0], *a_tri[1], p);
+    double c1 = XmUtil::Cross(*a_tri[1], *a_tri[2], p);
+    double c2 = XmUtil::Cross(*a_tri[2], *a_tri[0], p);
+    if (area > 0 ? (c0 >= 0 && c1 >= 0 && c2 >= 0) : (c0 <= 0 && c1 <= 0 && c2 <= 0))
+      return true;
+    for (int e = 0; e < 3; ++e)
+    {
+      if (XmUtil::SegmentsCross(*a_tri[e], *a_tri[(e + 1) % 3], a_poly[i - 1], p, true))
+        return true;
+    }
+  }
+  return false;
+} // iTriangleTouchesPolygon
+//------------------------------------------------------------------------------
+/// \brief Makes a key for a directed edge.
+/// \param[in] a_from Index of the start point
+/// \param[in] a_to Index of the end point
+/// \return The key.
+//------------------------------------------------------------------------------
+uint64_t iEdgeKey(int a_from, int a_to)
+{
+  return ((uint64_t)(uint32_t)a_from << 32) | (uint64_t)(uint32_t)a_to;
+} // iEdgeKey
+
+} // unnamed namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmTinSplicerImpl
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Constructor
+//------------------------------------------------------------------------------
+XmTinSplicerImpl::XmTinSplicerImpl()
+: m_stampingType(2)
+{
+} // XmTinSplicerImpl::XmTinSplicerImpl
+//------------------------------------------------------------------------------
+/// \brief Destructor
+//------------------------------------------------------------------------------
+XmTinSplicerImpl::~XmTinSplicerImpl()
+{
+} // XmTinSplicerImpl::~XmTinSplicerImpl
+//------------------------------------------------------------------------------
+/// \brief Splices a stamp into a bathymetry TIN. Bathymetry triangles that
+/// touch the outer polygons of the stamp are removed, the gap between the
+/// remaining bathymetry triangles and the outer polygons is triangulated and
+/// the stamp triangles are added. The rest of the bathymetry is not changed.
+/// Stamp elevations are limited by the stamping type the same way the
+/// bathymetry intersector classifies points: a cut does not raise the
+/// bathymetry and a fill does not lower it.
+/// \param[in] a_bathymetry The bathymetry TIN (counter clockwise triangles)
+/// \param[in] a_stamp The stamp TIN
+/// \param[in] a_outerPolys Stamp point indexes of the outer polygon of each
+/// piece of the stamp (closed)
+/// \param[in] a_stampingType 0 - cut, 1 - fill, 2 - both
+/// \return The new TIN. Null if the stamp could not be spliced.
+//------------------------------------------------------------------------------
+BSHP<TrTin> XmTinSplicerImpl::Splice(BSHP<TrTin> a_bathymetry,
+                                     BSHP<TrTin> a_stamp,
+                                     const VecInt2d& a_outerPolys,
+                                     int a_stampingType)
+{
+  BSHP<TrTin> tin;
+  XM_ENSURE_TRUE(a_bathymetry && a_stamp && !a_outerPolys.empty(), tin);
+  m_bathymetry = a_bathymetry;
+  m_stamp = a_stamp;
+  m_stampingType = a_stampingType;
+  m_polyIdxs.clear();
+  m_polys.clear();
+  const VecPt3d& stampPts(m_stamp->Points());
+  for (const auto& poly : a_outerPolys)
+  {
+    if (poly.size() < 4)
+      continue;
+    m_polyIdxs.push_back(poly);
+    m_polys.push_back(VecPt3d());
+    for (auto idx : poly)
+      m_polys.back().push_back(stampPts[idx]);
+  }
+  XM_ENSURE_TRUE(!m_polys.empty(), tin);
+
+  if (!FindTouchedTriangles() || !ClampStampElevations() || !TriangulateRing())
+  {
+    XM_LOG(xmlog::warning, "Unable to splice the stamp into the bathymetry.");
+    return tin;
+  }
+  return BuildOutput();
+} // XmTinSplicerImpl::Splice
+//------------------------------------------------------------------------------
+/// \brief Finds the bathymetry triangles that touch the stamp, the bathymetry
+/// points inside the stamp and the edges around the removed triangles.
+/// \return false if no triangles touch the stamp or the stamp crosses the
+/// boundary of the bathymetry.
+//------------------------------------------------------------------------------
+bool XmTinSplicerImpl::FindTouchedTriangles()
+{
+  const VecPt3d& pts(m_bathymetry->Points());
+  const VecInt& tris(m_bathymetry->Triangles());
+  size_t nTris = tris.size() / 3;
+  m_removed.assign(nTris, 0);
+  m_usedByRemoved.assign(pts.size(), 0);
+  m_dropPt.assign(pts.size(), 0);
+  m_cavityEdges.clear();
+
+  VecPt3d polyMin(m_polys.size()), polyMax(m_polys.size());
+  for (size_t i = 0; i < m_polys.size(); ++i)
+  {
+    polyMin[i] = Pt3d(XM_DBL_HIGHEST);
+    polyMax[i] = Pt3d(XM_DBL_LOWEST);
+    for (const auto& p : m_polys[i])
+      gmAddToExtents(p, polyMin[i], polyMax[i]);
+  }
+
+  size_t numRemoved(0);
+  for (size_t t = 0; t < nTris; ++t)
+  {
+    const Pt3d* tri[3] = {&pts[tris[3 * t]], &pts[tris[3 * t + 1]], &pts[tris[3 * t + 2]]};
+    Pt3d tMin(XM_DBL_HIGHEST), tMax(XM_DBL_LOWEST);
+    for (int j = 0; j < 3; ++j)
+      gmAddToExtents(*tri[j], tMin, tMax);
+    for (size_t i = 0; i < m_polys.size() && !m_removed[t]; ++i)
+    {
+      if (tMax.x < polyMin[i].x || tMin.x > polyMax[i].x || tMax.y < polyMin[i].y ||
+          tMin.y > polyMax[i].y)
+        continue;
+      if (iTriangleTouchesPolygon(tri, m_polys[i]))
+      {
+        m_removed[t] = 1;
+        ++numRemoved;
+        for (int j = 0; j < 3; ++j)
+          m_usedByRemoved[tris[3 * t + j]] = 1;
+      }
+    }
+  }
+  if (numRemoved == 0)
+    return false;
+
+  // points of kept triangles are outside the stamp so only points that are
+  // just in removed triangles are checked
+  for (size_t t = 0; t < nTris; ++t)
+  {
+    if (!m_removed[t])
+    {
+      for (int j = 0; j < 3; ++j)
+        m_usedByRemoved[tris[3 * t + j]] = 0;
+    }
+  }
+  for (size_t p = 0; p < pts.size(); ++p)
+  {
+    for (size_t i = 0; m_usedByRemoved[p] && i < m_polys.size() && !m_dropPt[p]; ++i)
+      m_dropPt[p] = iPointInPolygon(m_polys[i], pts[p]) >= 0;
+  }
+  // m_usedByRemoved now holds all points of the removed triangles
+  for (size_t t = 0; t < nTris; ++t)
+  {
+    if (m_removed[t])
+    {
+      for (int j = 0; j < 3; ++j)
+        m_usedByRemoved[tris[3 * t + j]] = 1;
+    }
+  }
+
+  // the removed triangles are on the left of the edges around them
+  std::unordered_set<uint64_t> edges, removedEdges;
+  edges.reserve(tris.size());
+  for (size_t t = 0; t < nTris; ++t)
+  {
+    for (int e = 0; e < 3; ++e)
+    {
+      uint64_t key = iEdgeKey(tris[3 * t + e], tris[3 * t + (e + 1) % 3]);
+      edges.insert(key);
+      if (m_removed[t])
+        removedEdges.insert(key);
+    }
+  }
+  for (size_t t = 0; t < nTris; ++t)
+  {
+    if (!m_removed[t])
+      continue;
+    for (int e = 0; e < 3; ++e)
+    {
+      int p0 = tris[3 * t + e], p1 = tris[3 * t + (e + 1) % 3];
+      if (removedEdges.find(iEdgeKey(p1, p0)) != removedEdges.end())
+        continue;
+      if (edges.find(iEdgeKey(p1, p0)) == edges.end())
+      {
+        // the edge is on the boundary of the bathymetry
+        for (const auto& poly : m_polys)
+        {
+          for (size_t i = 1; i < poly.size(); ++i)
+          {
+            if (XmUtil::SegmentsCross(pts[p0], pts[p1], poly[i - 1], poly[i], true))
+              return false;
+          }
+        }
+      }
+      m_cavityEdges.push_back(p0);
+      m_cavityEdges.push_back(p1);
+    }
+  }
+  return true;
+} // XmTinSplicerImpl::FindTouchedTriangles
+//------------------------------------------------------------------------------
+/// \brief Copies the stamp points and limits their elevations by the stamping
+/// type. Points above the bathymetry are lowered to it for a cut and points
+/// below it are raised to it for a fill.
+/// \return false if a stamp point is outside the removed triangles.
+//------------------------------------------------------------------------------
+bool XmTinSplicerImpl::ClampStampElevations()
+{
+  const VecPt3d& pts(m_bathymetry->Points());
+  const VecInt& tris(m_bathymetry->Triangles());
+  BSHP<VecInt> removedTris(new VecInt());
+  for (size_t t = 0; t < m_removed.size(); ++t)
+  {
+    if (m_removed[t])
+      removedTris->insert(removedTris->end(), &tris[3 * t], &tris[3 * t] + 3);
+  }
+  BSHP<GmTriSearch> search = GmTriSearch::New();
+  search->TrisToSearch(m_bathymetry->PointsPtr(), removedTris);
+
+  m_stampPts = m_stamp->Points();
+  VecInt idxs;
+  VecDbl wts;
+  for (auto& p : m_stampPts)
+  {
+    if (!search->InterpWeights(p, idxs, wts))
+      return false;
+    double z(0.0);
+    for (size_t i = 0; i < idxs.size(); ++i)
+      z += wts[i] * pts[idxs[i]].z;
+    if (m_stampingType == 0 && p.z > z)
+      p.z = z;
+    else if (m_stampingType == 1 && p.z < z)
+      p.z = z;
+  }
+  return true;
+} // XmTinSplicerImpl::ClampStampElevations
+//------------------------------------------------------------------------------
+/// \brief Triangulates the area between the edges around the removed
+/// triangles and the outer polygons of the stamp. Only the points of the
+/// removed triangles and of the outer polygons are triangulated.
+/// \return false if the edges could not be added to the triangulation.
+//------------------------------------------------------------------------------
+bool XmTinSplicerImpl::TriangulateRing()
+{
+  const VecPt3d& pts(m_bathymetry->Points());
+  int nPts = (int)pts.size();
+  VecPt3d localPts;
+  VecInt localToGlobal, globalToLocal(nPts + m_stampPts.size(), -1);
+  for (int i = 0; i < nPts; ++i)
+  {
+    if (m_usedByRemoved[i] && !m_dropPt[i])
+    {
+      globalToLocal[i] = (int)localPts.size();
+      localToGlobal.push_back(i);
+      localPts.push_back(pts[i]);
+    }
+  }
+  for (const auto& poly : m_polyIdxs)
+  {
+    for (auto idx : poly)
+    {
+      int g = nPts + idx;
+      if (globalToLocal[g] < 0)
+      {
+        globalToLocal[g] = (int)localPts.size();
+        localToGlobal.push_back(g);
+        localPts.push_back(m_stampPts[idx]);
+      }
+    }
+  }
+
+  BSHP<TrTin> ring = TrTin::New();
+  ring->SetPoints(localPts);
+  TrTriangulatorPoints client(ring->Points(), ring->Triangles(), &ring->TrisAdjToPts());
+  if (!client.Triangulate() || ring->NumTriangles() < 1)
+    return false;
+
+  // the ring is on the left of the edges around the removed triangles and on
+  // the outside of the stamp polygons
+  VecInt2d breaklines;
+  VecInt edges;
+  for (size_t i = 0; i + 1 < m_cavityEdges.size(); i += 2)
+  {
+    int p0 = globalToLocal[m_cavityEdges[i]], p1 = globalToLocal[m_cavityEdges[i + 1]];
+    breaklines.push_back({p0, p1});
+    edges.push_back(p0);
+    edges.push_back(p1);
+  }
+  for (size_t k = 0; k < m_polyIdxs.size(); ++k)
+  {
+    const VecPt3d& poly(m_polys[k]);
+    double area(0.0);
+    for (size_t i = 1; i < poly.size(); ++i)
+      area += poly[i - 1].x * poly[i].y - poly[i].x * poly[i - 1].y;
+    VecInt bl;
+    for (auto idx : m_polyIdxs[k])
+      bl.push_back(globalToLocal[nPts + idx]);
+    for (size_t i = 1; i < bl.size(); ++i)
+    {
+      edges.push_back(area > 0.0 ? bl[i] : bl[i - 1]);
+      edges.push_back(area > 0.0 ? bl[i - 1] : bl[i]);
+    }
+    breaklines.push_back(bl);
+  }
+  BSHP<TrBreaklineAdder> adder = TrBreaklineAdder::New();
+  adder->SetTin(ring);
+  adder->AddBreaklines(breaklines);
+
+  SetInt outside;
+  if (!XmUtil::FloodFillOutsideEdges(ring->Triangles(), edges, outside))
+    return false;
+  m_ringTris.clear();
+  const VecInt& ringTris(ring->Triangles());
+  auto it = outside.begin();
+  for (int t = 0; t < ring->NumTriangles(); ++t)
+  {
+    if (it != outside.end() && *it == t)
+    {
+      ++it;
+      continue;
+    }
+    for (int j = 0; j < 3; ++j)
+      m_ringTris.push_back(localToGlobal[ringTris[3 * t + j]]);
+  }
+  return true;
+} // XmTinSplicerImpl::TriangulateRing
+//------------------------------------------------------------------------------
+/// \brief Creates the TIN from the kept bathymetry triangles, the ring
+/// triangles and the stamp triangles.
+/// \return The TIN.
+//------------------------------------------------------------------------------
+BSHP<TrTin> XmTinSplicerImpl::BuildOutput()
+{
+  const VecPt3d& pts(m_bathymetry->Points());
+  const VecInt& tris(m_bathymetry->Triangles());
+  int nPts = (int)pts.size();
+  VecInt globalToOut(nPts + m_stampPts.size(), -1);
+  BSHP<TrTin> tin = TrTin::New();
+  VecPt3d outPts;
+  outPts.reserve(pts.size() + m_stampPts.size());
+  for (int i = 0; i < nPts; ++i)
+  {
+    if (!m_dropPt[i])
+    {
+      globalToOut[i] = (int)outPts.size();
+      outPts.push_back(pts[i]);
+    }
+  }
+  for (size_t i = 0; i < m_stampPts.size(); ++i)
+  {
+    globalToOut[nPts + i] = (int)outPts.size();
+    outPts.push_back(m_stampPts[i]);
+  }
+  tin->SetPoints(outPts);
+
+  VecInt& outTris(tin->Triangles());
+  const VecInt& stampTris(m_stamp->Triangles());
+  outTris.reserve(tris.size() + m_ringTris.size() + stampTris.size());
+  for (size_t t = 0; t < m_removed.size(); ++t)
+  {
+    if (m_removed[t])
+      continue;
+    for (int j = 0; j < 3; ++j)
+      outTris.push_back(globalToOut[tris[3 * t + j]]);
+  }
+  for (auto idx : m_ringTris)
+    outTris.push_back(globalToOut[idx]);
+  for (auto idx : stampTris)
+    outTris.push_back(globalToOut[nPts + idx]);
+  tin->BuildTrisAdjToPts();
+  return tin;
+} // XmTinSplicerImpl::BuildOutput
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmTinSplicer
+/// \brief Splices a stamp TIN into a bathymetry TIN
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Creates a XmTinSplicer class
+/// \return Shared ptr to a XmTinSplicer
+//------------------------------------------------------------------------------
+BSHP<XmTinSplicer> XmTinSplicer::New()
+{
+  BSHP<XmTinSplicer> p(new XmTinSplicerImpl());
+  return p;
+} // XmTinSplicer::New
+//------------------------------------------------------------------------------
+/// \brief
+//------------------------------------------------------------------------------
+XmTinSplicer::XmTinSplicer()
+{
+} // XmTinSplicer::XmTinSplicer
+//------------------------------------------------------------------------------
+/// \brief
+//------------------------------------------------------------------------------
+XmTinSplicer::~XmTinSplicer()
+{
+} // XmTinSplicer::~XmTinSplicer
+
+} // namespace xms
+
+#ifdef CXX_TEST
+//------------------------------------------------------------------------------
+// Unit Tests
+//------------------------------------------------------------------------------
+using namespace xms;
+#include <xmsstamper/stamper/detail/XmTinSplicer.t.h>
+
+#include <xmscore/testing/TestTools.h>
+
+namespace
+{
+//------------------------------------------------------------------------------
+/// \brief Builds a flat 40 x 40 TIN with 10 x 10 cells split in 2 triangles.
+/// \return The TIN.
+//------------------------------------------------------------------------------
+BSHP<TrTin> iBuildGridTin()
+{
+  BSHP<TrTin> tin = TrTin::New();
+  VecPt3d& pts(tin->Points());
+  for (int j = 0; j < 5; ++j)
+  {
+    for (int i = 0; i < 5; ++i)
+      pts.push_back(Pt3d(10.0 * i, 10.0 * j, 0.0));
+  }
+  VecInt& tris(tin->Triangles());
+  for (int j = 0; j < 4; ++j)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      int p0 = 5 * j + i, p1 = p0 + 1, p2 = p1 + 5, p3 = p0 + 5;
+      tris.insert(tris.end(), {p0, p1, p2, p0, p2, p3});
+    }
+  }
+  tin->BuildTrisAdjToPts();
+  return tin;
+} // iBuildGridTin
+//------------------------------------------------------------------------------
+/// \brief Builds a square stamp TIN from 12 to 28 with a center point.
+/// \param[in] a_z Elevation of the stamp points
+/// \return The TIN.
+//------------------------------------------------------------------------------
+BSHP<TrTin> iBuildSquareStamp(double a_z)
+{
+  BSHP<TrTin> tin = TrTin::New();
+  tin->Points() = {{12, 12, a_z}, {28, 12, a_z}, {28, 28, a_z}, {12, 28, a_z}, {20, 20, a_z}};
+  tin->Triangles() = {0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
+  tin->BuildTrisAdjToPts();
+  return tin;
+} // iBuildSquareStamp
+//------------------------------------------------------------------------------
+/// \brief Gets the area of a TIN and checks that all triangles are counter
+/// clockwise.
+/// \param[in] a_tin The TIN
+/// \return The area.
+//------------------------------------------------------------------------------
+double iTinArea(const BSHP<TrTin>& a_tin)
+{
+  double area(0.0);
+  const VecPt3d& pts(a_tin->Points());
+  const VecInt& tris(a_tin->Triangles());
+  for (size_t i = 0; i + 2 < tris.size(); i += 3)
+  {
+    double a = XmUtil::Cross(pts[tris[i]], pts[tris[i + 1]], pts[tris[i + 2]]);
+    TS_ASSERT(a > 0.0);
+    area += a / 2;
+  }
+  return area;
+} // iTinArea
+
+} // unnamed namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmTinSplicerUnitTests
+/// \brief Tests XmTinSplicer
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Tests splicing a stamp into the middle of a TIN
+//------------------------------------------------------------------------------
+void XmTinSplicerUnitTests::testSplice()
+{
+  BSHP<TrTin> bathymetry = iBuildGridTin(), stamp = iBuildSquareStamp(-5.0);
+  VecInt2d polys(1, {0, 1, 2, 3, 0});
+  BSHP<XmTinSplicer> splicer = XmTinSplicer::New();
+  BSHP<TrTin> tin = splicer->Splice(bathymetry, stamp, polys, 0);
+  TS_ASSERT(tin);
+  if (!tin)
+    return;
+  // the grid point at the center of the stamp is removed
+  TS_ASSERT_EQUALS(29, tin->NumPoints());
+  // 24 bathymetry, 12 ring and 4 stamp triangles
+  TS_ASSERT_EQUALS(40, tin->NumTriangles());
+  TS_ASSERT_DELTA(1600.0, iTinArea(tin), 1e-9);
+  TS_ASSERT_EQUALS(tin->Points().size(), tin->TrisAdjToPts().size());
+  // a cut below the bathymetry keeps its elevations
+  for (int i = 24; i < 29; ++i)
+    TS_ASSERT_EQUALS(-5.0, tin->Points()[i].z);
+  // the bathymetry is not changed
+  TS_ASSERT_EQUALS(25, bathymetry->NumPoints());
+  TS_ASSERT_EQUALS(32, bathymetry->NumTriangles());
+
+  // a fill below the bathymetry is raised to it
+  tin = splicer->Splice(bathymetry, stamp, polys, 1);
+  TS_ASSERT(tin);
+  if (!tin)
+    return;
+  TS_ASSERT_EQUALS(40, tin->NumTriangles());
+  for (int i = 24; i < 29; ++i)
+    TS_ASSERT_DELTA(0.0, tin->Points()[i].z, 1e-9);
+} // XmTinSplicerUnitTests::testSplice
+//------------------------------------------------------------------------------
+/// \brief Tests a stamp that crosses the boundary of the TIN
+//------------------------------------------------------------------------------
+void XmTinSplicerUnitTests::testSpliceOutside()
+{
+  BSHP<TrTin> bathymetry = iBuildGridTin(), stamp = iBuildSquareStamp(-5.0);
+  for (auto& p : stamp->Points())
+    p.x += 20.0;
+  VecInt2d polys(1, {0, 1, 2, 3, 0});
+  BSHP<TrTin> tin = XmTinSplicer::New()->Splice(bathymetry, stamp, polys, 2);
+  TS_ASSERT(!tin);
+
+  // no overlap
+  for (auto& p : stamp->Points())
+    p.x += 100.0;
+  tin = XmTinSplicer::New()->Splice(bathymetry, stamp, polys, 2);
+  TS_ASSERT(!tin);
+} // XmTinSplicerUnitTests::testSpliceOutside
+
+#endif
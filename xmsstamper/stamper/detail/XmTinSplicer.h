@@ -0,0 +1,56 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup stamping
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+
+// 4. External library headers
+#include <xmscore/misc/boost_defines.h>
+#include <xmscore/misc/base_macros.h> // for XM_DISALLOW_COPY_AND_ASSIGN
+#include <xmscore/stl/vector.h>
+
+// 5. Shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Structs / Classes ------------------------------------------------------
+class TrTin;
+
+//----- Function prototypes ----------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmTinSplicer
+/// \brief Splices the TIN of a feature stamp into a bathymetry TIN. Only the
+/// bathymetry triangles that touch the stamp are replaced.
+class XmTinSplicer
+{
+public:
+  static BSHP<XmTinSplicer> New();
+
+  XmTinSplicer();
+  virtual ~XmTinSplicer();
+
+  /// \cond
+  virtual BSHP<TrTin> Splice(BSHP<TrTin> a_bathymetry,
+                             BSHP<TrTin> a_stamp,
+                             const VecInt2d& a_outerPolys,
+                             int a_stampingType) = 0;
+
+private:
+  XM_DISALLOW_COPY_AND_ASSIGN(XmTinSplicer);
+  /// \endcond
+}; // XmTinSplicer
+
+} // namespace xms
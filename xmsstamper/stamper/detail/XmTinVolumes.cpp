@@ -0,0 +1,354 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup stamping
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsstamper/stamper/detail/XmTinVolumes.h>
+
+// 3. Standard library headers
+#include <algorithm>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/XmConst.h>
+#include <xmscore/misc/XmError.h>
+#include <xmsgrid/geometry/geoms.h>
+#include <xmsgrid/triangulate/TrTin.h>
+#include <xmsstamper/stamper/detail/XmUtil.h>
+
+// 6. Non-shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+/// Minimum number of stamp triangles processed by each thread.
+const size_t MIN_TRIS_PER_THREAD = 64;
+
+//----- Classes / Structs ------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Implementaion of XmTinVolumes
+class XmTinVolumesImpl : public XmTinVolumes
+{
+public:
+  explicit XmTinVolumesImpl(BSHP<TrTin> a_bathymetry);
+  ~XmTinVolumesImpl();
+
+  virtual bool Compute(BSHP<TrTin> a_stamp, double& a_cutVolume, double& a_fillVolume) override;
+
+  BSHP<TrTin> m_bathymetry; ///< TIN of the bathymetry
+  XmTriGrid m_grid;         ///< bathymetry triangles binned in a grid
+};
+
+//----- Internal functions -----------------------------------------------------
+namespace
+{
+//------------------------------------------------------------------------------
+/// \brief Gets the plane z = a x + b y + c through a triangle.
+/// \param[in] a_p0 First point
+/// \param[in] a_p1 Second point
+/// \param[in] a_p2 Third point
+/// \param[out] a_plane The a, b and c coefficients
+/// \return false if the triangle has no area.
+//------------------------------------------------------------------------------
+bool iPlane(const Pt3d& a_p0, const Pt3d& a_p1, const Pt3d& a_p2, double a_plane[3])
+{
+  double det = XmUtil::Cross(a_p0, a_p1, a_p2);
+  if (det == 0.0)
+    return false;
+  double dx1(a_p1.x - a_p0.x), dy1(a_p1.y - a_p0.y), dz1(a_p1.z - a_p0.z);
+  double dx2(a_p2.x - a_p0.x), dy2(a_p2.y - a_p0.y), dz2(a_p2.z - a_p0.z);
+  a_plane[0] = (dz1 * dy2 - dz2 * dy1) / det;
+  a_plane[1] = (dx1 * dz2 - dx2 * dz1) / det;
+  a_plane[2] = a_p0.z - a_plane[0] * a_p0.x - a_plane[1] * a_p0.y;
+  return true;
+} // iPlane
+//------------------------------------------------------------------------------
+/// \brief Clips a convex polygon to the left side of a directed line.
+/// \param[in] a_poly The polygon (open, counter clockwise)
+/// \param[in] a_p0 Line start
+/// \param[in] a_p1 Line end
+/// \param[out] a_out The clipped polygon
+//------------------------------------------------------------------------------
+void iClipToLeft(const VecPt3d& a_poly, const Pt3d& a_p0, const Pt3d& a_p1, VecPt3d& a_out)
+{
+  a_out.clear();
+  size_t n = a_poly.size();
+  for (size_t i = 0; i < n; ++i)
+  {
+    const Pt3d &cur(a_poly[i]), &next(a_poly[(i + 1) % n]);
+    double dCur = XmUtil::Cross(a_p0, a_p1, cur), dNext = XmUtil::Cross(a_p0, a_p1, next);
+    if (dCur >= 0.0)
+      a_out.push_back(cur);
+    if ((dCur > 0.0 && dNext < 0.0) || (dCur < 0.0 && dNext > 0.0))
+    {
+      double t = dCur / (dCur - dNext);
+      a_out.push_back(Pt3d(cur.x + t * (next.x - cur.x), cur.y + t * (next.y - cur.y), 0.0));
+    }
+  }
+} // iClipToLeft
+//------------------------------------------------------------------------------
+/// \brief Integrates the positive and negative parts of a linear function
+/// over a convex polygon.
+/// \param[in] a_poly The polygon (open, counter clockwise). The z values are
+/// the function values.
+/// \param[in,out] a_positive The integral of the positive part is added
+/// \param[in,out] a_negative The integral of minus the negative part is added
+//------------------------------------------------------------------------------
+void iIntegrateParts(const VecPt3d& a_poly, double& a_positive, double& a_negative)
+{
+  // split the polygon where the function is zero
+  VecPt3d pos, neg;
+  size_t n = a_poly.size();
+  for (size_t i = 0; i < n; ++i)
+  {
+    const Pt3d &cur(a_poly[i]), &next(a_poly[(i + 1) % n]);
+    if (cur.z >= 0.0)
+      pos.push_back(cur);
+    if (cur.z <= 0.0)
+      neg.push_back(cur);
+    if ((cur.z > 0.0 && next.z < 0.0) || (cur.z < 0.0 && next.z > 0.0))
+    {
+      double t = cur.z / (cur.z - next.z);
+      Pt3d p(cur.x + t * (next.x - cur.x), cur.y + t * (next.y - cur.y), 0.0);
+      pos.push_back(p);
+      neg.push_back(p);
+    }
+  }
+  // fan triangles: area times the average of the linear function
+  auto integrate = [](const VecPt3d& a_pts) {
+    double sum(0.0);
+    for (size_t i = 1; i + 1 < a_pts.size(); ++i)
+    {
+      double area = XmUtil::Cross(a_pts[0], a_pts[i], a_pts[i + 1]) / 2;
+      sum += area * (a_pts[0].z + a_pts[i].z + a_pts[i + 1].z) / 3;
+    }
+    return sum;
+  };
+  a_positive += integrate(pos);
+  a_negative -= integrate(neg);
+} // iIntegrateParts
+
+} // unnamed namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmTinVolumesImpl
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Constructor. Indexes the bathymetry triangles.
+/// \param[in] a_bathymetry The bathymetry TIN
+//------------------------------------------------------------------------------
+XmTinVolumesImpl::XmTinVolumesImpl(BSHP<TrTin> a_bathymetry)
+: m_bathymetry(a_bathymetry)
+, m_grid()
+{
+  if (m_bathymetry)
+    XmUtil::BinTriangles(m_bathymetry->Points(), m_bathymetry->Triangles(), m_grid);
+} // XmTinVolumesImpl::XmTinVolumesImpl
+//------------------------------------------------------------------------------
+/// \brief Destructor
+//------------------------------------------------------------------------------
+XmTinVolumesImpl::~XmTinVolumesImpl()
+{
+} // XmTinVolumesImpl::~XmTinVolumesImpl
+//------------------------------------------------------------------------------
+/// \brief Computes the cut and fill volumes between a stamp and the
+/// bathymetry where they overlap. Each stamp triangle is clipped by the
+/// bathymetry triangles it overlaps and the difference of the two planes is
+/// integrated over each piece. Stamp triangles are processed in parallel.
+/// \param[in] a_stamp The stamp TIN
+/// \param[out] a_cutVolume Volume where the stamp is below the bathymetry
+/// \param[out] a_fillVolume Volume where the stamp is above the bathymetry
+/// \return false if either TIN is missing.
+//------------------------------------------------------------------------------
+bool XmTinVolumesImpl::Compute(BSHP<TrTin> a_stamp, double& a_cutVolume, double& a_fillVolume)
+{
+  a_cutVolume = a_fillVolume = 0.0;
+  XM_ENSURE_TRUE(m_bathymetry && a_stamp, false);
+  const VecPt3d &stampPts(a_stamp->Points()), &bathPts(m_bathymetry->Points());
+  const VecInt &stampTris(a_stamp->Triangles()), &bathTris(m_bathymetry->Triangles());
+  size_t nTris = stampTris.size() / 3;
+  int nThreads = XmUtil::NumThreads(nTris, MIN_TRIS_PER_THREAD);
+  VecDbl cut(std::max(1, nThreads), 0.0), fill(std::max(1, nThreads), 0.0);
+  XmUtil::ParallelFor(nTris, nThreads, [&](int a_thread, size_t a_begin, size_t a_end) {
+    VecInt candidates;
+    VecPt3d tri(3), poly, clipped;
+    for (size_t t = a_begin; t < a_end; ++t)
+    {
+      for (int j = 0; j < 3; ++j)
+        tri[j] = stampPts[stampTris[3 * t + j]];
+      double stampPlane[3];
+      if (!iPlane(tri[0], tri[1], tri[2], stampPlane))
+        continue;
+      if (XmUtil::Cross(tri[0], tri[1], tri[2]) < 0.0)
+        std::swap(tri[1], tri[2]);
+      Pt3d tMin(XM_DBL_HIGHEST), tMax(XM_DBL_LOWEST);
+      for (const auto& p : tri)
+        gmAddToExtents(p, tMin, tMax);
+      m_grid.FindTriangles(tMin, tMax, candidates);
+      for (auto b : candidates)
+      {
+        const Pt3d* bp[3] = {&bathPts[bathTris[3 * b]], &bathPts[bathTris[3 * b + 1]],
+                             &bathPts[bathTris[3 * b + 2]]};
+        double bathPlane[3];
+        if (!iPlane(*bp[0], *bp[1], *bp[2], bathPlane))
+          continue;
+        if (XmUtil::Cross(*bp[0], *bp[1], *bp[2]) < 0.0)
+          std::swap(bp[1], bp[2]);
+        poly = tri;
+        for (int e = 0; e < 3 && poly.size() > 2; ++e)
+        {
+          iClipToLeft(poly, *bp[e], *bp[(e + 1) % 3], clipped);
+          poly.swap(clipped);
+        }
+        if (poly.size() < 3)
+          continue;
+        for (auto& p : poly)
+        {
+          p.z = (stampPlane[0] - bathPlane[0]) * p.x + (stampPlane[1] - bathPlane[1]) * p.y +
+                (stampPlane[2] - bathPlane[2]);
+        }
+        iIntegrateParts(poly, fill[a_thread], cut[a_thread]);
+      }
+    }
+  });
+  for (size_t i = 0; i < cut.size(); ++i)
+  {
+    a_cutVolume += cut[i];
+    a_fillVolume += fill[i];
+  }
+  return true;
+} // XmTinVolumesImpl::Compute
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmTinVolumes
+/// \brief Computes cut and fill volumes between two TINs
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Creates a XmTinVolumes class
+/// \param[in] a_bathymetry The bathymetry TIN. Its triangles are indexed once.
+/// \return Shared ptr to a XmTinVolumes
+//------------------------------------------------------------------------------
+BSHP<XmTinVolumes> XmTinVolumes::New(BSHP<TrTin> a_bathymetry)
+{
+  BSHP<XmTinVolumes> p(new XmTinVolumesImpl(a_bathymetry));
+  return p;
+} // XmTinVolumes::New
+//------------------------------------------------------------------------------
+/// \brief
+//------------------------------------------------------------------------------
+XmTinVolumes::XmTinVolumes()
+{
+} // XmTinVolumes::XmTinVolumes
+//------------------------------------------------------------------------------
+/// \brief
+//------------------------------------------------------------------------------
+XmTinVolumes::~XmTinVolumes()
+{
+} // XmTinVolumes::~XmTinVolumes
+
+} // namespace xms
+
+#ifdef CXX_TEST
+//------------------------------------------------------------------------------
+// Unit Tests
+//------------------------------------------------------------------------------
+using namespace xms;
+#include <xmsstamper/stamper/detail/XmTinVolumes.t.h>
+
+#include <xmscore/testing/TestTools.h>
+
+namespace
+{
+//------------------------------------------------------------------------------
+/// \brief Builds a TIN on a grid of square cells split in 2 triangles.
+/// \param[in] a_min Lower left corner
+/// \param[in] a_size Size of the cells
+/// \param[in] a_n Number of cells in each direction
+/// \param[in] a_slope z is a_z + a_slope * (x - 20)
+/// \param[in] a_z Elevation at x = 20
+/// \return The TIN.
+//------------------------------------------------------------------------------
+BSHP<TrTin> iBuildGridTin(const Pt3d& a_min, double a_size, int a_n, double a_slope, double a_z)
+{
+  BSHP<TrTin> tin = TrTin::New();
+  VecPt3d& pts(tin->Points());
+  for (int j = 0; j <= a_n; ++j)
+  {
+    for (int i = 0; i <= a_n; ++i)
+    {
+      double x = a_min.x + a_size * i;
+      pts.push_back(Pt3d(x, a_min.y + a_size * j, a_z + a_slope * (x - 20.0)));
+    }
+  }
+  VecInt& tris(tin->Triangles());
+  for (int j = 0; j < a_n; ++j)
+  {
+    for (int i = 0; i < a_n; ++i)
+    {
+      int p0 = (a_n + 1) * j + i, p1 = p0 + 1, p2 = p1 + a_n + 1, p3 = p0 + a_n + 1;
+      tris.insert(tris.end(), {p0, p1, p2, p0, p2, p3});
+    }
+  }
+  return tin;
+} // iBuildGridTin
+
+} // unnamed namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmTinVolumesUnitTests
+/// \brief Tests XmTinVolumes
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Tests the volumes between TINs
+//------------------------------------------------------------------------------
+void XmTinVolumesUnitTests::testCompute()
+{
+  // flat 40 x 40 bathymetry at 0
+  BSHP<TrTin> bathymetry = iBuildGridTin(Pt3d(0, 0), 10.0, 4, 0.0, 0.0);
+  BSHP<XmTinVolumes> volumes = XmTinVolumes::New(bathymetry);
+  double cut, fill;
+
+  // 16 x 16 square 5 below
+  BSHP<TrTin> stamp = iBuildGridTin(Pt3d(12, 12), 16.0, 1, 0.0, -5.0);
+  TS_ASSERT(volumes->Compute(stamp, cut, fill));
+  TS_ASSERT_DELTA(1280.0, cut, 1e-9);
+  TS_ASSERT_DELTA(0.0, fill, 1e-9);
+
+  // sloped square crossing the bathymetry at x = 20
+  stamp = iBuildGridTin(Pt3d(12, 12), 16.0, 1, 1.0, 0.0);
+  TS_ASSERT(volumes->Compute(stamp, cut, fill));
+  TS_ASSERT_DELTA(512.0, cut, 1e-9);
+  TS_ASSERT_DELTA(512.0, fill, 1e-9);
+
+  // only the part over the bathymetry counts
+  stamp = iBuildGridTin(Pt3d(32, 12), 16.0, 1, 0.0, -5.0);
+  TS_ASSERT(volumes->Compute(stamp, cut, fill));
+  TS_ASSERT_DELTA(640.0, cut, 1e-9);
+  TS_ASSERT_DELTA(0.0, fill, 1e-9);
+
+  // many stamp triangles in parallel
+  stamp = iBuildGridTin(Pt3d(0, 0), 1.0, 40, 1.0, 0.0);
+  XmUtil::SetMaxThreads(4);
+  TS_ASSERT(volumes->Compute(stamp, cut, fill));
+  XmUtil::SetMaxThreads(0);
+  TS_ASSERT_DELTA(8000.0, cut, 1e-6);
+  TS_ASSERT_DELTA(8000.0, fill, 1e-6);
+} // XmTinVolumesUnitTests::testCompute
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup stamping
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+
+// 4. External library headers
+#include <xmscore/misc/boost_defines.h>
+#include <xmscore/misc/base_macros.h> // for XM_DISALLOW_COPY_AND_ASSIGN
+#include <xmscore/stl/vector.h>
+
+// 5. Shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Structs / Classes ------------------------------------------------------
+class TrTin;
+
+//----- Function prototypes ----------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmTinVolumes
+/// \brief Computes the exact cut and fill volumes between a stamp TIN and a
+/// bathymetry TIN. The bathymetry is indexed once so many stamps can be
+/// measured against it.
+class XmTinVolumes
+{
+public:
+  static BSHP<XmTinVolumes> New(BSHP<TrTin> a_bathymetry);
+
+  XmTinVolumes();
+  virtual ~XmTinVolumes();
+
+  /// \cond
+  virtual bool Compute(BSHP<TrTin> a_stamp, double& a_cutVolume, double& a_fillVolume) = 0;
+
+private:
+  XM_DISALLOW_COPY_AND_ASSIGN(XmTinVolumes);
+  /// \endcond
+}; // XmTinVolumes
+
+} // namespace xms
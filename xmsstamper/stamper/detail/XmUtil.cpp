@@ -13,12 +13,21 @@
 #include <xmsstamper/stamper/detail/XmUtil.h>
 
 // 3. Standard library headers
+#include <algorithm>
 #include <cmath>
+#include <exception>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 // 4. External library headers
 
 // 5. Shared code headers
+#include <xmscore/math/math.h>
+#include <xmscore/misc/XmConst.h>
 #include <xmscore/misc/XmError.h>
+#include <xmscore/misc/xmstype.h>
 #include <xmsgrid/geometry/geoms.h>
 #include <xmsstamper/stamper/XmStamperIo.h>
 
@@ -34,8 +43,188 @@ namespace xms
 {
 //----- Constants / Enumerations -----------------------------------------------
 
+/// Minimum number of grid cells processed by each thread in StampTinToPoints.
+const size_t MIN_CELLS_PER_THREAD = 256;
+
 //----- Classes / Structs ------------------------------------------------------
 
+//----- Internal functions -----------------------------------------------------
+namespace
+{
+//------------------------------------------------------------------------------
+/// \brief Maximum number of threads used by XmUtil::ParallelFor.
+/// \return Reference to the setting. 0 means use the hardware concurrency.
+//------------------------------------------------------------------------------
+int& iMaxThreads()
+{
+  static int maxThreads(0);
+  return maxThreads;
+} // iMaxThreads
+//------------------------------------------------------------------------------
+/// \brief Checks if a cross section has data.
+/// \param[in] a_cs The cross section
+/// \return true if the cross section has points on either side.
+//------------------------------------------------------------------------------
+bool iValidCrossSection(const XmStampCrossSection& a_cs)
+{
+  return a_cs.m_left.size() > 1 || a_cs.m_right.size() > 1;
+} // iValidCrossSection
+//------------------------------------------------------------------------------
+/// \brief Checks if two cross sections are the same.
+/// \param[in] a_cs1 The first cross section
+/// \param[in] a_cs2 The second cross section
+/// \return true if the cross sections are the same.
+//------------------------------------------------------------------------------
+bool iSameCrossSection(const XmStampCrossSection& a_cs1, const XmStampCrossSection& a_cs2)
+{
+  return a_cs1.m_leftMax == a_cs2.m_leftMax && a_cs1.m_rightMax == a_cs2.m_rightMax &&
+         a_cs1.m_idxLeftShoulder == a_cs2.m_idxLeftShoulder &&
+         a_cs1.m_idxRightShoulder == a_cs2.m_idxRightShoulder && a_cs1.m_left == a_cs2.m_left &&
+         a_cs1.m_right == a_cs2.m_right;
+} // iSameCrossSection
+//------------------------------------------------------------------------------
+/// \brief Gets how far a point is from the segment between two center line
+/// points relative to the tolerance, in xy and in z.
+/// \param[in] a_p The point
+/// \param[in] a_p0 The first point of the segment
+/// \param[in] a_p1 The second point of the segment
+/// \param[in] a_tolerance The tolerance
+/// \return The larger of the xy distance and the z difference divided by
+/// a_tolerance.
+//------------------------------------------------------------------------------
+double iRelativeDeviation(const Pt3d& a_p, const Pt3d& a_p0, const Pt3d& a_p1, double a_tolerance)
+{
+  double dx = a_p1.x - a_p0.x, dy = a_p1.y - a_p0.y;
+  double len2 = dx * dx + dy * dy;
+  double t(0.0);
+  if (len2 > 0.0)
+    t = std::min(1.0, std::max(0.0, ((a_p.x - a_p0.x) * dx + (a_p.y - a_p0.y) * dy) / len2));
+  double ex = a_p0.x + t * dx - a_p.x, ey = a_p0.y + t * dy - a_p.y;
+  double dz = fabs(a_p0.z + t * (a_p1.z - a_p0.z) - a_p.z);
+  return std::max(sqrt(ex * ex + ey * ey), dz) / a_tolerance;
+} // iRelativeDeviation
+//------------------------------------------------------------------------------
+/// \brief Finds the center line points kept by XmUtil::SimplifyCenterLine.
+/// \param[in] a_cl The center line
+/// \param[in] a_tolerance Max distance from the simplified center line.
+/// \param[in] a_valid Checks if the point at an index has a cross section.
+/// \param[in] a_same Checks if the cross sections at 2 indexes are the same.
+/// \return 1 for each point that is kept and 0 for each point removed.
+//------------------------------------------------------------------------------
+template <typename Valid, typename Same>
+std::vector<char> iSimplifyCenterLine(const VecPt3d& a_cl,
+                                      double a_tolerance,
+                                      Valid a_valid,
+                                      Same a_same)
+{
+  size_t n = a_cl.size();
+  std::vector<char> keep(n, 0);
+  keep[0] = keep[n - 1] = 1;
+  VecInt valid;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (a_valid(i))
+      valid.push_back((int)i);
+  }
+  for (size_t i = 0; i < valid.size(); ++i)
+  {
+    if (i == 0 || i + 1 == valid.size() || !a_same(valid[i], valid[i - 1]) ||
+        !a_same(valid[i], valid[i + 1]))
+      keep[valid[i]] = 1;
+  }
+
+  // Douglas-Peucker between each pair of points that must be kept
+  std::vector<std::pair<size_t, size_t>> stack;
+  for (size_t i = 0, prev = 0; i < n; ++i)
+  {
+    if (keep[i] && i > prev)
+    {
+      stack.push_back(std::make_pair(prev, i));
+      prev = i;
+    }
+  }
+  while (!stack.empty())
+  {
+    size_t i0 = stack.back().first, i1 = stack.back().second;
+    stack.pop_back();
+    double maxDev(1.0);
+    size_t iMax(i0);
+    for (size_t i = i0 + 1; i < i1; ++i)
+    {
+      double dev = iRelativeDeviation(a_cl[i], a_cl[i0], a_cl[i1], a_tolerance);
+      if (dev > maxDev)
+      {
+        maxDev = dev;
+        iMax = i;
+      }
+    }
+    if (iMax != i0)
+    {
+      keep[iMax] = 1;
+      stack.push_back(std::make_pair(i0, iMax));
+      stack.push_back(std::make_pair(iMax, i1));
+    }
+  }
+  return keep;
+} // iSimplifyCenterLine
+//------------------------------------------------------------------------------
+/// \brief Removes the entries of a vector that are not kept.
+/// \param[in] a_keep 1 for each entry that is kept
+/// \param[in,out] a_v The vector
+//------------------------------------------------------------------------------
+template <typename T>
+void iCompact(const std::vector<char>& a_keep, std::vector<T>& a_v)
+{
+  size_t cnt(0);
+  for (size_t i = 0; i < a_keep.size() && i < a_v.size(); ++i)
+  {
+    if (!a_keep[i])
+      continue;
+    if (cnt != i)
+      a_v[cnt] = a_v[i];
+    ++cnt;
+  }
+  a_v.resize(cnt);
+} // iCompact
+//------------------------------------------------------------------------------
+/// \brief Checks if an edge between the two polylines of a zipper strip stays
+/// inside the strip.
+/// \param[in] a_pts The point locations
+/// \param[in] a_polyA The first polyline
+/// \param[in] a_polyB The second polyline
+/// \param[in] a_a Index in a_polyA of the edge start
+/// \param[in] a_b Index in a_polyB of the edge end
+/// \return true if the edge does not cross the strip boundary.
+//------------------------------------------------------------------------------
+bool iZipperEdgeOk(const VecPt3d& a_pts,
+                   const VecInt& a_polyA,
+                   const VecInt& a_polyB,
+                   size_t a_a,
+                   size_t a_b)
+{
+  int ia = a_polyA[a_a], ib = a_polyB[a_b];
+  const Pt3d &p0(a_pts[ia]), &p1(a_pts[ib]);
+  const VecInt* polys[2] = {&a_polyA, &a_polyB};
+  for (const VecInt* poly : polys)
+  {
+    for (size_t i = 1; i < poly->size(); ++i)
+    {
+      int i0 = (*poly)[i - 1], i1 = (*poly)[i];
+      if (i0 == ia || i0 == ib || i1 == ia || i1 == ib)
+        continue;
+      if (XmUtil::SegmentsCross(p0, p1, a_pts[i0], a_pts[i1]))
+        return false;
+    }
+  }
+  int e0 = a_polyA.back(), e1 = a_polyB.back();
+  if (e0 != ia && e0 != ib && e1 != ia && e1 != ib &&
+      XmUtil::SegmentsCross(p0, p1, a_pts[e0], a_pts[e1]))
+    return false;
+  return true;
+} // iZipperEdgeOk
+
+} // unnamed namespace
+
 //------------------------------------------------------------------------------
 /// \brief Converts the left or right portion of a cross section data to
 /// 3d point locations using the angle from the center line and the max x value
@@ -51,25 +240,54 @@ void XmUtil::ConvertXsPointsTo3d(const Pt3d& a_cl,
                                  double a_maxX,
                                  double a_angle,
                                  VecPt3d2d& a_3dpts)
+{
+  ConvertXsPointsTo3d(a_cl, a_pts, a_maxX, cos(a_angle), sin(a_angle), a_3dpts);
+} // XmUtil::ConvertXsPointsTo3d
+//------------------------------------------------------------------------------
+/// \brief Converts the cross section points (distance, elevation) to (x,y,z)
+/// 3d point locations using the cosine and sine of the angle from the center
+/// line. Use GetCenterLineSinCos to get these for a whole center line at once.
+/// \param[in] a_cl The location on the centerline for these cross section points
+/// \param[in] a_pts The cross section points
+/// \param[in] a_maxX The max X value for this portion of the cross section
+/// \param[in] a_cos The cosine of the angle of the cross section
+/// \param[in] a_sin The sine of the angle of the cross section
+/// \param[out] a_3dpts (x,y,z) points that are filled by the this method
+//------------------------------------------------------------------------------
+void XmUtil::ConvertXsPointsTo3d(const Pt3d& a_cl,
+                                 const VecPt3d& a_pts,
+                                 double a_maxX,
+                                 double a_cos,
+                                 double a_sin,
+                                 VecPt3d2d& a_3dpts)
 {
   if (a_pts.size() < 2 || a_maxX <= 0.0)
     return;
 
-  VecPt3d pts(a_pts);
-  XmUtil::EnsureVectorAtMaxX(pts, a_maxX);
+  // only copy the profile when EnsureVectorAtMaxX would change it
+  bool atMaxX = a_pts.back().x == a_maxX && a_pts.front().x <= a_maxX;
+  for (size_t i = 1; atMaxX && i + 1 < a_pts.size(); ++i)
+    atMaxX = a_pts[i].x < a_maxX;
+  const VecPt3d* ptsPtr(&a_pts);
+  VecPt3d pts;
+  if (!atMaxX)
+  {
+    pts = a_pts;
+    XmUtil::EnsureVectorAtMaxX(pts, a_maxX);
+    ptsPtr = &pts;
+  }
+  const VecPt3d& v(*ptsPtr);
 
-  a_3dpts.push_back(VecPt3d());
-  VecPt3d& pts3d(a_3dpts.back());
-  Pt3d p3d;
-  for (size_t i = 1; i < pts.size(); ++i)
+  a_3dpts.push_back(VecPt3d(v.size() - 1));
+  Pt3d* out(a_3dpts.back().data());
+  const double clx(a_cl.x), cly(a_cl.y);
+  const size_t n(v.size() - 1);
+  for (size_t i = 0; i < n; ++i)
   {
-    double x2d = pts[i].x;
-    double z = pts[i].y;
-    p3d.z = z;
-    p3d.x = a_cl.x + x2d * cos(a_angle);
-    p3d.y = a_cl.y + x2d * sin(a_angle);
-    // add the point
-    pts3d.push_back(p3d);
+    const double x2d = v[i + 1].x;
+    out[i].x = clx + x2d * a_cos;
+    out[i].y = cly + x2d * a_sin;
+    out[i].z = v[i + 1].y;
   }
 } // XmUtil::ConvertXsPointsTo3d
 //------------------------------------------------------------------------------
@@ -87,6 +305,566 @@ void XmUtil::ScaleCrossSectionXvals(XmStampCrossSection& a_xs, double a_factor)
   a_xs.m_rightMax *= a_factor;
 } // XmUtil::ScaleCrossSectionXvals
 //------------------------------------------------------------------------------
+/// \brief Gets the number of divisions needed so that chords along a circular
+/// arc stay within a_maxChordDeviation of the arc. Never less than 1 or more
+/// than one division per degree.
+/// \param[in] a_degrees The angle swept by the arc in degrees
+/// \param[in] a_radius The radius of the arc
+/// \param[in] a_maxChordDeviation Max distance between a chord and the arc
+/// \return The number of divisions.
+//------------------------------------------------------------------------------
+int XmUtil::ArcDivisions(double a_degrees, double a_radius, double a_maxChordDeviation)
+{
+  if (a_degrees <= 0.0 || a_radius <= 0.0 || a_maxChordDeviation <= 0.0)
+    return 1;
+  int maxDiv = std::max(1, static_cast<int>(ceil(a_degrees)));
+  // the sagitta of a chord spanning angle t is r * (1 - cos(t/2))
+  double c = 1.0 - a_maxChordDeviation / a_radius;
+  if (c <= 0.0)
+    return 1;
+  double step = 2.0 * acos(c) * 180.0 / XM_PI;
+  if (step <= 0.0)
+    return maxDiv;
+  int nDiv = static_cast<int>(ceil(a_degrees / step - 1e-9));
+  return std::min(maxDiv, std::max(1, nDiv));
+} // XmUtil::ArcDivisions
+//------------------------------------------------------------------------------
+/// \brief Removes center line points that are within a_tolerance (in xy and
+/// in z) of the simplified center line using Douglas-Peucker. The end points
+/// are kept, as are points where the cross section changes: a point with a
+/// cross section is only removed when the previous and next cross sections are
+/// the same as its own. Points without cross sections are interpolated later
+/// so they can be removed.
+/// \param[in,out] a_cl The center line
+/// \param[in,out] a_cs The cross sections at the center line points
+/// \param[in] a_tolerance Max distance from the simplified center line. 0
+/// leaves the center line unchanged.
+/// \return The number of points removed.
+//------------------------------------------------------------------------------
+int XmUtil::SimplifyCenterLine(VecPt3d& a_cl,
+                               std::vector<XmStampCrossSection>& a_cs,
+                               double a_tolerance)
+{
+  if (a_tolerance <= 0.0 || a_cl.size() < 3 || a_cs.size() != a_cl.size())
+    return 0;
+
+  size_t n = a_cl.size();
+  std::vector<char> keep = iSimplifyCenterLine(
+    a_cl, a_tolerance, [&](size_t i) { return iValidCrossSection(a_cs[i]); },
+    [&](size_t i, size_t j) { return iSameCrossSection(a_cs[i], a_cs[j]); });
+  iCompact(keep, a_cl);
+  iCompact(keep, a_cs);
+  return static_cast<int>(n - a_cl.size());
+} // XmUtil::SimplifyCenterLine
+//------------------------------------------------------------------------------
+/// \brief Removes center line points the same way as the overload above
+/// using the center line, cross sections, templates, station lengths and
+/// tolerance of a_io. Points that use the same template have the same cross
+/// section.
+/// \param[in,out] a_io The stamper inputs. m_centerLine, m_cs, m_csTemplates
+/// and m_csStationLengths are updated.
+/// \return The number of points removed.
+//------------------------------------------------------------------------------
+int XmUtil::SimplifyCenterLine(XmStamperIo& a_io)
+{
+  VecPt3d& cl(a_io.m_centerLine);
+  const VecInt& templates(a_io.m_csTemplates);
+  VecDbl& lengths(a_io.m_csStationLengths);
+  if (templates.empty() && lengths.empty())
+    return SimplifyCenterLine(cl, a_io.m_cs, a_io.m_centerLineTolerance);
+  if (a_io.m_centerLineTolerance <= 0.0 || cl.size() < 3 || a_io.m_cs.size() != cl.size() ||
+      (!templates.empty() && templates.size() != cl.size()) ||
+      (!lengths.empty() && lengths.size() != cl.size()))
+    return 0;
+
+  size_t n = cl.size();
+  XmStampCrossSection buf1, buf2;
+  std::vector<char> keep = iSimplifyCenterLine(
+    cl, a_io.m_centerLineTolerance, [&](size_t i) { return a_io.HasCrossSection(i); },
+    [&](size_t i, size_t j) {
+      return (!templates.empty() && templates[i] >= 0 && templates[i] == templates[j]) ||
+             iSameCrossSection(a_io.CrossSection(i, buf1), a_io.CrossSection(j, buf2));
+    });
+  iCompact(keep, cl);
+  iCompact(keep, a_io.m_cs);
+  if (!templates.empty())
+    iCompact(keep, a_io.m_csTemplates);
+  if (!lengths.empty())
+    iCompact(keep, lengths);
+  return static_cast<int>(n - cl.size());
+} // XmUtil::SimplifyCenterLine
+//------------------------------------------------------------------------------
+/// \brief Triangulates the strip between two polylines that start on a common
+/// edge (a_polyA[0] to a_polyB[0]) and end on a common edge (a_polyA.back() to
+/// a_polyB.back()). Walks along both polylines adding the shorter of the two
+/// possible edges, so every polyline segment is a triangle edge.
+/// \param[in] a_pts The point locations
+/// \param[in] a_polyA Indexes of the points in the first polyline
+/// \param[in] a_polyB Indexes of the points in the second polyline
+/// \param[in,out] a_tris Counter clockwise triangles are appended to this.
+/// \return false if the strip folds over itself or has no area. a_tris is not
+/// changed in that case.
+//------------------------------------------------------------------------------
+bool XmUtil::ZipperTriangulate(const VecPt3d& a_pts,
+                               const VecInt& a_polyA,
+                               const VecInt& a_polyB,
+                               VecInt& a_tris)
+{
+  XM_ENSURE_TRUE(!a_polyA.empty() && !a_polyB.empty(), false);
+  size_t m = a_polyA.size(), n = a_polyB.size();
+  if (m + n < 3)
+    return true;
+
+  // orientation of the strip boundary: along A then back along B
+  double area(0.0);
+  VecInt loop(a_polyA);
+  loop.insert(loop.end(), a_polyB.rbegin(), a_polyB.rend());
+  for (size_t i = 0; i < loop.size(); ++i)
+  {
+    const Pt3d &p0(a_pts[loop[i]]), &p1(a_pts[loop[(i + 1) % loop.size()]]);
+    area += p0.x * p1.y - p1.x * p0.y;
+  }
+  if (area == 0.0)
+    return false;
+  bool ccw = area > 0.0;
+
+  VecInt tris;
+  tris.reserve(3 * (m + n - 2));
+  size_t i(0), j(0);
+  while (i + 1 < m || j + 1 < n)
+  {
+    const Pt3d &a(a_pts[a_polyA[i]]), &b(a_pts[a_polyB[j]]);
+    bool advanceA = j + 1 >= n;
+    if (i + 1 < m && j + 1 < n)
+    {
+      const Pt3d &a1(a_pts[a_polyA[i + 1]]), &b1(a_pts[a_polyB[j + 1]]);
+      double dA = (a1.x - b.x) * (a1.x - b.x) + (a1.y - b.y) * (a1.y - b.y);
+      double dB = (a.x - b1.x) * (a.x - b1.x) + (a.y - b1.y) * (a.y - b1.y);
+      advanceA = dA <= dB;
+    }
+    bool done(false);
+    for (int tries = 0; !done && tries < 2; ++tries, advanceA = !advanceA)
+    {
+      if ((advanceA && i + 1 >= m) || (!advanceA && j + 1 >= n))
+        continue;
+      int t0 = a_polyA[i], t1, t2;
+      if (advanceA)
+      {
+        t1 = a_polyA[i + 1];
+        t2 = a_polyB[j];
+      }
+      else
+      {
+        t1 = a_polyB[j + 1];
+        t2 = a_polyB[j];
+      }
+      double cross = Cross(a_pts[t0], a_pts[t1], a_pts[t2]);
+      if (cross == 0.0 || (cross > 0.0) != ccw)
+        continue;
+      size_t ia = advanceA ? i + 1 : i, jb = advanceA ? j : j + 1;
+      bool closing = ia + 1 == m && jb + 1 == n;
+      if (!closing && !iZipperEdgeOk(a_pts, a_polyA, a_polyB, ia, jb))
+        continue;
+      if (!ccw)
+        std::swap(t1, t2);
+      tris.push_back(t0);
+      tris.push_back(t1);
+      tris.push_back(t2);
+      if (advanceA)
+        ++i;
+      else
+        ++j;
+      done = true;
+    }
+    if (!done)
+      return false;
+  }
+  a_tris.insert(a_tris.end(), tris.begin(), tris.end());
+  return true;
+} // XmUtil::ZipperTriangulate
+//------------------------------------------------------------------------------
+/// \brief Finds the triangles outside a polygon whose edges are all edges in
+/// the triangles. Starts from the triangles on the outside of each polygon
+/// edge and flood fills across edges that are not on the polygon, so no point
+/// in polygon tests are needed.
+/// \param[in] a_pts The point locations
+/// \param[in] a_tris The triangles (3 point indexes each)
+/// \param[in] a_outerPoly Indexes of the polygon points. Closed (the last
+/// point is the same as the first).
+/// \param[out] a_outside Indexes of the triangles outside the polygon.
+/// \return false if a polygon edge is not a triangle edge. a_outside is empty
+/// in that case.
+//------------------------------------------------------------------------------
+bool XmUtil::FloodFillOuterTriangles(const VecPt3d& a_pts,
+                                     const VecInt& a_tris,
+                                     const VecInt& a_outerPoly,
+                                     SetInt& a_outside)
+{
+  a_outside.clear();
+  XM_ENSURE_TRUE(a_outerPoly.size() > 3, false);
+  double area(0.0);
+  for (size_t i = 1; i < a_outerPoly.size(); ++i)
+  {
+    const Pt3d &p0(a_pts[a_outerPoly[i - 1]]), &p1(a_pts[a_outerPoly[i]]);
+    area += p0.x * p1.y - p1.x * p0.y;
+  }
+  bool ccw = area > 0.0;
+
+  // the inside of a counter clockwise polygon is on the left of its edges
+  VecInt edges;
+  edges.reserve(2 * a_outerPoly.size());
+  for (size_t i = 1; i < a_outerPoly.size(); ++i)
+  {
+    edges.push_back(ccw ? a_outerPoly[i - 1] : a_outerPoly[i]);
+    edges.push_back(ccw ? a_outerPoly[i] : a_outerPoly[i - 1]);
+  }
+  return FloodFillOutsideEdges(a_tris, edges, a_outside);
+} // XmUtil::FloodFillOuterTriangles
+//------------------------------------------------------------------------------
+/// \brief Finds the triangles on the outside of a set of directed boundary
+/// edges. Starts from the triangles on the right of each edge and flood fills
+/// across edges that are not boundary edges.
+/// \param[in] a_tris The triangles (3 point indexes each, counter clockwise)
+/// \param[in] a_edges Pairs of point indexes. The triangles that are kept are
+/// on the left of each edge.
+/// \param[out] a_outside Indexes of the triangles outside the edges.
+/// \return false if an edge is not a triangle edge. a_outside is empty in that
+/// case.
+//------------------------------------------------------------------------------
+bool XmUtil::FloodFillOutsideEdges(const VecInt& a_tris, const VecInt& a_edges, SetInt& a_outside)
+{
+  a_outside.clear();
+  auto key = [](int a_from, int a_to) {
+    return ((uint64_t)(uint32_t)a_from << 32) | (uint64_t)(uint32_t)a_to;
+  };
+
+  // triangle on the left of each directed edge
+  std::unordered_map<uint64_t, int> edgeTri;
+  edgeTri.reserve(a_tris.size());
+  int nTris = (int)(a_tris.size() / 3);
+  for (int t = 0; t < nTris; ++t)
+  {
+    const int* tri = &a_tris[3 * t];
+    for (int e = 0; e < 3; ++e)
+      edgeTri[key(tri[e], tri[(e + 1) % 3])] = t;
+  }
+
+  std::unordered_set<uint64_t> boundary;
+  VecInt stack;
+  std::vector<char> outside(nTris, 0);
+  for (size_t i = 0; i + 1 < a_edges.size(); i += 2)
+  {
+    int p0 = a_edges[i], p1 = a_edges[i + 1];
+    if (edgeTri.find(key(p0, p1)) == edgeTri.end() && edgeTri.find(key(p1, p0)) == edgeTri.end())
+      return false;
+    boundary.insert(key(std::min(p0, p1), std::max(p0, p1)));
+    auto it = edgeTri.find(key(p1, p0));
+    if (it != edgeTri.end() && !outside[it->second])
+    {
+      outside[it->second] = 1;
+      stack.push_back(it->second);
+    }
+  }
+
+  while (!stack.empty())
+  {
+    int t = stack.back();
+    stack.pop_back();
+    const int* tri = &a_tris[3 * t];
+    for (int e = 0; e < 3; ++e)
+    {
+      int p0 = tri[e], p1 = tri[(e + 1) % 3];
+      if (boundary.find(key(std::min(p0, p1), std::max(p0, p1))) != boundary.end())
+        continue;
+      auto it = edgeTri.find(key(p1, p0));
+      if (it != edgeTri.end() && !outside[it->second])
+      {
+        outside[it->second] = 1;
+        stack.push_back(it->second);
+      }
+    }
+  }
+  for (int t = 0; t < nTris; ++t)
+  {
+    if (outside[t])
+      a_outside.insert(a_outside.end(), t);
+  }
+  return true;
+} // XmUtil::FloodFillOutsideEdges
+//------------------------------------------------------------------------------
+/// \brief Merges points that are within a tolerance of each other in xy. The
+/// first of the merged points is kept. Points are hashed to a grid with cells
+/// the size of the tolerance so only the neighboring cells are searched.
+/// \param[in,out] a_pts The points. Merged points are removed.
+/// \param[in] a_tol The xy tolerance
+/// \param[out] a_oldToNew New index of each of the original points.
+/// \return The number of points removed.
+//------------------------------------------------------------------------------
+int XmUtil::WeldPoints(VecPt3d& a_pts, double a_tol, VecInt& a_oldToNew)
+{
+  a_oldToNew.assign(a_pts.size(), -1);
+  if (a_pts.empty())
+    return 0;
+  Pt3d mn(a_pts.front()), mx(mn);
+  for (const auto& p : a_pts)
+  {
+    mn.x = std::min(mn.x, p.x);
+    mn.y = std::min(mn.y, p.y);
+    mx.x = std::max(mx.x, p.x);
+    mx.y = std::max(mx.y, p.y);
+  }
+  // keep the cell indexes small enough to hash
+  double extent = std::max(mx.x - mn.x, mx.y - mn.y);
+  double cell = std::max(std::max(a_tol, extent / (1 << 30)), XM_ZERO_TOL);
+  auto key = [](int64_t a_i, int64_t a_j) {
+    return ((uint64_t)(uint32_t)a_i << 32) | (uint64_t)(uint32_t)a_j;
+  };
+
+  // indexes of the kept points in each cell
+  std::unordered_map<uint64_t, VecInt> grid;
+  grid.reserve(a_pts.size());
+  double tol2 = a_tol * a_tol;
+  VecPt3d welded;
+  welded.reserve(a_pts.size());
+  for (size_t i = 0; i < a_pts.size(); ++i)
+  {
+    const Pt3d& p(a_pts[i]);
+    int64_t ci = (int64_t)std::floor((p.x - mn.x) / cell);
+    int64_t cj = (int64_t)std::floor((p.y - mn.y) / cell);
+    int match = -1;
+    for (int64_t di = -1; di <= 1 && match < 0; ++di)
+    {
+      for (int64_t dj = -1; dj <= 1 && match < 0; ++dj)
+      {
+        auto it = grid.find(key(ci + di, cj + dj));
+        if (it == grid.end())
+          continue;
+        for (int idx : it->second)
+        {
+          double dx = welded[idx].x - p.x, dy = welded[idx].y - p.y;
+          if (dx * dx + dy * dy <= tol2)
+          {
+            match = idx;
+            break;
+          }
+        }
+      }
+    }
+    if (match < 0)
+    {
+      match = (int)welded.size();
+      welded.push_back(p);
+      grid[key(ci, cj)].push_back(match);
+    }
+    a_oldToNew[i] = match;
+  }
+  int removed = (int)(a_pts.size() - welded.size());
+  a_pts.swap(welded);
+  return removed;
+} // XmUtil::WeldPoints
+//------------------------------------------------------------------------------
+/// \brief Gets twice the signed area of a triangle in xy.
+/// \param[in] a_p0 The first point
+/// \param[in] a_p1 The second point
+/// \param[in] a_p2 The third point
+/// \return Positive if the points are counter clockwise.
+//------------------------------------------------------------------------------
+double XmUtil::Cross(const Pt3d& a_p0, const Pt3d& a_p1, const Pt3d& a_p2)
+{
+  return (a_p1.x - a_p0.x) * (a_p2.y - a_p0.y) - (a_p1.y - a_p0.y) * (a_p2.x - a_p0.x);
+} // XmUtil::Cross
+//------------------------------------------------------------------------------
+/// \brief Checks if two segments cross at a point inside both of them.
+/// \param[in] a_p0 The first point of the first segment
+/// \param[in] a_p1 The second point of the first segment
+/// \param[in] a_p2 The first point of the second segment
+/// \param[in] a_p3 The second point of the second segment
+/// \param[in] a_touch true to also count an end point of one segment on the
+/// other segment
+/// \return true if the segments cross or overlap (or touch with a_touch).
+//------------------------------------------------------------------------------
+bool XmUtil::SegmentsCross(const Pt3d& a_p0,
+                           const Pt3d& a_p1,
+                           const Pt3d& a_p2,
+                           const Pt3d& a_p3,
+                           bool a_touch)
+{
+  double d0 = Cross(a_p2, a_p3, a_p0), d1 = Cross(a_p2, a_p3, a_p1);
+  double d2 = Cross(a_p0, a_p1, a_p2), d3 = Cross(a_p0, a_p1, a_p3);
+  if (((d0 > 0.0 && d1 < 0.0) || (d0 < 0.0 && d1 > 0.0)) &&
+      ((d2 > 0.0 && d3 < 0.0) || (d2 < 0.0 && d3 > 0.0)))
+    return true;
+  if (a_touch)
+  {
+    auto inExtents = [](const Pt3d& a_s0, const Pt3d& a_s1, const Pt3d& a_pt) {
+      return a_pt.x >= std::min(a_s0.x, a_s1.x) && a_pt.x <= std::max(a_s0.x, a_s1.x) &&
+             a_pt.y >= std::min(a_s0.y, a_s1.y) && a_pt.y <= std::max(a_s0.y, a_s1.y);
+    };
+    return (d0 == 0.0 && inExtents(a_p2, a_p3, a_p0)) ||
+           (d1 == 0.0 && inExtents(a_p2, a_p3, a_p1)) ||
+           (d2 == 0.0 && inExtents(a_p0, a_p1, a_p2)) ||
+           (d3 == 0.0 && inExtents(a_p0, a_p1, a_p3));
+  }
+  if (d0 == 0.0 && d1 == 0.0)
+  {
+    // collinear. Only a problem if they overlap.
+    double t0 = std::min(a_p0.x, a_p1.x), t1 = std::max(a_p0.x, a_p1.x);
+    double s0 = std::min(a_p2.x, a_p3.x), s1 = std::max(a_p2.x, a_p3.x);
+    double u0 = std::min(a_p0.y, a_p1.y), u1 = std::max(a_p0.y, a_p1.y);
+    double v0 = std::min(a_p2.y, a_p3.y), v1 = std::max(a_p2.y, a_p3.y);
+    return t0 < s1 && s0 < t1 && u0 <= v1 && v0 <= u1;
+  }
+  return false;
+} // XmUtil::SegmentsCross
+//------------------------------------------------------------------------------
+/// \brief Bins triangles in a grid with about one triangle per cell. The
+/// number of cells in each direction is limited to 4096. Each triangle is put
+/// in every cell its extents overlap.
+/// \param[in] a_pts The triangle points
+/// \param[in] a_tris The triangles (3 point indexes each)
+/// \param[out] a_grid The grid
+//------------------------------------------------------------------------------
+void XmUtil::BinTriangles(const VecPt3d& a_pts, const VecInt& a_tris, XmTriGrid& a_grid)
+{
+  a_grid = XmTriGrid();
+  size_t nTris = a_tris.size() / 3;
+  if (nTris == 0)
+    return;
+  Pt3d &pMin(a_grid.m_min), &pMax(a_grid.m_max);
+  pMin = Pt3d(XM_DBL_HIGHEST);
+  pMax = Pt3d(XM_DBL_LOWEST);
+  for (auto idx : a_tris)
+    gmAddToExtents(a_pts[idx], pMin, pMax);
+  double width(pMax.x - pMin.x), height(pMax.y - pMin.y);
+  double& cell(a_grid.m_cellSize);
+  cell = std::sqrt(std::max(width * height, XM_ZERO_TOL) / nTris);
+  cell = std::max(cell, std::max(width, height) / 4096);
+  cell = std::max(cell, XM_ZERO_TOL);
+  a_grid.m_nx = std::max(1, (int)std::ceil(width / cell));
+  a_grid.m_ny = std::max(1, (int)std::ceil(height / cell));
+
+  // count the triangles in each cell then fill them in
+  size_t nCells = (size_t)a_grid.m_nx * a_grid.m_ny;
+  VecInt &start(a_grid.m_cellStart), &cellTris(a_grid.m_cellTris);
+  start.assign(nCells + 1, 0);
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    VecInt fill(start.begin(), start.end() - 1);
+    for (size_t t = 0; t < nTris; ++t)
+    {
+      Pt3d tMin(XM_DBL_HIGHEST), tMax(XM_DBL_LOWEST);
+      for (int j = 0; j < 3; ++j)
+        gmAddToExtents(a_pts[a_tris[3 * t + j]], tMin, tMax);
+      for (int r = a_grid.Row(tMin.y); r <= a_grid.Row(tMax.y); ++r)
+      {
+        for (int c = a_grid.Col(tMin.x); c <= a_grid.Col(tMax.x); ++c)
+        {
+          size_t idx = (size_t)r * a_grid.m_nx + c;
+          if (pass == 0)
+            ++start[idx + 1];
+          else
+            cellTris[fill[idx]++] = (int)t;
+        }
+      }
+    }
+    if (pass == 0)
+    {
+      for (size_t i = 0; i < nCells; ++i)
+        start[i + 1] += start[i];
+      cellTris.resize(start.back());
+    }
+  }
+} // XmUtil::BinTriangles
+//------------------------------------------------------------------------------
+/// \brief Sets the z values of points from a TIN using the stamping rule used
+/// for rasters. Points with XM_NODATA elevations take the TIN value, otherwise
+/// a cut takes the lower value, a fill the higher value and both the TIN
+/// value. Points outside the TIN are not changed. The points are binned in a
+/// grid over the TIN, the triangles are binned in the same grid and each cell
+/// compares its points with its triangles. Cells are processed in parallel.
+/// \param[in] a_tinPts The TIN points
+/// \param[in] a_tris The TIN triangles (3 point indexes each)
+/// \param[in] a_stampingType 0 - cut, 1 - fill, 2 - both
+/// \param[in,out] a_pts The points
+/// \return The number of points inside the TIN.
+//------------------------------------------------------------------------------
+size_t XmUtil::StampTinToPoints(const VecPt3d& a_tinPts,
+                                const VecInt& a_tris,
+                                int a_stampingType,
+                                VecPt3d& a_pts)
+{
+  if (a_tris.size() < 3 || a_pts.empty())
+    return 0;
+  XmTriGrid grid;
+  BinTriangles(a_tinPts, a_tris, grid);
+  const Pt3d &pMin(grid.m_min), &pMax(grid.m_max);
+  const VecInt &triStart(grid.m_cellStart), &cellTris(grid.m_cellTris);
+  size_t nCells = (size_t)grid.m_nx * grid.m_ny;
+
+  // points in each cell
+  VecInt ptStart(nCells + 1, 0), cellPts;
+  VecInt ptCell(a_pts.size(), -1);
+  for (size_t i = 0; i < a_pts.size(); ++i)
+  {
+    const Pt3d& p(a_pts[i]);
+    if (p.x < pMin.x || p.x > pMax.x || p.y < pMin.y || p.y > pMax.y)
+      continue;
+    ptCell[i] = grid.Row(p.y) * grid.m_nx + grid.Col(p.x);
+    ++ptStart[ptCell[i] + 1];
+  }
+  for (size_t i = 0; i < nCells; ++i)
+    ptStart[i + 1] += ptStart[i];
+  cellPts.resize(ptStart.back());
+  {
+    VecInt fill(ptStart.begin(), ptStart.end() - 1);
+    for (size_t i = 0; i < a_pts.size(); ++i)
+    {
+      if (ptCell[i] >= 0)
+        cellPts[fill[ptCell[i]]++] = (int)i;
+    }
+  }
+
+  // each point is only in one cell so cells can be done in parallel
+  int nThreads = NumThreads(nCells, MIN_CELLS_PER_THREAD);
+  std::vector<size_t> found(std::max(1, nThreads), 0);
+  ParallelFor(nCells, nThreads, [&](int a_thread, size_t a_begin, size_t a_end) {
+    for (size_t c = a_begin; c < a_end; ++c)
+    {
+      for (int i = ptStart[c]; i < ptStart[c + 1]; ++i)
+      {
+        Pt3d& p(a_pts[cellPts[i]]);
+        for (int j = triStart[c]; j < triStart[c + 1]; ++j)
+        {
+          const int* tri = &a_tris[3 * cellTris[j]];
+          const Pt3d &p0(a_tinPts[tri[0]]), &p1(a_tinPts[tri[1]]), &p2(a_tinPts[tri[2]]);
+          double area = Cross(p0, p1, p2);
+          if (area == 0.0)
+            continue;
+          double w0 = Cross(p, p1, p2) / area;
+          double w1 = Cross(p, p2, p0) / area;
+          double w2 = 1.0 - w0 - w1;
+          const double tol = -1e-12;
+          if (w0 < tol || w1 < tol || w2 < tol)
+            continue;
+          double z = w0 * p0.z + w1 * p1.z + w2 * p2.z;
+          if (a_stampingType == 0 && !EQ_TOL(p.z, XM_NODATA, XM_ZERO_TOL))
+            p.z = std::min(p.z, z);
+          else if (a_stampingType == 1 && !EQ_TOL(p.z, XM_NODATA, XM_ZERO_TOL))
+            p.z = std::max(p.z, z);
+          else
+            p.z = z;
+          ++found[a_thread];
+          break;
+        }
+      }
+    }
+  });
+  size_t numFound(0);
+  for (auto n : found)
+    numFound += n;
+  return numFound;
+} // XmUtil::StampTinToPoints
+//------------------------------------------------------------------------------
 /// \brief Makes sure the cross section goes to the maxX value
 /// \param[in,out] a_pts 2d points
 /// \param[in] a_maxX Max x value
@@ -182,6 +960,243 @@ void XmUtil::GetAnglesFromCenterLine(size_t a_idx,
     a_rightAngle = gmBisectingAngle(p0, p, p1);
   }
 } // XmUtil::GetAnglesFromCenterLine
+//------------------------------------------------------------------------------
+/// \brief Gets the cosine and sine of the left and right cross section angles
+/// (see GetAnglesFromCenterLine) of every center line point starting at
+/// a_begin.
+/// \param[in] a_cl Array of locations defining center line
+/// \param[in] a_begin Index of the first center line point
+/// \param[out] a_leftCos Cosine of the left angle for each point from a_begin
+/// \param[out] a_leftSin Sine of the left angle for each point from a_begin
+/// \param[out] a_rightCos Cosine of the right angle for each point from a_begin
+/// \param[out] a_rightSin Sine of the right angle for each point from a_begin
+//------------------------------------------------------------------------------
+void XmUtil::GetCenterLineSinCos(const VecPt3d& a_cl,
+                                 size_t a_begin,
+                                 VecDbl& a_leftCos,
+                                 VecDbl& a_leftSin,
+                                 VecDbl& a_rightCos,
+                                 VecDbl& a_rightSin)
+{
+  size_t n = a_cl.size() > a_begin ? a_cl.size() - a_begin : 0;
+  a_leftCos.resize(n);
+  a_leftSin.resize(n);
+  a_rightCos.resize(n);
+  a_rightSin.resize(n);
+  double leftAngle, rightAngle;
+  for (size_t i = 0; i < n; ++i)
+  {
+    GetAnglesFromCenterLine(a_begin + i, a_cl, leftAngle, rightAngle);
+    a_leftCos[i] = cos(leftAngle);
+    a_leftSin[i] = sin(leftAngle);
+    a_rightCos[i] = cos(rightAngle);
+    a_rightSin[i] = sin(rightAngle);
+  }
+} // XmUtil::GetCenterLineSinCos
+//------------------------------------------------------------------------------
+/// \brief Gets the position of a location along a Hilbert curve covering the
+/// xy extents given. Locations close on the curve are close in space.
+/// \param[in] a_x The x coordinate
+/// \param[in] a_y The y coordinate
+/// \param[in] a_min The min xy of the extents
+/// \param[in] a_max The max xy of the extents
+/// \return The index along a Hilbert curve of order 16 (2^16 x 2^16 cells).
+//------------------------------------------------------------------------------
+uint64_t XmUtil::HilbertIndex(double a_x, double a_y, const Pt3d& a_min, const Pt3d& a_max)
+{
+  const uint32_t n = 1 << 16;
+  auto toCell = [n](double a_v, double a_lo, double a_hi) -> uint32_t {
+    double len = a_hi - a_lo;
+    if (len <= 0.0)
+      return 0;
+    double t = (a_v - a_lo) / len;
+    if (!(t > 0.0))
+      return 0;
+    if (t >= 1.0)
+      return n - 1;
+    return (uint32_t)(t * n);
+  };
+  uint32_t x = toCell(a_x, a_min.x, a_max.x);
+  uint32_t y = toCell(a_y, a_min.y, a_max.y);
+  uint64_t d = 0;
+  for (uint32_t s = n / 2; s > 0; s /= 2)
+  {
+    uint32_t rx = (x & s) > 0 ? 1 : 0;
+    uint32_t ry = (y & s) > 0 ? 1 : 0;
+    d += (uint64_t)s * s * ((3 * rx) ^ ry);
+    // rotate the quadrant
+    if (ry == 0)
+    {
+      if (rx == 1)
+      {
+        x = n - 1 - x;
+        y = n - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+} // XmUtil::HilbertIndex
+//------------------------------------------------------------------------------
+/// \brief Gets the order of points along a Hilbert curve covering the points.
+/// Ties are broken by the original index so the order is deterministic.
+/// \param[in] a_pts The points
+/// \param[out] a_order Indices of a_pts in Hilbert order
+//------------------------------------------------------------------------------
+void XmUtil::HilbertOrder(const VecPt3d& a_pts, VecInt& a_order)
+{
+  Pt3d pMin(XM_DBL_HIGHEST), pMax(XM_DBL_LOWEST);
+  for (const auto& p : a_pts)
+    gmAddToExtents(p, pMin, pMax);
+  std::vector<std::pair<uint64_t, int>> keys(a_pts.size());
+  for (size_t i = 0; i < a_pts.size(); ++i)
+    keys[i] = std::make_pair(HilbertIndex(a_pts[i].x, a_pts[i].y, pMin, pMax), (int)i);
+  std::sort(keys.begin(), keys.end());
+  a_order.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i)
+    a_order[i] = keys[i].second;
+} // XmUtil::HilbertOrder
+//------------------------------------------------------------------------------
+/// \brief Sets the maximum number of threads used by the stamping operations.
+/// \param[in] a_maxThreads Maximum number of threads. 1 forces serial
+/// processing and 0 (the default) uses the hardware concurrency.
+//------------------------------------------------------------------------------
+void XmUtil::SetMaxThreads(int a_maxThreads)
+{
+  iMaxThreads() = std::max(0, a_maxThreads);
+} // XmUtil::SetMaxThreads
+//------------------------------------------------------------------------------
+/// \brief Gets the number of threads to use to process items in parallel.
+/// \param[in] a_count The number of items to process
+/// \param[in] a_minPerThread The minimum number of items each thread should
+/// process. Used to avoid threading overhead on small inputs.
+/// \return The number of threads (at least 1).
+//------------------------------------------------------------------------------
+int XmUtil::NumThreads(size_t a_count, size_t a_minPerThread)
+{
+  int maxThreads = iMaxThreads();
+  if (maxThreads == 0)
+    maxThreads = (int)std::thread::hardware_concurrency();
+  if (maxThreads < 2)
+    return 1;
+  size_t byCount = a_count / std::max<size_t>(1, a_minPerThread);
+  if (byCount < 2)
+    return 1;
+  return (int)std::min<size_t>((size_t)maxThreads, byCount);
+} // XmUtil::NumThreads
+//------------------------------------------------------------------------------
+/// \brief Processes the range [0, a_count) in contiguous chunks, one chunk
+/// per thread. Each chunk is processed in increasing order so results written
+/// by index are identical to a serial loop.
+/// \param[in] a_count The number of items to process
+/// \param[in] a_numThreads The number of threads (see NumThreads). With 1
+/// thread the function is called on the calling thread.
+/// \param[in] a_func Called with the thread index and the [begin, end) range
+/// of items for that thread.
+//------------------------------------------------------------------------------
+void XmUtil::ParallelFor(size_t a_count,
+                         int a_numThreads,
+                         const std::function<void(int, size_t, size_t)>& a_func)
+{
+  if (a_count == 0)
+    return;
+  size_t nThreads = std::min<size_t>(std::max(1, a_numThreads), a_count);
+  if (nThreads == 1)
+  {
+    a_func(0, 0, a_count);
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(nThreads);
+  std::vector<std::thread> threads;
+  threads.reserve(nThreads - 1);
+  size_t chunk = a_count / nThreads, extra = a_count % nThreads, begin = 0;
+  for (size_t t = 0; t < nThreads; ++t)
+  {
+    size_t end = begin + chunk + (t < extra ? 1 : 0);
+    auto work = [&a_func, &errors, t, begin, end]() {
+      try
+      {
+        a_func((int)t, begin, end);
+      }
+      catch (...)
+      {
+        errors[t] = std::current_exception();
+      }
+    };
+    if (t + 1 < nThreads)
+      threads.push_back(std::thread(work));
+    else
+      work(); // the calling thread takes the last chunk
+    begin = end;
+  }
+  for (auto& thread : threads)
+    thread.join();
+  for (auto& error : errors)
+  {
+    if (error)
+      std::rethrow_exception(error);
+  }
+} // XmUtil::ParallelFor
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct XmTriGrid
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Constructor. The grid has no cells.
+//------------------------------------------------------------------------------
+XmTriGrid::XmTriGrid()
+: m_min()
+, m_max()
+, m_cellSize(1.0)
+, m_nx(0)
+, m_ny(0)
+{
+} // XmTriGrid::XmTriGrid
+//------------------------------------------------------------------------------
+/// \brief Gets the column of an x value. Values outside the grid get the
+/// nearest column.
+/// \param[in] a_x The x value
+/// \return The column.
+//------------------------------------------------------------------------------
+int XmTriGrid::Col(double a_x) const
+{
+  return std::min(m_nx - 1, std::max(0, (int)((a_x - m_min.x) / m_cellSize)));
+} // XmTriGrid::Col
+//------------------------------------------------------------------------------
+/// \brief Gets the row of a y value. Values outside the grid get the nearest
+/// row.
+/// \param[in] a_y The y value
+/// \return The row.
+//------------------------------------------------------------------------------
+int XmTriGrid::Row(double a_y) const
+{
+  return std::min(m_ny - 1, std::max(0, (int)((a_y - m_min.y) / m_cellSize)));
+} // XmTriGrid::Row
+//------------------------------------------------------------------------------
+/// \brief Finds the triangles in the cells overlapping an extents.
+/// \param[in] a_min Min x,y of the extents
+/// \param[in] a_max Max x,y of the extents
+/// \param[out] a_tris Indexes of the triangles (sorted, no duplicates)
+//------------------------------------------------------------------------------
+void XmTriGrid::FindTriangles(const Pt3d& a_min, const Pt3d& a_max, VecInt& a_tris) const
+{
+  a_tris.clear();
+  if (m_nx == 0 || a_max.x < m_min.x || a_min.x > m_max.x || a_max.y < m_min.y ||
+      a_min.y > m_max.y)
+    return;
+  for (int r = Row(a_min.y); r <= Row(a_max.y); ++r)
+  {
+    for (int c = Col(a_min.x); c <= Col(a_max.x); ++c)
+    {
+      size_t idx = (size_t)r * m_nx + c;
+      a_tris.insert(a_tris.end(), m_cellTris.begin() + m_cellStart[idx],
+                    m_cellTris.begin() + m_cellStart[idx + 1]);
+    }
+  }
+  std::sort(a_tris.begin(), a_tris.end());
+  a_tris.erase(std::unique(a_tris.begin(), a_tris.end()), a_tris.end());
+} // XmTriGrid::FindTriangles
 
 } // namespace xms
 
@@ -226,5 +1241,289 @@ void XmUtilUnitTests::test_EnsureVectorAtMaxX()
   basePts = {{0, 6}, {5, 6}, {20, -3}};
   TS_ASSERT_EQUALS_VEC(basePts, pts);
 } // XmUtilUnitTests::test_EnsureVectorAtMaxX
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::ParallelFor
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_ParallelFor()
+{
+  XmUtil::SetMaxThreads(4);
+  TS_ASSERT_EQUALS(1, XmUtil::NumThreads(10, 8));
+  TS_ASSERT_EQUALS(4, XmUtil::NumThreads(100, 8));
+
+  VecInt vals(103, -1), threadOfItem(103, -1), base(103);
+  for (size_t i = 0; i < base.size(); ++i)
+    base[i] = (int)(i * i);
+  XmUtil::ParallelFor(vals.size(), 4, [&](int a_thread, size_t a_begin, size_t a_end) {
+    for (size_t i = a_begin; i < a_end; ++i)
+    {
+      vals[i] = (int)(i * i);
+      threadOfItem[i] = a_thread;
+    }
+  });
+  TS_ASSERT_EQUALS_VEC(base, vals);
+  // chunks are contiguous and in thread order
+  TS_ASSERT_EQUALS(0, threadOfItem.front());
+  TS_ASSERT_EQUALS(3, threadOfItem.back());
+  TS_ASSERT(std::is_sorted(threadOfItem.begin(), threadOfItem.end()));
+
+  XmUtil::SetMaxThreads(1);
+  TS_ASSERT_EQUALS(1, XmUtil::NumThreads(100, 8));
+  XmUtil::SetMaxThreads(0);
+} // XmUtilUnitTests::test_ParallelFor
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::HilbertIndex and XmUtil::HilbertOrder
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_HilbertOrder()
+{
+  Pt3d pMin(0, 0), pMax(1, 1);
+  // the curve starts in the lower left and ends in the lower right
+  TS_ASSERT_EQUALS(0, XmUtil::HilbertIndex(0, 0, pMin, pMax));
+  uint64_t last = ((uint64_t)1 << 32) - 1;
+  TS_ASSERT_EQUALS(last, XmUtil::HilbertIndex(1, 0, pMin, pMax));
+  TS_ASSERT(XmUtil::HilbertIndex(0.1, 0.9, pMin, pMax) < XmUtil::HilbertIndex(0.9, 0.9, pMin, pMax));
+
+  // quadrants are visited lower left, upper left, upper right, lower right
+  VecPt3d pts = {{9, 1}, {9, 9}, {1, 1}, {1, 9}};
+  VecInt order;
+  XmUtil::HilbertOrder(pts, order);
+  VecInt baseOrder = {2, 3, 1, 0};
+  TS_ASSERT_EQUALS_VEC(baseOrder, order);
+} // XmUtilUnitTests::test_HilbertOrder
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::GetCenterLineSinCos and the sine/cosine version of
+/// XmUtil::ConvertXsPointsTo3d
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_ConvertXsPointsTo3dSinCos()
+{
+  VecPt3d cl = {{0, 0}, {10, 0}, {10, 10}, {20, 20}};
+  VecDbl leftCos, leftSin, rightCos, rightSin;
+  XmUtil::GetCenterLineSinCos(cl, 1, leftCos, leftSin, rightCos, rightSin);
+  TS_ASSERT_EQUALS(3, leftCos.size());
+  for (size_t i = 1; i < cl.size(); ++i)
+  {
+    double leftAngle, rightAngle;
+    XmUtil::GetAnglesFromCenterLine(i, cl, leftAngle, rightAngle);
+    TS_ASSERT_EQUALS(cos(leftAngle), leftCos[i - 1]);
+    TS_ASSERT_EQUALS(sin(leftAngle), leftSin[i - 1]);
+    TS_ASSERT_EQUALS(cos(rightAngle), rightCos[i - 1]);
+    TS_ASSERT_EQUALS(sin(rightAngle), rightSin[i - 1]);
+
+    // results match the angle version exactly, with and without truncation
+    VecPt3d pts = {{0, 5}, {3, 4}, {6, 2}, {9, 1}};
+    double maxXs[3] = {9, 7.5, 12};
+    for (double maxX : maxXs)
+    {
+      VecPt3d2d viaAngle, viaSinCos;
+      XmUtil::ConvertXsPointsTo3d(cl[i], pts, maxX, leftAngle, viaAngle);
+      XmUtil::ConvertXsPointsTo3d(cl[i], pts, maxX, leftCos[i - 1], leftSin[i - 1], viaSinCos);
+      TS_ASSERT_EQUALS(1, viaSinCos.size());
+      TS_ASSERT_EQUALS_VEC(viaAngle[0], viaSinCos[0]);
+    }
+  }
+
+  // a profile that already ends at the max x is converted without a copy
+  VecPt3d pts = {{0, 5}, {4, 2}};
+  VecPt3d2d pts3d;
+  XmUtil::ConvertXsPointsTo3d(Pt3d(1, 2), pts, 4, 0.0, 1.0, pts3d);
+  VecPt3d basePts = {{1, 6, 2}};
+  TS_ASSERT_EQUALS_VEC(basePts, pts3d[0]);
+} // XmUtilUnitTests::test_ConvertXsPointsTo3dSinCos
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::ArcDivisions
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_ArcDivisions()
+{
+  // a 90 degree arc in 6 divisions has a chord deviation of r*(1-cos(7.5))
+  double r = 20.0;
+  double dev = r * (1.0 - cos(7.5 * XM_PI / 180.0));
+  TS_ASSERT_EQUALS(6, XmUtil::ArcDivisions(90.0, r, dev));
+  TS_ASSERT_EQUALS(7, XmUtil::ArcDivisions(90.0, r, dev * 0.9));
+  // larger arcs need more divisions for the same deviation
+  TS_ASSERT(XmUtil::ArcDivisions(90.0, 10 * r, dev) > 6);
+  TS_ASSERT_EQUALS(1, XmUtil::ArcDivisions(90.0, r, r));
+  TS_ASSERT_EQUALS(90, XmUtil::ArcDivisions(90.0, r, 1e-12));
+  TS_ASSERT_EQUALS(1, XmUtil::ArcDivisions(90.0, r, 0.0));
+} // XmUtilUnitTests::test_ArcDivisions
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::SimplifyCenterLine
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_SimplifyCenterLine()
+{
+  XmStampCrossSection csA, csB;
+  csA.m_left = csA.m_right = {{0, 5}, {10, 0}};
+  csA.m_leftMax = csA.m_rightMax = 10;
+  csB = csA;
+  csB.m_leftMax = 12;
+
+  VecPt3d cl = {{0, 0, 5}, {10, 0.05, 5}, {20, 0, 5}, {30, 0.05, 5}, {40, 0, 5}, {50, 0, 5}};
+  std::vector<XmStampCrossSection> vCs(cl.size(), csA);
+  // a tolerance of 0 does nothing
+  VecPt3d cl2(cl);
+  std::vector<XmStampCrossSection> vCs2(vCs);
+  TS_ASSERT_EQUALS(0, XmUtil::SimplifyCenterLine(cl2, vCs2, 0.0));
+  TS_ASSERT_EQUALS(cl.size(), cl2.size());
+
+  // all inner points are within the tolerance
+  TS_ASSERT_EQUALS(4, XmUtil::SimplifyCenterLine(cl2, vCs2, 0.1));
+  VecPt3d base = {{0, 0, 5}, {50, 0, 5}};
+  TS_ASSERT_EQUALS_VEC(base, cl2);
+  TS_ASSERT_EQUALS(2, vCs2.size());
+
+  // points on either side of a cross section change are kept, as is a change
+  // in z. The point without a cross section is removed.
+  cl2 = cl;
+  cl2[4].z = 6;
+  vCs2 = vCs;
+  vCs2[2] = csB;
+  vCs2[1].m_left.clear();
+  vCs2[1].m_right.clear();
+  TS_ASSERT_EQUALS(1, XmUtil::SimplifyCenterLine(cl2, vCs2, 0.1));
+  base = {{0, 0, 5}, {20, 0, 5}, {30, 0.05, 5}, {40, 0, 6}, {50, 0, 5}};
+  TS_ASSERT_EQUALS_VEC(base, cl2);
+  TS_ASSERT_EQUALS(csB.m_leftMax, vCs2[1].m_leftMax);
+} // XmUtilUnitTests::test_SimplifyCenterLine
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::ZipperTriangulate
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_ZipperTriangulate()
+{
+  //  4-----5
+  //  |     |
+  //  2     3
+  //  |     |
+  //  0-----1
+  VecPt3d pts = {{0, 0}, {10, 0}, {0, 5}, {10, 6}, {0, 10}, {10, 10}};
+  VecInt polyA = {0, 2, 4}, polyB = {1, 3, 5}, tris;
+  TS_ASSERT(XmUtil::ZipperTriangulate(pts, polyA, polyB, tris));
+  // every triangle is counter clockwise
+  TS_ASSERT_EQUALS(12, tris.size());
+  for (size_t i = 0; i + 2 < tris.size(); i += 3)
+  {
+    const Pt3d &p0(pts[tris[i]]), &p1(pts[tris[i + 1]]), &p2(pts[tris[i + 2]]);
+    TS_ASSERT((p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x) > 0.0);
+  }
+
+  // a fan when one side is a single point
+  tris.clear();
+  polyB = {1};
+  TS_ASSERT(XmUtil::ZipperTriangulate(pts, polyA, polyB, tris));
+  VecInt baseTris = {0, 1, 2, 2, 1, 4};
+  TS_ASSERT_EQUALS_VEC(baseTris, tris);
+
+  // a strip that folds over itself is rejected
+  tris.clear();
+  pts[2] = Pt3d(15, 5);
+  polyB = {1, 3, 5};
+  TS_ASSERT(!XmUtil::ZipperTriangulate(pts, polyA, polyB, tris));
+  TS_ASSERT(tris.empty());
+} // XmUtilUnitTests::test_ZipperTriangulate
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::FloodFillOuterTriangles
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_FloodFillOuterTriangles()
+{
+  //  3-----2
+  //  |\   /|
+  //  | \ / |
+  //  |  4  |
+  //  | / \ |
+  //  |/   \|
+  //  0-----1
+  VecPt3d pts = {{0, 0}, {10, 0}, {10, 10}, {0, 10}, {5, 5}};
+  VecInt tris = {0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
+  VecInt poly = {0, 1, 2, 4, 0};
+  SetInt outside, baseOutside = {2, 3};
+  TS_ASSERT(XmUtil::FloodFillOuterTriangles(pts, tris, poly, outside));
+  TS_ASSERT(baseOutside == outside);
+
+  // clockwise polygons work the same
+  std::reverse(poly.begin(), poly.end());
+  TS_ASSERT(XmUtil::FloodFillOuterTriangles(pts, tris, poly, outside));
+  TS_ASSERT(baseOutside == outside);
+
+  // nothing is outside the whole square
+  poly = {0, 1, 2, 3, 0};
+  TS_ASSERT(XmUtil::FloodFillOuterTriangles(pts, tris, poly, outside));
+  TS_ASSERT(outside.empty());
+
+  // the polygon edge from 1 to 3 is not a triangle edge
+  poly = {0, 1, 3, 0};
+  TS_ASSERT(!XmUtil::FloodFillOuterTriangles(pts, tris, poly, outside));
+} // XmUtilUnitTests::test_FloodFillOuterTriangles
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::WeldPoints
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_WeldPoints()
+{
+  VecPt3d pts = {{0, 0, 1}, {1, 0, 2}, {1 + 1e-8, 0, 3}, {0, 1, 4}, {-1e-8, 1e-8, 5}, {2, 0, 6}};
+  VecInt oldToNew;
+  TS_ASSERT_EQUALS(2, XmUtil::WeldPoints(pts, 1e-6, oldToNew));
+  VecPt3d basePts = {{0, 0, 1}, {1, 0, 2}, {0, 1, 4}, {2, 0, 6}};
+  TS_ASSERT_DELTA_VECPT3D(basePts, pts, 1e-12);
+  VecInt baseOldToNew = {0, 1, 1, 2, 0, 3};
+  TS_ASSERT_EQUALS_VEC(baseOldToNew, oldToNew);
+
+  // nothing within the tolerance
+  pts = basePts;
+  TS_ASSERT_EQUALS(0, XmUtil::WeldPoints(pts, 1e-6, oldToNew));
+  baseOldToNew = {0, 1, 2, 3};
+  TS_ASSERT_EQUALS_VEC(baseOldToNew, oldToNew);
+
+  pts.clear();
+  TS_ASSERT_EQUALS(0, XmUtil::WeldPoints(pts, 1e-6, oldToNew));
+  TS_ASSERT(oldToNew.empty());
+} // XmUtilUnitTests::test_WeldPoints
+//------------------------------------------------------------------------------
+/// \brief Tests XmUtil::StampTinToPoints
+//------------------------------------------------------------------------------
+void XmUtilUnitTests::test_StampTinToPoints()
+{
+  // plane z = x + y over a 10 x 10 square
+  VecPt3d tinPts = {{0, 0, 0}, {10, 0, 10}, {10, 10, 20}, {0, 10, 10}};
+  VecInt tris = {0, 1, 2, 0, 2, 3};
+  const double noData(XM_NODATA);
+  VecPt3d pts = {{1, 2, noData}, {5, 5, 100}, {9, 1, -100}, {20, 5, 7}, {10, 10, noData}};
+  VecPt3d cut(pts), fill(pts), both(pts);
+
+  TS_ASSERT_EQUALS(4, XmUtil::StampTinToPoints(tinPts, tris, 0, cut));
+  VecPt3d baseCut = {{1, 2, 3}, {5, 5, 10}, {9, 1, -100}, {20, 5, 7}, {10, 10, 20}};
+  TS_ASSERT_DELTA_VECPT3D(baseCut, cut, 1e-9);
+
+  TS_ASSERT_EQUALS(4, XmUtil::StampTinToPoints(tinPts, tris, 1, fill));
+  VecPt3d baseFill = {{1, 2, 3}, {5, 5, 100}, {9, 1, 10}, {20, 5, 7}, {10, 10, 20}};
+  TS_ASSERT_DELTA_VECPT3D(baseFill, fill, 1e-9);
+
+  TS_ASSERT_EQUALS(4, XmUtil::StampTinToPoints(tinPts, tris, 2, both));
+  VecPt3d baseBoth = {{1, 2, 3}, {5, 5, 10}, {9, 1, 10}, {20, 5, 7}, {10, 10, 20}};
+  TS_ASSERT_DELTA_VECPT3D(baseBoth, both, 1e-9);
+
+  // many points and triangles in parallel
+  tinPts.clear();
+  tris.clear();
+  for (int j = 0; j <= 40; ++j)
+  {
+    for (int i = 0; i <= 40; ++i)
+      tinPts.push_back(Pt3d(i * 0.25, j * 0.25, (i + j) * 0.25));
+  }
+  for (int j = 0; j < 40; ++j)
+  {
+    for (int i = 0; i < 40; ++i)
+    {
+      int p0 = 41 * j + i, p1 = p0 + 1, p2 = p1 + 41, p3 = p0 + 41;
+      tris.insert(tris.end(), {p0, p1, p2, p0, p2, p3});
+    }
+  }
+  VecPt3d grid;
+  for (int j = 0; j <= 200; ++j)
+  {
+    for (int i = 0; i <= 200; ++i)
+      grid.push_back(Pt3d(i * 0.05, j * 0.05, noData));
+  }
+  XmUtil::SetMaxThreads(4);
+  TS_ASSERT_EQUALS(grid.size(), XmUtil::StampTinToPoints(tinPts, tris, 2, grid));
+  XmUtil::SetMaxThreads(0);
+  for (const auto& p : grid)
+    TS_ASSERT_DELTA(p.x + p.y, p.z, 1e-9);
+} // XmUtilUnitTests::test_StampTinToPoints
 
 #endif
@@ -9,8 +9,11 @@
 //----- Included files ---------------------------------------------------------
 
 // 3. Standard library headers
+#include <cstdint>
+#include <functional>
 
 // 4. External library headers
+#include <xmscore/stl/set.h>
 #include <xmscore/stl/vector.h>
 
 // 5. Shared code headers
@@ -20,11 +23,32 @@ namespace xms
 {
 //----- Forward declarations ---------------------------------------------------
 class XmStampCrossSection;
+class XmStamperIo;
 
 //----- Constants / Enumerations -----------------------------------------------
 
 //----- Structs / Classes ------------------------------------------------------
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Triangles binned in a grid of square cells with about one triangle
+/// per cell. Made by XmUtil::BinTriangles.
+struct XmTriGrid
+{
+  XmTriGrid();
+
+  int Col(double a_x) const;
+  int Row(double a_y) const;
+  void FindTriangles(const Pt3d& a_min, const Pt3d& a_max, VecInt& a_tris) const;
+
+  Pt3d m_min;         ///< min x,y of the triangles
+  Pt3d m_max;         ///< max x,y of the triangles
+  double m_cellSize;  ///< size of the cells
+  int m_nx;           ///< number of columns. 0 if there are no triangles.
+  int m_ny;           ///< number of rows
+  VecInt m_cellStart; ///< start of each cell in m_cellTris (one extra at end)
+  VecInt m_cellTris;  ///< triangles in each cell
+};
+
 //----- Function prototypes ----------------------------------------------------
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -41,12 +65,59 @@ public:
                                   double a_maxX,
                                   double a_angle,
                                   VecPt3d2d& a_3dpts);
+  static void ConvertXsPointsTo3d(const Pt3d& a_cl,
+                                  const VecPt3d& a_pts,
+                                  double a_maxX,
+                                  double a_cos,
+                                  double a_sin,
+                                  VecPt3d2d& a_3dpts);
   static void EnsureVectorAtMaxX(VecPt3d& a_pts, double a_maxX);
   static void GetAnglesFromCenterLine(size_t a_idx,
                                       const VecPt3d& a_cl,
                                       double& a_leftAngle,
                                       double& a_rightAngle);
+  static void GetCenterLineSinCos(const VecPt3d& a_cl,
+                                  size_t a_begin,
+                                  VecDbl& a_leftCos,
+                                  VecDbl& a_leftSin,
+                                  VecDbl& a_rightCos,
+                                  VecDbl& a_rightSin);
   static void ScaleCrossSectionXvals(XmStampCrossSection& a_xs, double a_factor);
+  static int ArcDivisions(double a_degrees, double a_radius, double a_maxChordDeviation);
+  static int SimplifyCenterLine(VecPt3d& a_cl,
+                                std::vector<XmStampCrossSection>& a_cs,
+                                double a_tolerance);
+  static int SimplifyCenterLine(XmStamperIo& a_io);
+  static bool ZipperTriangulate(const VecPt3d& a_pts,
+                                const VecInt& a_polyA,
+                                const VecInt& a_polyB,
+                                VecInt& a_tris);
+  static bool FloodFillOuterTriangles(const VecPt3d& a_pts,
+                                      const VecInt& a_tris,
+                                      const VecInt& a_outerPoly,
+                                      SetInt& a_outside);
+  static bool FloodFillOutsideEdges(const VecInt& a_tris, const VecInt& a_edges, SetInt& a_outside);
+  static int WeldPoints(VecPt3d& a_pts, double a_tol, VecInt& a_oldToNew);
+  static double Cross(const Pt3d& a_p0, const Pt3d& a_p1, const Pt3d& a_p2);
+  static bool SegmentsCross(const Pt3d& a_p0,
+                            const Pt3d& a_p1,
+                            const Pt3d& a_p2,
+                            const Pt3d& a_p3,
+                            bool a_touch = false);
+  static void BinTriangles(const VecPt3d& a_pts, const VecInt& a_tris, XmTriGrid& a_grid);
+  static size_t StampTinToPoints(const VecPt3d& a_tinPts,
+                                 const VecInt& a_tris,
+                                 int a_stampingType,
+                                 VecPt3d& a_pts);
+
+  static uint64_t HilbertIndex(double a_x, double a_y, const Pt3d& a_min, const Pt3d& a_max);
+  static void HilbertOrder(const VecPt3d& a_pts, VecInt& a_order);
+
+  static void SetMaxThreads(int a_maxThreads);
+  static int NumThreads(size_t a_count, size_t a_minPerThread);
+  static void ParallelFor(size_t a_count,
+                          int a_numThreads,
+                          const std::function<void(int, size_t, size_t)>& a_func);
 
   /// \cond
 
@@ -24,6 +24,15 @@ class XmUtilUnitTests : public CxxTest::TestSuite
 {
 public:
   void test_EnsureVectorAtMaxX();
+  void test_ParallelFor();
+  void test_HilbertOrder();
+  void test_ConvertXsPointsTo3dSinCos();
+  void test_ArcDivisions();
+  void test_SimplifyCenterLine();
+  void test_ZipperTriangulate();
+  void test_FloodFillOuterTriangles();
+  void test_WeldPoints();
+  void test_StampTinToPoints();
 }; // XmUtilUnitTests
 
 #endif